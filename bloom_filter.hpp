@@ -0,0 +1,268 @@
+/**
+ * @file bloom_filter.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe bloom_filter
+ *
+ * File di dichiarazione e definizione della classe templata bloom_filter,
+ * un filtro probabilistico usato da set per rispondere velocemente alle ricerche di elementi assenti.
+ */
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP
+
+#include <cstdint>   // std::uint64_t, std::uint32_t
+#include <cmath>     // std::log, std::ceil
+#include <stdexcept> // std::invalid_argument
+#include <algorithm> // swap
+#include "hashing.hpp"
+
+/**
+ * @brief classe bloom_filter che rappresenta un filtro di Bloom a blocchi
+ *
+ * Il filtro risponde alla domanda "l'elemento potrebbe essere presente?":
+ * - se risponde false, l'elemento sicuramente non è stato aggiunto
+ * - se risponde true, l'elemento è stato aggiunto oppure si tratta di un falso positivo
+ *
+ * È templata su due tipi:
+ * - T: tipo degli elementi
+ * - Hash: funtore che prende in input un oggetto di tipo T e ritorna un valore di hash.
+ *   Deve essere coerente con il funtore di confronto del set: elementi equivalenti devono avere lo stesso hash
+ *
+ * Il filtro è diviso in blocchi da 512 bit (una linea di cache): tutti i bit di un elemento
+ * cadono nello stesso blocco, quindi ogni ricerca legge una sola linea di cache.
+ * Il numero di bit e di funzioni di hash è calcolato a partire dal numero di elementi previsto
+ * e dalla probabilità di falso positivo desiderata.
+ */
+template <typename T, typename Hash>
+class bloom_filter
+{
+private:
+    static const unsigned int WORDS_PER_BLOCK = 8; ///< parole da 64 bit in un blocco
+    static const unsigned int BITS_PER_BLOCK = 512; ///< bit in un blocco
+
+    std::uint64_t *_bits;  ///< puntatore all'array di bit, _blocks * WORDS_PER_BLOCK parole
+    unsigned int _blocks;  ///< numero di blocchi
+    unsigned int _hashes;  ///< numero di bit impostati per ogni elemento
+    unsigned int _capacity; ///< numero di elementi previsto
+    double _fp_rate;       ///< probabilità di falso positivo desiderata
+
+    Hash _hash; ///< istanza del funtore di hash
+
+public:
+    /**
+     * @brief costruttore a partire dai parametri del filtro
+     *
+     * Crea un filtro vuoto dimensionato per contenere capacity elementi
+     * con una probabilità di falso positivo pari a circa fp_rate.
+     * Dato che i bit sono concentrati in un blocco, la dimensione teorica viene aumentata di un quinto
+     * per compensare la maggiore probabilità di collisione.
+     *
+     * @param capacity numero di elementi previsto
+     * @param fp_rate probabilità di falso positivo desiderata
+     *
+     * @pre 0 < fp_rate < 1
+     *
+     * @post _capacity == max(capacity, 1)
+     * @post possibly_contains(e) == false per ogni e
+     *
+     * @throws std::invalid_argument se fp_rate non è compreso tra 0 e 1
+     * @throws std::bad_alloc se l'allocazione dell'array di bit fallisce
+     */
+    bloom_filter(unsigned int capacity, double fp_rate)
+        : _bits(nullptr), _blocks(0), _hashes(0), _capacity(capacity > 0 ? capacity : 1), _fp_rate(fp_rate)
+    {
+        if (!(fp_rate > 0.0 && fp_rate < 1.0))
+        {
+            throw std::invalid_argument("False positive rate must be between 0 and 1!");
+        }
+
+        const double ln2 = std::log(2.0);
+        double bits = -static_cast<double>(_capacity) * std::log(fp_rate) / (ln2 * ln2) * 1.2;
+
+        _blocks = static_cast<unsigned int>(std::ceil(bits / BITS_PER_BLOCK));
+        if (_blocks == 0)
+        {
+            _blocks = 1;
+        }
+
+        _hashes = static_cast<unsigned int>(bits / _capacity * ln2 + 0.5);
+        if (_hashes == 0)
+        {
+            _hashes = 1;
+        }
+        if (_hashes > 16)
+        {
+            _hashes = 16;
+        }
+
+        _bits = new std::uint64_t[_blocks * WORDS_PER_BLOCK]();
+    }
+
+    /**
+     * @brief costruttore di copia
+     *
+     * Crea una copia esatta del filtro passato come parametro.
+     *
+     * @param other filtro da copiare
+     *
+     * @post _bits != other._bits
+     * @post _bits[i] == other._bits[i] per ogni parola
+     *
+     * @throws std::bad_alloc se l'allocazione dell'array di bit fallisce
+     */
+    bloom_filter(const bloom_filter &other)
+        : _bits(nullptr), _blocks(other._blocks), _hashes(other._hashes), _capacity(other._capacity), _fp_rate(other._fp_rate)
+    {
+        _bits = new std::uint64_t[_blocks * WORDS_PER_BLOCK];
+        std::copy(other._bits, other._bits + _blocks * WORDS_PER_BLOCK, _bits);
+    }
+
+    /**
+     * @brief operatore di assegnamento
+     *
+     * In caso di errore l'operazione viene annullata.
+     *
+     * @param rhs filtro da copiare
+     *
+     * @return reference al filtro modificato
+     *
+     * @throws std::bad_alloc se lanciata dal costruttore di copia
+     */
+    bloom_filter &operator=(const bloom_filter &rhs)
+    {
+        if (this != &rhs)
+        {
+            bloom_filter tmp(rhs);
+
+            std::swap(_bits, tmp._bits);
+            std::swap(_blocks, tmp._blocks);
+            std::swap(_hashes, tmp._hashes);
+            std::swap(_capacity, tmp._capacity);
+            std::swap(_fp_rate, tmp._fp_rate);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Libera la memoria occupata dall'array di bit.
+     */
+    ~bloom_filter()
+    {
+        delete[] _bits;
+        _bits = nullptr;
+    }
+
+    /**
+     * @brief aggiunge un elemento al filtro
+     *
+     * Imposta i bit corrispondenti all'elemento.
+     *
+     * @param element elemento da aggiungere
+     *
+     * @post possibly_contains(element) == true
+     *
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    void add(const T &element)
+    {
+        std::uint64_t h = hash_mix(static_cast<std::uint64_t>(_hash(element)));
+        std::uint64_t *block = _bits + block_of(h) * WORDS_PER_BLOCK;
+
+        std::uint32_t h1 = static_cast<std::uint32_t>(h);
+        std::uint32_t h2 = static_cast<std::uint32_t>(hash_mix(h)) | 1;
+
+        for (unsigned int i = 0; i < _hashes; ++i)
+        {
+            unsigned int bit = (h1 + i * h2) % BITS_PER_BLOCK;
+            block[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+    }
+
+    /**
+     * @brief ricerca probabilistica di un elemento
+     *
+     * Controlla se tutti i bit corrispondenti all'elemento sono impostati.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     *
+     * @return false se l'elemento sicuramente non è stato aggiunto, true se potrebbe esserlo
+     *
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    bool possibly_contains(const T &element) const
+    {
+        std::uint64_t h = hash_mix(static_cast<std::uint64_t>(_hash(element)));
+        const std::uint64_t *block = _bits + block_of(h) * WORDS_PER_BLOCK;
+
+        std::uint32_t h1 = static_cast<std::uint32_t>(h);
+        std::uint32_t h2 = static_cast<std::uint32_t>(hash_mix(h)) | 1;
+
+        for (unsigned int i = 0; i < _hashes; ++i)
+        {
+            unsigned int bit = (h1 + i * h2) % BITS_PER_BLOCK;
+            if ((block[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief numero di elementi previsto
+     *
+     * Oltre questo numero di elementi la probabilità di falso positivo supera quella richiesta.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return numero di elementi per cui è stato dimensionato il filtro
+     */
+    unsigned int capacity() const
+    {
+        return _capacity;
+    }
+
+    /**
+     * @brief probabilità di falso positivo richiesta
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return la probabilità di falso positivo con cui è stato creato il filtro
+     */
+    double fp_rate() const
+    {
+        return _fp_rate;
+    }
+
+    /**
+     * @brief dimensione in byte dell'array di bit
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return numero di byte occupati dall'array di bit
+     */
+    unsigned int bytes() const
+    {
+        return _blocks * WORDS_PER_BLOCK * sizeof(std::uint64_t);
+    }
+
+private:
+    /**
+     * @brief blocco corrispondente a un valore di hash
+     *
+     * Usa i 32 bit alti del valore di hash, ridotti all'intervallo [0, _blocks) con una moltiplicazione.
+     *
+     * @param h valore di hash rimescolato
+     *
+     * @return indice del blocco
+     */
+    unsigned int block_of(std::uint64_t h) const
+    {
+        return static_cast<unsigned int>(((h >> 32) * _blocks) >> 32);
+    }
+}; // bloom_filter
+
+#endif
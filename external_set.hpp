@@ -0,0 +1,1041 @@
+/**
+ * @file external_set.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe external_set
+ *
+ * File di dichiarazione e definizione della classe templata external_set,
+ * un insieme che mantiene su disco la maggior parte degli elementi e può quindi superare la memoria disponibile.
+ */
+#ifndef EXTERNAL_SET_HPP
+#define EXTERNAL_SET_HPP
+
+#include <algorithm>  // std::sort, std::upper_bound, std::find
+#include <atomic>     // std::atomic
+#include <cstddef>    // std::size_t, std::ptrdiff_t
+#include <cstdio>     // std::remove
+#include <exception>  // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <filesystem> // std::filesystem::create_directories, std::filesystem::path
+#include <fstream>    // ifstream
+#include <functional> // std::less
+#include <future>     // std::future, std::async
+#include <iterator>   // std::input_iterator_tag
+#include <memory>     // std::shared_ptr, std::unique_ptr, std::make_shared
+#include <mutex>      // std::mutex, std::unique_lock
+#include <stdexcept>  // std::runtime_error, std::invalid_argument
+#include <string>     // std::string, std::to_string
+#include <vector>     // std::vector
+#include <unistd.h>   // getpid
+#include "set.hpp"
+#include "sorted_run.hpp"
+
+/**
+ * @brief classe external_set che rappresenta un insieme in memoria esterna
+ *
+ * Gli elementi aggiunti vengono raccolti in un set in memoria (il buffer). Quando la memoria occupata dal buffer
+ * raggiunge il budget indicato, gli elementi vengono ordinati e scritti su disco in un file detto run,
+ * e il buffer viene svuotato. Le run sono organizzate per livelli come in un LSM-tree:
+ * le run scritte dal buffer sono di livello 0 e, quando un livello contiene FANOUT run,
+ * un thread in background le fonde in una sola run del livello successivo eliminando i duplicati.
+ * Il numero di run cresce quindi con il logaritmo del numero di elementi.
+ *
+ * Ogni run ha il formato di save (con la lunghezza allineata a destra nella prima riga), quindi può essere letta
+ * con load o set_reader. In memoria di ogni run restano solo:
+ * - un indice a recinti (fence index): un elemento ogni FENCE_STEP con la sua posizione nel file,
+ *   che permette a contains di leggere un solo blocco di FENCE_STEP elementi
+ * - un filtro di Bloom sugli elementi, se è disponibile un funtore di hash, che evita la lettura
+ *   del blocco per quasi tutti gli elementi assenti dalla run
+ *
+ * L'iterazione è una fusione a k vie in streaming di buffer e run: restituisce gli elementi in ordine crescente
+ * e senza duplicati, tenendo in memoria un solo elemento per run. Con lo stesso meccanismo
+ * unite e intersect calcolano unione e intersezione di due external_set scrivendo direttamente una nuova run.
+ *
+ * È templata su tre tipi:
+ * - T: tipo degli elementi, con operatori di stampa e lettura da stream e costruttore di default
+ * - Less: funtore di ordinamento stretto; due elementi sono uguali se nessuno dei due precede l'altro
+ * - Hash: funtore di hash coerente con Less, facoltativo; se presente il buffer usa l'indice hash di set
+ *   e le run hanno un filtro di Bloom, altrimenti l'aggiunta al buffer costa O(n)
+ *
+ * Le run vengono create nella directory indicata, con nomi unici per ogni external_set del processo,
+ * e vengono cancellate quando non servono più: dopo una fusione e alla distruzione dell'external_set.
+ * Le operazioni sull'external_set non vanno chiamate contemporaneamente da più thread;
+ * le fusioni in background sono sincronizzate internamente.
+ * Non è possibile rimuovere elementi. L'external_set non può essere copiato.
+ */
+template <typename T, typename Less = std::less<T>, typename Hash = no_hash>
+class external_set
+{
+public:
+    static const unsigned int FENCE_STEP = 64; ///< elementi tra due recinti consecutivi di una run
+    static const unsigned int FANOUT = 4;      ///< run dello stesso livello che vengono fuse insieme
+
+    /**
+     * @brief funtore di uguaglianza derivato da Less
+     *
+     * Due elementi sono uguali se nessuno dei due precede l'altro.
+     */
+    struct equivalent
+    {
+        /**
+         * @brief operatore () di confronto
+         *
+         * @param a primo elemento
+         * @param b secondo elemento
+         *
+         * @return true se a e b sono equivalenti per Less, false altrimenti
+         */
+        bool operator()(const T &a, const T &b) const
+        {
+            Less less;
+            return !less(a, b) && !less(b, a);
+        }
+    };
+
+private:
+    /**
+     * @brief run su disco
+     *
+     * Contiene il nome del file e le strutture di ricerca in memoria.
+     * Il file viene cancellato alla distruzione: le run sono condivise con shared_ptr tra l'external_set,
+     * le fusioni in corso e gli iteratori, quindi il file resta finché qualcuno lo sta leggendo.
+     */
+    struct run
+    {
+        std::string path;                              ///< nome del file
+        unsigned int size = 0;                         ///< numero di elementi
+        unsigned int level = 0;                        ///< livello della run
+        std::vector<T> fences;                         ///< fences[k] è l'elemento in posizione k * FENCE_STEP
+        std::vector<std::streamoff> offsets;           ///< offsets[k] è la posizione nel file di fences[k]
+        T last{};                                      ///< ultimo elemento, il maggiore
+        std::unique_ptr<bloom_filter<T, Hash>> filter; ///< filtro di Bloom sugli elementi, nullptr senza funtore di hash
+        std::mutex lookup_mutex;                       ///< mutex a protezione di lookup
+        std::ifstream lookup;                          ///< stream usato da contains, aperto alla prima ricerca
+
+        /**
+         * @brief metodo distruttore
+         *
+         * Chiude lo stream e cancella il file.
+         */
+        ~run()
+        {
+            lookup.close();
+            std::remove(path.c_str());
+        }
+    };
+
+    /**
+     * @brief scrittura di una run
+     *
+     * Scrive gli elementi, che devono arrivare in ordine crescente e senza duplicati,
+     * e costruisce recinti e filtro. Se la scrittura non viene completata con finish il file viene cancellato.
+     */
+    class run_writer
+    {
+    private:
+        std::shared_ptr<run> _run;                    ///< run in costruzione
+        sorted_run_detail::sorted_writer<T> _writer; ///< scrittura del file
+
+        /**
+         * @brief crea la descrizione di una run vuota
+         *
+         * @param path nome del file
+         * @param level livello della run
+         *
+         * @return la run, che cancellerà il file alla distruzione
+         *
+         * @throws std::bad_alloc se l'allocazione della run fallisce
+         */
+        static std::shared_ptr<run> empty_run(const std::string &path, unsigned int level)
+        {
+            std::shared_ptr<run> r = std::make_shared<run>();
+            r->path = path;
+            r->level = level;
+            return r;
+        }
+
+    public:
+        /**
+         * @brief costruttore
+         *
+         * Crea il file e scrive una prima riga vuota, riempita con la lunghezza da finish.
+         *
+         * @param path nome del file
+         * @param expected numero massimo di elementi, per dimensionare il filtro
+         * @param level livello della run
+         * @param fp_rate probabilità di falso positivo del filtro
+         *
+         * @throw std::runtime_error se il file non viene aperto
+         * @throws std::bad_alloc se l'allocazione della run o del filtro fallisce
+         */
+        run_writer(const std::string &path, unsigned long long expected, unsigned int level, double fp_rate)
+            : _run(empty_run(path, level)), _writer(path)
+        {
+            if constexpr (is_hash_enabled<Hash>::value)
+            {
+                const unsigned int capacity = expected > 0xFFFFFFFFull ? 0xFFFFFFFFu : static_cast<unsigned int>(expected);
+                _run->filter.reset(new bloom_filter<T, Hash>(capacity < 16 ? 16 : capacity, fp_rate));
+            }
+            else
+            {
+                (void)expected;
+                (void)fp_rate;
+            }
+        }
+
+        /**
+         * @brief aggiunge un elemento in coda alla run
+         *
+         * @param element elemento da scrivere, maggiore di tutti quelli già scritti
+         *
+         * @throws std::bad_alloc se l'allocazione dei recinti fallisce
+         * @throws ... eventuali eccezioni lanciate da Hash o dal costruttore di copia di T
+         */
+        void push(const T &element)
+        {
+            if (_run->size % FENCE_STEP == 0)
+            {
+                _run->fences.push_back(element);
+                _run->offsets.push_back(_writer.position());
+            }
+
+            _writer.push(element);
+
+            if constexpr (is_hash_enabled<Hash>::value)
+            {
+                _run->filter->add(element);
+            }
+
+            _run->last = element;
+            ++_run->size;
+        }
+
+        /**
+         * @brief completa la run
+         *
+         * Scrive la lunghezza nella prima riga e chiude il file.
+         *
+         * @return la run scritta
+         *
+         * @throw std::runtime_error se il file non viene scritto
+         */
+        std::shared_ptr<run> finish()
+        {
+            _writer.finish();
+            return _run;
+        }
+    }; // run_writer
+
+    /**
+     * @brief lettura sequenziale di una sorgente ordinata
+     *
+     * La sorgente è una run, letta con file_cursor, oppure una copia ordinata del buffer.
+     */
+    class cursor
+    {
+    private:
+        std::shared_ptr<run> _run;                                 ///< run letta, nullptr per il buffer
+        std::unique_ptr<sorted_run_detail::file_cursor<T>> _file; ///< lettura della run
+        std::shared_ptr<const std::vector<T>> _memory;             ///< copia ordinata del buffer, nullptr per una run
+        std::size_t _pos;                                          ///< posizione nella copia del buffer
+
+    public:
+        /**
+         * @brief costruttore per una run
+         *
+         * @param r run da leggere
+         *
+         * @throw std::runtime_error se il file della run non può essere letto
+         */
+        explicit cursor(std::shared_ptr<run> r) : _run(r), _file(new sorted_run_detail::file_cursor<T>(r->path)), _pos(0) {}
+
+        /**
+         * @brief costruttore per una copia del buffer
+         *
+         * @param memory elementi ordinati
+         */
+        explicit cursor(std::shared_ptr<const std::vector<T>> memory) : _memory(memory), _pos(0) {}
+
+        /**
+         * @brief verifica se ci sono altri elementi
+         *
+         * @return true se current() è valido
+         */
+        bool valid() const
+        {
+            return _memory ? _pos < _memory->size() : _file->valid();
+        }
+
+        /**
+         * @brief elemento corrente
+         *
+         * @pre valid() == true
+         *
+         * @return l'elemento corrente
+         */
+        const T &current() const
+        {
+            return _memory ? (*_memory)[_pos] : _file->current();
+        }
+
+        /**
+         * @brief passa all'elemento successivo
+         *
+         * @throw std::runtime_error se il file della run è troncato
+         */
+        void next()
+        {
+            if (_memory)
+            {
+                ++_pos;
+            }
+            else
+            {
+                _file->next();
+            }
+        }
+    }; // cursor
+
+    typedef sorted_run_detail::sorted_merge<T, Less, cursor> merger; ///< fusione a k vie di buffer e run
+
+    std::string _directory;  ///< directory delle run
+    std::size_t _budget;     ///< byte di memoria oltre i quali il buffer viene scritto su disco
+    double _fp_rate;         ///< probabilità di falso positivo dei filtri delle run
+    unsigned long long _id;  ///< identificativo dell'external_set nel processo, usato nei nomi delle run
+    std::atomic<unsigned int> _next_run; ///< numero della prossima run, usato nel nome del file
+
+    set<T, equivalent, Hash> _buffer; ///< elementi non ancora scritti su disco
+    std::size_t _buffer_bytes;        ///< memoria stimata del buffer
+
+    std::vector<std::shared_ptr<run>> _runs; ///< run su disco, dalla più vecchia alla più recente
+    mutable std::mutex _mutex;               ///< mutex a protezione di _runs, _merging e _error
+    bool _merging;                           ///< true se il thread di fusione è attivo
+    std::exception_ptr _error;               ///< errore dell'ultima fusione, non ancora riportato
+    std::future<void> _merge;                ///< thread di fusione
+
+    Less _less; ///< istanza del funtore di ordinamento
+
+    inline static std::atomic<unsigned long long> _instances{0}; ///< numero di external_set creati nel processo
+
+public:
+    /**
+     * @brief costruttore
+     *
+     * Crea un external_set vuoto, creando la directory se non esiste.
+     *
+     * @param directory directory in cui scrivere le run
+     * @param budget byte di memoria del buffer oltre i quali gli elementi vengono scritti su disco,
+     *        stimati come sizeof(T) più la memoria posseduta secondo heap_bytes
+     * @param fp_rate probabilità di falso positivo dei filtri delle run
+     *
+     * @throw std::runtime_error se la directory non può essere creata
+     * @throws std::invalid_argument se budget è 0 o fp_rate non è compreso tra 0 e 1
+     */
+    explicit external_set(const std::string &directory, std::size_t budget = 1 << 24, double fp_rate = 0.01)
+        : _directory(directory), _budget(budget), _fp_rate(fp_rate), _id(_instances.fetch_add(1)), _next_run(0),
+          _buffer_bytes(0), _merging(false)
+    {
+        if (budget == 0)
+        {
+            throw std::invalid_argument("Memory budget must be positive!");
+        }
+        if (!(fp_rate > 0.0 && fp_rate < 1.0))
+        {
+            throw std::invalid_argument("False positive rate must be between 0 and 1!");
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            throw std::runtime_error("Directory can't be created!");
+        }
+    }
+
+    external_set(const external_set &other) = delete;
+    external_set &operator=(const external_set &other) = delete;
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Attende la fine della fusione in corso e cancella le run non più lette da iteratori.
+     */
+    ~external_set()
+    {
+        if (_merge.valid())
+        {
+            _merge.wait();
+        }
+    }
+
+    /**
+     * @brief aggiunge un elemento
+     *
+     * Aggiunge l'elemento al buffer, se non vi è già presente; l'elemento non viene cercato nelle run,
+     * i duplicati vengono eliminati dalle fusioni e dall'iterazione.
+     * Se il buffer raggiunge il budget viene scritto su disco come con flush.
+     *
+     * @param element elemento da aggiungere
+     *
+     * @throw std::runtime_error se la run non può essere scritta
+     * @throws std::bad_alloc se l'allocazione del buffer fallisce
+     * @throws std::system_error se la creazione del thread di fusione fallisce
+     * @throws ... eventuali eccezioni lanciate da Less, Hash o dal costruttore di copia di T
+     */
+    void add(const T &element)
+    {
+        if (_buffer.size() == _buffer.capacity())
+        {
+            // il buffer cresce per raddoppi fino al numero di elementi del budget
+            const std::size_t limit = _budget / sizeof(T) + 1;
+            const std::size_t wanted = 2 * static_cast<std::size_t>(_buffer.capacity()) + 16;
+            _buffer.reserve(static_cast<unsigned int>(wanted < limit ? wanted : limit));
+        }
+
+        const unsigned int before = _buffer.size();
+        _buffer.add(element);
+        if (_buffer.size() != before)
+        {
+            _buffer_bytes += sizeof(T) + heap_bytes<T>()(element);
+        }
+
+        if (_buffer_bytes >= _budget)
+        {
+            flush();
+        }
+    }
+
+    /**
+     * @brief verifica se un elemento è presente
+     *
+     * Cerca l'elemento nel buffer e poi nelle run, dalla più recente. In ogni run vengono scartati senza leggere il file
+     * gli elementi fuori dall'intervallo della run e quelli esclusi dal filtro di Bloom;
+     * altrimenti i recinti indicano l'unico blocco di al più FENCE_STEP elementi da leggere.
+     *
+     * @param element elemento da cercare
+     *
+     * @return true se l'elemento è presente, false altrimenti
+     *
+     * @throw std::runtime_error se il file di una run non può essere letto
+     * @throws ... eventuali eccezioni lanciate da Less o da Hash
+     */
+    bool contains(const T &element) const
+    {
+        if (_buffer.contains(element))
+        {
+            return true;
+        }
+
+        const std::vector<std::shared_ptr<run>> runs = snapshot();
+        for (auto it = runs.rbegin(); it != runs.rend(); ++it)
+        {
+            if (run_contains(**it, element))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief scrive il buffer su disco
+     *
+     * Ordina gli elementi del buffer, li scrive in una nuova run di livello 0 e svuota il buffer.
+     * Se un livello raggiunge FANOUT run, avvia la fusione in background.
+     * In caso di errore nella scrittura il buffer rimane invariato.
+     *
+     * @throw std::runtime_error se la run non può essere scritta
+     * @throws std::bad_alloc se l'allocazione della copia ordinata fallisce
+     * @throws std::system_error se la creazione del thread di fusione fallisce
+     */
+    void flush()
+    {
+        if (_buffer.size() == 0)
+        {
+            return;
+        }
+
+        std::vector<T> sorted(_buffer.begin(), _buffer.end());
+        std::sort(sorted.begin(), sorted.end(), _less);
+
+        run_writer writer(next_path(), sorted.size(), 0, _fp_rate);
+        for (const T &element : sorted)
+        {
+            writer.push(element);
+        }
+        adopt(writer.finish());
+
+        _buffer = set<T, equivalent, Hash>();
+        _buffer_bytes = 0;
+    }
+
+    /**
+     * @brief attende le fusioni in background
+     *
+     * Ritorna quando non ci sono più fusioni in corso né livelli da fondere.
+     *
+     * @throw std::runtime_error se una fusione non è riuscita; le run da fondere restano invariate
+     */
+    void wait()
+    {
+        if (_merge.valid())
+        {
+            _merge.wait();
+        }
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            std::swap(error, _error);
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief numero di run su disco
+     *
+     * @return numero di run attuali
+     */
+    unsigned int runs() const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return static_cast<unsigned int>(_runs.size());
+    }
+
+    /**
+     * @brief numero di elementi nel buffer
+     *
+     * @return numero di elementi non ancora scritti su disco
+     */
+    unsigned int buffered() const
+    {
+        return _buffer.size();
+    }
+
+    /**
+     * @brief iteratore di input della classe external_set
+     *
+     * Percorre in ordine crescente e senza duplicati gli elementi presenti alla chiamata di begin,
+     * leggendo le run in streaming. Le copie di un iteratore condividono la posizione.
+     * Aggiunte e fusioni successive non influenzano un'iterazione già iniziata.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief costruttore di default
+         *
+         * Crea un iteratore di fine sequenza.
+         */
+        const_iterator() {}
+
+        /**
+         * @brief operatore di dereferenziamento
+         *
+         * @pre l'iteratore non è di fine sequenza
+         *
+         * @return l'elemento corrente
+         */
+        reference operator*() const
+        {
+            return _merger->current();
+        }
+
+        /**
+         * @brief operatore freccia
+         *
+         * @pre l'iteratore non è di fine sequenza
+         *
+         * @return il puntatore all'elemento corrente
+         */
+        pointer operator->() const
+        {
+            return &_merger->current();
+        }
+
+        /**
+         * @brief operatore di pre-incremento
+         *
+         * @return l'iteratore aggiornato
+         *
+         * @throw std::runtime_error se il file di una run è troncato
+         */
+        const_iterator &operator++()
+        {
+            _merger->advance();
+            return *this;
+        }
+
+        /**
+         * @brief operatore di uguaglianza
+         *
+         * Due iteratori sono uguali se sono entrambi di fine sequenza o se condividono la stessa iterazione non esaurita.
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori sono uguali
+         */
+        bool operator==(const const_iterator &other) const
+        {
+            return at_end() ? other.at_end() : (!other.at_end() && _merger == other._merger);
+        }
+
+        /**
+         * @brief operatore di disuguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori non sono uguali
+         */
+        bool operator!=(const const_iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        std::shared_ptr<merger> _merger; ///< fusione in corso, nullptr per l'iteratore di fine sequenza
+
+        friend class external_set;
+
+        /**
+         * @brief costruttore privato
+         *
+         * @param m fusione da percorrere
+         */
+        explicit const_iterator(std::shared_ptr<merger> m) : _merger(m) {}
+
+        /**
+         * @brief verifica se l'iteratore è di fine sequenza
+         *
+         * @return true se non ci sono altri elementi da restituire
+         */
+        bool at_end() const
+        {
+            return _merger == nullptr || !_merger->valid();
+        }
+    }; // const_iterator
+
+    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * Ogni chiamata inizia una nuova iterazione sugli elementi attuali.
+     *
+     * @return l'iteratore sul minore degli elementi
+     *
+     * @throw std::runtime_error se il file di una run non può essere letto
+     * @throws std::bad_alloc se l'allocazione della copia ordinata del buffer fallisce
+     */
+    const_iterator begin() const
+    {
+        return const_iterator(open());
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * @return l'iteratore di fine sequenza
+     */
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+
+    /**
+     * @brief unione di due external_set
+     *
+     * Fonde in streaming gli elementi di a e b e li scrive in un'unica nuova run di result,
+     * senza caricarli in memoria. Gli elementi già presenti in result restano.
+     *
+     * @param a primo external_set
+     * @param b secondo external_set
+     * @param result external_set a cui aggiungere l'unione
+     *
+     * @throw std::runtime_error se una run non può essere letta o scritta
+     * @throws std::bad_alloc se l'allocazione delle strutture di lettura fallisce
+     * @throws ... eventuali eccezioni lanciate da Less, Hash o dal costruttore di copia di T
+     */
+    static void unite(const external_set &a, const external_set &b, external_set &result)
+    {
+        combine(a, b, result, true);
+    }
+
+    /**
+     * @brief intersezione di due external_set
+     *
+     * Fonde in streaming gli elementi di a e b e scrive quelli comuni in un'unica nuova run di result,
+     * senza caricarli in memoria. Gli elementi già presenti in result restano.
+     *
+     * @param a primo external_set
+     * @param b secondo external_set
+     * @param result external_set a cui aggiungere l'intersezione
+     *
+     * @throw std::runtime_error se una run non può essere letta o scritta
+     * @throws std::bad_alloc se l'allocazione delle strutture di lettura fallisce
+     * @throws ... eventuali eccezioni lanciate da Less, Hash o dal costruttore di copia di T
+     */
+    static void intersect(const external_set &a, const external_set &b, external_set &result)
+    {
+        combine(a, b, result, false);
+    }
+
+private:
+    /**
+     * @brief nome del file della prossima run
+     *
+     * Il nome contiene il pid, così che processi diversi che usano la stessa directory non si sovrascrivano le run.
+     *
+     * @return percorso di un file non ancora usato da questo external_set
+     */
+    std::string next_path()
+    {
+        const std::string name = "ext_" + std::to_string(getpid()) + "_" + std::to_string(_id) + "_" +
+                                 std::to_string(_next_run.fetch_add(1)) + ".run";
+        return (std::filesystem::path(_directory) / name).string();
+    }
+
+    /**
+     * @brief copia dell'elenco delle run
+     *
+     * @return le run attuali, che restano leggibili anche se nel frattempo vengono fuse
+     */
+    std::vector<std::shared_ptr<run>> snapshot() const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _runs;
+    }
+
+    /**
+     * @brief numero massimo di elementi
+     *
+     * @return somma degli elementi di buffer e run, duplicati compresi
+     */
+    unsigned long long upper_bound() const
+    {
+        unsigned long long total = _buffer.size();
+        for (const std::shared_ptr<run> &r : snapshot())
+        {
+            total += r->size;
+        }
+        return total;
+    }
+
+    /**
+     * @brief livello massimo delle run
+     *
+     * @return il livello più alto tra le run attuali, 0 se non ci sono run
+     */
+    unsigned int top_level() const
+    {
+        unsigned int level = 0;
+        for (const std::shared_ptr<run> &r : snapshot())
+        {
+            level = r->level > level ? r->level : level;
+        }
+        return level;
+    }
+
+    /**
+     * @brief inizia una fusione a k vie di buffer e run
+     *
+     * @return la fusione posizionata sul primo elemento
+     *
+     * @throw std::runtime_error se il file di una run non può essere letto
+     * @throws std::bad_alloc se l'allocazione della copia ordinata del buffer fallisce
+     */
+    std::shared_ptr<merger> open() const
+    {
+        std::shared_ptr<std::vector<T>> memory = std::make_shared<std::vector<T>>(_buffer.begin(), _buffer.end());
+        std::sort(memory->begin(), memory->end(), _less);
+
+        std::vector<cursor> cursors;
+        cursors.emplace_back(std::shared_ptr<const std::vector<T>>(memory));
+        for (const std::shared_ptr<run> &r : snapshot())
+        {
+            cursors.emplace_back(r);
+        }
+
+        return std::make_shared<merger>(std::move(cursors));
+    }
+
+    /**
+     * @brief cerca un elemento in una run
+     *
+     * @param r run in cui cercare
+     * @param element elemento da cercare
+     *
+     * @return true se l'elemento è nella run, false altrimenti
+     *
+     * @throw std::runtime_error se il file della run non può essere letto
+     */
+    bool run_contains(run &r, const T &element) const
+    {
+        if (r.size == 0 || _less(element, r.fences.front()) || _less(r.last, element))
+        {
+            return false;
+        }
+
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (!r.filter->possibly_contains(element))
+            {
+                return false;
+            }
+        }
+
+        // l'ultimo recinto non maggiore dell'elemento indica il blocco che può contenerlo
+        const std::size_t block = std::upper_bound(r.fences.begin(), r.fences.end(), element, _less) - r.fences.begin() - 1;
+        const unsigned int first = static_cast<unsigned int>(block) * FENCE_STEP;
+        const unsigned int count = r.size - first < FENCE_STEP ? r.size - first : FENCE_STEP;
+
+        std::unique_lock<std::mutex> lock(r.lookup_mutex);
+        if (!r.lookup.is_open())
+        {
+            r.lookup.open(r.path);
+            if (!r.lookup.is_open())
+            {
+                throw std::runtime_error("File can't be opened!");
+            }
+        }
+        r.lookup.clear();
+        r.lookup.seekg(r.offsets[block]);
+
+        T value;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (!(r.lookup >> value))
+            {
+                throw std::runtime_error("Corrupted file!");
+            }
+
+            if (!_less(value, element))
+            {
+                return !_less(element, value);
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief aggiunge una run e avvia le fusioni necessarie
+     *
+     * @param r run da aggiungere
+     *
+     * @throws std::system_error se la creazione del thread di fusione fallisce
+     */
+    void adopt(std::shared_ptr<run> r)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _runs.push_back(r);
+            if (_merging || !pick_locked(nullptr, nullptr))
+            {
+                return;
+            }
+            _merging = true;
+        }
+
+        // il ciclo di fusione precedente ha già terminato, perché _merging era false
+        if (_merge.valid())
+        {
+            _merge.wait();
+        }
+
+        try
+        {
+            _merge = std::async(std::launch::async, [this]() { merge_loop(); });
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _merging = false;
+            throw;
+        }
+    }
+
+    /**
+     * @brief sceglie le run da fondere
+     *
+     * Cerca il livello più basso con almeno FANOUT run e ne sceglie le FANOUT più vecchie.
+     * Va chiamato con _mutex acquisito.
+     *
+     * @param inputs vettore in cui mettere le run scelte, nullptr per verificare soltanto
+     * @param level variabile in cui scrivere il livello delle run scelte, nullptr per verificare soltanto
+     *
+     * @return true se c'è un livello da fondere, false altrimenti
+     */
+    bool pick_locked(std::vector<std::shared_ptr<run>> *inputs, unsigned int *level) const
+    {
+        std::vector<unsigned int> counts;
+        for (const std::shared_ptr<run> &r : _runs)
+        {
+            if (r->level >= counts.size())
+            {
+                counts.resize(r->level + 1, 0);
+            }
+            ++counts[r->level];
+        }
+
+        for (unsigned int l = 0; l < counts.size(); ++l)
+        {
+            if (counts[l] < FANOUT)
+            {
+                continue;
+            }
+
+            if (inputs != nullptr)
+            {
+                for (const std::shared_ptr<run> &r : _runs)
+                {
+                    if (r->level == l && inputs->size() < FANOUT)
+                    {
+                        inputs->push_back(r);
+                    }
+                }
+                *level = l;
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief ciclo del thread di fusione
+     *
+     * Fonde gruppi di FANOUT run dello stesso livello finché nessun livello ne ha abbastanza.
+     * La fusione legge e scrive i file senza tenere _mutex, quindi contains e l'iterazione proseguono
+     * sulle run originali; al termine la nuova run le sostituisce nell'elenco.
+     * In caso di errore le run originali restano e l'errore viene riportato da wait.
+     */
+    void merge_loop()
+    {
+        while (true)
+        {
+            std::vector<std::shared_ptr<run>> inputs;
+            unsigned int level = 0;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (!pick_locked(&inputs, &level))
+                {
+                    _merging = false;
+                    return;
+                }
+            }
+
+            std::shared_ptr<run> output;
+            try
+            {
+                unsigned long long expected = 0;
+                std::vector<cursor> cursors;
+                for (const std::shared_ptr<run> &r : inputs)
+                {
+                    expected += r->size;
+                    cursors.emplace_back(r);
+                }
+
+                merger m(std::move(cursors));
+                run_writer writer(next_path(), expected, level + 1, _fp_rate);
+                for (; m.valid(); m.advance())
+                {
+                    writer.push(m.current());
+                }
+                output = writer.finish();
+            }
+            catch (...)
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _error = std::current_exception();
+                _merging = false;
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(_mutex);
+            std::vector<std::shared_ptr<run>> runs;
+            runs.reserve(_runs.size() - inputs.size() + 1);
+            bool placed = false;
+            for (const std::shared_ptr<run> &r : _runs)
+            {
+                if (std::find(inputs.begin(), inputs.end(), r) == inputs.end())
+                {
+                    runs.push_back(r);
+                }
+                else if (!placed)
+                {
+                    runs.push_back(output);
+                    placed = true;
+                }
+            }
+            _runs.swap(runs);
+        }
+    }
+
+    /**
+     * @brief implementazione di unite e intersect
+     *
+     * @param a primo external_set
+     * @param b secondo external_set
+     * @param result external_set a cui aggiungere il risultato
+     * @param all true per l'unione, false per l'intersezione
+     */
+    static void combine(const external_set &a, const external_set &b, external_set &result, bool all)
+    {
+        const Less less;
+        std::shared_ptr<merger> x = a.open();
+        std::shared_ptr<merger> y = b.open();
+
+        const unsigned long long expected = all ? a.upper_bound() + b.upper_bound()
+                                                : (a.upper_bound() < b.upper_bound() ? a.upper_bound() : b.upper_bound());
+        const unsigned int level = a.top_level() > b.top_level() ? a.top_level() : b.top_level();
+        run_writer writer(result.next_path(), expected, level, result._fp_rate);
+
+        while (x->valid() && y->valid())
+        {
+            if (less(x->current(), y->current()))
+            {
+                if (all)
+                {
+                    writer.push(x->current());
+                }
+                x->advance();
+            }
+            else if (less(y->current(), x->current()))
+            {
+                if (all)
+                {
+                    writer.push(y->current());
+                }
+                y->advance();
+            }
+            else
+            {
+                writer.push(x->current());
+                x->advance();
+                y->advance();
+            }
+        }
+
+        for (merger *rest : {x.get(), y.get()})
+        {
+            for (; all && rest->valid(); rest->advance())
+            {
+                writer.push(rest->current());
+            }
+        }
+
+        result.adopt(writer.finish());
+    }
+}; // external_set
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file footprint.hpp
+ *
+ * @brief file di dichiarazione e definizione delle strutture per misurare la memoria dei set
+ *
+ * File di dichiarazione e definizione della struttura memory_footprint, il resoconto della memoria
+ * occupata da uno o più set, e dei funtori heap_bytes, che stimano la memoria posseduta da un elemento
+ * fuori dall'array del set.
+ */
+#ifndef FOOTPRINT_HPP
+#define FOOTPRINT_HPP
+
+#include <ostream> // std::ostream
+#include <string>  // std::basic_string
+#include <vector>  // std::vector
+
+/**
+ * @brief resoconto della memoria occupata da uno o più set
+ *
+ * Tutte le dimensioni sono in byte. Non viene contato lo spazio che l'allocatore aggiunge a ogni blocco.
+ */
+struct memory_footprint
+{
+    unsigned long long elements = 0; ///< elementi costruiti nell'array
+    unsigned long long slack = 0;    ///< celle allocate ma non usate dell'array e della cache degli hash
+    unsigned long long index = 0;    ///< indice hash, filtro di Bloom e cache degli hash delle celle usate
+    unsigned long long metadata = 0; ///< oggetti set, contatori di riferimenti e intestazioni di indice e filtro
+    unsigned long long heap = 0;     ///< memoria posseduta dagli elementi fuori dall'array, secondo lo stimatore usato
+    unsigned long long sets = 0;     ///< numero di set misurati
+
+    /**
+     * @brief memoria totale
+     *
+     * @return somma di tutte le voci
+     */
+    unsigned long long total() const
+    {
+        return elements + slack + index + metadata + heap;
+    }
+
+    /**
+     * @brief somma un altro resoconto
+     *
+     * Permette di aggregare resoconti di set di tipi diversi.
+     *
+     * @param other resoconto da sommare
+     *
+     * @return reference al resoconto modificato
+     */
+    memory_footprint &operator+=(const memory_footprint &other)
+    {
+        elements += other.elements;
+        slack += other.slack;
+        index += other.index;
+        metadata += other.metadata;
+        heap += other.heap;
+        sets += other.sets;
+        return *this;
+    }
+};
+
+/**
+ * @brief funzione globale per stampare un resoconto su stream
+ *
+ * Stampa una riga nel formato "sets=n elements=b slack=b index=b metadata=b heap=b total=b".
+ *
+ * @param os stream di output
+ * @param m resoconto da stampare
+ *
+ * @return reference allo stream di output
+ */
+inline std::ostream &operator<<(std::ostream &os, const memory_footprint &m)
+{
+    os << "sets=" << m.sets << " elements=" << m.elements << " slack=" << m.slack << " index=" << m.index
+       << " metadata=" << m.metadata << " heap=" << m.heap << " total=" << m.total();
+    return os;
+}
+
+/**
+ * @brief stimatore di default della memoria posseduta da un elemento
+ *
+ * Per un tipo generico assume che l'elemento non possieda memoria oltre a sizeof(T).
+ * Le specializzazioni coprono std::basic_string e std::vector; per altri tipi
+ * si può passare a memory_usage un funtore qualsiasi con la stessa firma.
+ */
+template <typename T>
+struct heap_bytes
+{
+    /**
+     * @brief memoria posseduta dall'elemento
+     *
+     * @return sempre 0
+     */
+    unsigned long long operator()(const T &) const
+    {
+        return 0;
+    }
+};
+
+/**
+ * @brief stimatore della memoria posseduta da una stringa
+ *
+ * Le stringhe corte sono memorizzate nell'oggetto stesso (small string optimization) e non occupano memoria dinamica:
+ * vengono riconosciute perché i loro caratteri si trovano all'interno dell'oggetto.
+ */
+template <typename C, typename Traits, typename Alloc>
+struct heap_bytes<std::basic_string<C, Traits, Alloc>>
+{
+    /**
+     * @brief memoria posseduta dalla stringa
+     *
+     * @param s stringa da misurare
+     *
+     * @return capacità della stringa più il terminatore, 0 se i caratteri sono nell'oggetto
+     */
+    unsigned long long operator()(const std::basic_string<C, Traits, Alloc> &s) const
+    {
+        const char *data = reinterpret_cast<const char *>(s.data());
+        const char *object = reinterpret_cast<const char *>(&s);
+        if (data >= object && data < object + sizeof(s))
+        {
+            return 0;
+        }
+
+        return (static_cast<unsigned long long>(s.capacity()) + 1) * sizeof(C);
+    }
+};
+
+/**
+ * @brief stimatore della memoria posseduta da un vettore
+ *
+ * Conta la capacità del vettore e, ricorsivamente, la memoria posseduta dai suoi elementi.
+ */
+template <typename U, typename Alloc>
+struct heap_bytes<std::vector<U, Alloc>>
+{
+    /**
+     * @brief memoria posseduta dal vettore
+     *
+     * @param v vettore da misurare
+     *
+     * @return byte dell'array del vettore più quelli posseduti dai suoi elementi
+     */
+    unsigned long long operator()(const std::vector<U, Alloc> &v) const
+    {
+        unsigned long long bytes = static_cast<unsigned long long>(v.capacity()) * sizeof(U);
+        for (const U &element : v)
+        {
+            bytes += heap_bytes<U>()(element);
+        }
+        return bytes;
+    }
+};
+
+#endif
@@ -0,0 +1,351 @@
+/**
+ * @file hash_index.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe hash_index
+ *
+ * File di dichiarazione e definizione della classe templata hash_index,
+ * una tabella hash di indici verso un array di elementi posseduto da altri.
+ */
+#ifndef HASH_INDEX_HPP
+#define HASH_INDEX_HPP
+
+#include <cstdint>   // std::uint32_t, std::uint64_t
+#include <algorithm> // std::copy, std::fill, swap
+#include "hashing.hpp"
+
+/**
+ * @brief classe hash_index che rappresenta un indice hash
+ *
+ * L'indice non contiene gli elementi, ma solo la loro posizione in un array esterno
+ * e i 32 bit bassi del loro hash rimescolato.
+ * Le ricerche ricevono una funzione di accesso get(i) che ritorna l'i-esimo elemento dell'array esterno:
+ * in questo modo lo stesso indice funziona con array di elementi, di puntatori o con viste su dati altrui.
+ * Gli hash memorizzati permettono di confrontare con Eql solo gli elementi con lo stesso hash
+ * e di ridimensionare la tabella senza ricalcolare alcun hash.
+ *
+ * È templata su tre tipi:
+ * - T: tipo degli elementi
+ * - Eql: funtore di confronto tra due elementi
+ * - Hash: funtore di hash coerente con Eql
+ *
+ * La tabella usa indirizzamento aperto con scansione lineare ed è mantenuta piena al più al 70%.
+ */
+template <typename T, typename Eql, typename Hash>
+class hash_index
+{
+public:
+    static const unsigned int NOT_FOUND = 0xFFFFFFFFu; ///< valore ritornato da find se l'elemento non è presente
+
+private:
+    /**
+     * @brief cella della tabella
+     */
+    struct slot
+    {
+        std::uint32_t hash;  ///< 32 bit bassi dell'hash rimescolato
+        std::uint32_t index; ///< posizione dell'elemento nell'array esterno, NOT_FOUND se la cella è vuota
+    };
+
+    slot *_slots;           ///< puntatore all'array di celle
+    unsigned int _capacity; ///< numero di celle, potenza di 2 oppure 0
+    unsigned int _count;    ///< numero di celle occupate
+
+    Hash _hash; ///< istanza del funtore di hash
+    Eql _eql;   ///< istanza del funtore di confronto
+
+public:
+    /**
+     * @brief costruttore di default
+     *
+     * Crea un indice vuoto che non occupa memoria.
+     *
+     * @post _slots == nullptr
+     * @post _capacity == 0
+     * @post _count == 0
+     */
+    hash_index() : _slots(nullptr), _capacity(0), _count(0) {}
+
+    /**
+     * @brief costruttore con numero di elementi previsto
+     *
+     * Crea un indice vuoto che può contenere expected elementi senza ridimensionamenti.
+     *
+     * @param expected numero di elementi previsto
+     *
+     * @throws std::bad_alloc se l'allocazione della tabella fallisce
+     */
+    explicit hash_index(unsigned int expected) : _slots(nullptr), _capacity(0), _count(0)
+    {
+        reserve(expected);
+    }
+
+    /**
+     * @brief costruttore di copia
+     *
+     * @param other indice da copiare
+     *
+     * @throws std::bad_alloc se l'allocazione della tabella fallisce
+     */
+    hash_index(const hash_index &other) : _slots(nullptr), _capacity(other._capacity), _count(other._count)
+    {
+        if (_capacity > 0)
+        {
+            _slots = new slot[_capacity];
+            std::copy(other._slots, other._slots + _capacity, _slots);
+        }
+    }
+
+    /**
+     * @brief operatore di assegnamento
+     *
+     * In caso di errore l'operazione viene annullata.
+     *
+     * @param rhs indice da copiare
+     *
+     * @return reference all'indice modificato
+     *
+     * @throws std::bad_alloc se lanciata dal costruttore di copia
+     */
+    hash_index &operator=(const hash_index &rhs)
+    {
+        if (this != &rhs)
+        {
+            hash_index tmp(rhs);
+
+            std::swap(_slots, tmp._slots);
+            std::swap(_capacity, tmp._capacity);
+            std::swap(_count, tmp._count);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Libera la memoria occupata dalla tabella.
+     */
+    ~hash_index()
+    {
+        delete[] _slots;
+        _slots = nullptr;
+    }
+
+    /**
+     * @brief hash di un elemento
+     *
+     * Calcola l'hash rimescolato dell'elemento come usato dall'indice.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento di cui calcolare l'hash
+     *
+     * @return 32 bit bassi dell'hash rimescolato
+     *
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    std::uint32_t hash_of(const T &element) const
+    {
+        return static_cast<std::uint32_t>(hash_mix(static_cast<std::uint64_t>(_hash(element))));
+    }
+
+    /**
+     * @brief ricerca un elemento
+     *
+     * Cerca l'elemento tra quelli indicizzati, confrontando con Eql solo quelli con lo stesso hash.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     * @param h hash dell'elemento, come calcolato da hash_of
+     * @param get funzione che dato un indice ritorna l'elemento corrispondente dell'array esterno
+     *
+     * @return posizione dell'elemento nell'array esterno, NOT_FOUND se non è presente
+     *
+     * @throws ... eventuali eccezioni lanciate dal funtore Eql
+     */
+    template <typename Get>
+    unsigned int find(const T &element, std::uint32_t h, Get get) const
+    {
+        if (_capacity == 0)
+        {
+            return NOT_FOUND;
+        }
+
+        const unsigned int mask = _capacity - 1;
+        for (unsigned int pos = h & mask;; pos = (pos + 1) & mask)
+        {
+            const slot &s = _slots[pos];
+            if (s.index == NOT_FOUND)
+            {
+                return NOT_FOUND;
+            }
+
+            if (s.hash == h && _eql(get(s.index), element))
+            {
+                return s.index;
+            }
+        }
+    }
+
+    /**
+     * @brief anticipa il caricamento della cella di un hash
+     *
+     * Chiede al processore di portare in cache la prima cella che find visiterà per l'hash h,
+     * così che più ricerche consecutive possano sovrapporre i propri accessi alla memoria.
+     * Non ha effetti sul risultato delle ricerche.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param h hash dell'elemento, come calcolato da hash_of
+     */
+    void prefetch(std::uint32_t h) const
+    {
+        if (_capacity > 0)
+        {
+            __builtin_prefetch(_slots + (h & (_capacity - 1)));
+        }
+    }
+
+    /**
+     * @brief inserisce un elemento
+     *
+     * Registra che l'elemento con hash h si trova in posizione index dell'array esterno.
+     * Non viene controllato se l'elemento è già presente. Se necessario la tabella viene ingrandita.
+     * In caso di errore l'indice rimane invariato.
+     *
+     * @param index posizione dell'elemento nell'array esterno
+     * @param h hash dell'elemento, come calcolato da hash_of
+     *
+     * @pre index != NOT_FOUND
+     *
+     * @post size() incrementata di 1
+     *
+     * @throws std::bad_alloc se l'allocazione della nuova tabella fallisce
+     */
+    void insert(unsigned int index, std::uint32_t h)
+    {
+        if (10ULL * (_count + 1) > 7ULL * _capacity)
+        {
+            reserve(_count + 1 > 2 * _count ? _count + 1 : 2 * _count);
+        }
+
+        place(_slots, _capacity, index, h);
+        ++_count;
+    }
+
+    /**
+     * @brief prepara l'indice per un numero di elementi
+     *
+     * Ingrandisce la tabella in modo che possa contenere expected elementi senza ulteriori ridimensionamenti.
+     * Gli hash memorizzati vengono riusati, senza chiamare il funtore Hash.
+     * In caso di errore l'indice rimane invariato.
+     *
+     * @param expected numero di elementi previsto
+     *
+     * @throws std::bad_alloc se l'allocazione della nuova tabella fallisce
+     */
+    void reserve(unsigned int expected)
+    {
+        unsigned int capacity = 16;
+        while (10ULL * expected > 7ULL * capacity)
+        {
+            capacity *= 2;
+        }
+
+        if (capacity <= _capacity)
+        {
+            return;
+        }
+
+        slot *slots = new slot[capacity];
+        std::fill(slots, slots + capacity, slot{0, NOT_FOUND});
+
+        for (unsigned int i = 0; i < _capacity; ++i)
+        {
+            if (_slots[i].index != NOT_FOUND)
+            {
+                place(slots, capacity, _slots[i].index, _slots[i].hash);
+            }
+        }
+
+        delete[] _slots;
+        _slots = slots;
+        _capacity = capacity;
+    }
+
+    /**
+     * @brief svuota l'indice
+     *
+     * Libera la memoria occupata dalla tabella.
+     *
+     * @post size() == 0
+     */
+    void clear()
+    {
+        delete[] _slots;
+        _slots = nullptr;
+        _capacity = 0;
+        _count = 0;
+    }
+
+    /**
+     * @brief scambia il contenuto di due indici
+     *
+     * Non alloca memoria e non può fallire.
+     *
+     * @param other indice con cui scambiare il contenuto
+     */
+    void swap(hash_index &other)
+    {
+        std::swap(_slots, other._slots);
+        std::swap(_capacity, other._capacity);
+        std::swap(_count, other._count);
+    }
+
+    /**
+     * @brief numero di elementi indicizzati
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return numero di elementi inseriti
+     */
+    unsigned int size() const
+    {
+        return _count;
+    }
+
+    /**
+     * @brief dimensione in byte della tabella
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return numero di byte occupati dalla tabella
+     */
+    unsigned long long bytes() const
+    {
+        return static_cast<unsigned long long>(_capacity) * sizeof(slot);
+    }
+
+private:
+    /**
+     * @brief posiziona un elemento in una tabella
+     *
+     * @param slots tabella in cui posizionare l'elemento
+     * @param capacity numero di celle della tabella, potenza di 2
+     * @param index posizione dell'elemento nell'array esterno
+     * @param h hash dell'elemento
+     *
+     * @pre la tabella ha almeno una cella vuota
+     */
+    static void place(slot *slots, unsigned int capacity, unsigned int index, std::uint32_t h)
+    {
+        const unsigned int mask = capacity - 1;
+        unsigned int pos = h & mask;
+        while (slots[pos].index != NOT_FOUND)
+        {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos].hash = h;
+        slots[pos].index = index;
+    }
+}; // hash_index
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file hashing.hpp
+ *
+ * @brief file di dichiarazione e definizione degli strumenti di hashing
+ *
+ * File di dichiarazione e definizione degli strumenti di hashing condivisi dalle strutture dati del progetto.
+ * Contiene:
+ * - il tipo no_hash, usato come valore di default del funtore di hash di set
+ * - la funzione hash_mix, che rimescola i bit di un valore di hash
+ */
+#ifndef HASHING_HPP
+#define HASHING_HPP
+
+#include <cstdint>     // std::uint64_t
+#include <type_traits> // std::is_same
+
+/**
+ * @brief tipo segnaposto per l'assenza di un funtore di hash
+ *
+ * Usato come valore di default del parametro Hash di set.
+ * Un set con Hash == no_hash si basa esclusivamente sul funtore di confronto Eql
+ * e non può abilitare le funzionalità che richiedono una funzione di hash.
+ */
+struct no_hash
+{
+};
+
+/**
+ * @brief verifica se un funtore di hash è utilizzabile
+ *
+ * Vale true se Hash non è il segnaposto no_hash.
+ */
+template <typename Hash>
+struct is_hash_enabled
+{
+    static constexpr bool value = !std::is_same<Hash, no_hash>::value; ///< true se Hash è un funtore di hash vero e proprio
+};
+
+/**
+ * @brief rimescola i bit di un valore di hash
+ *
+ * Applica il finalizzatore di splitmix64 al valore in input.
+ * Serve a distribuire uniformemente i bit di hash "deboli",
+ * come std::hash<int> che nella libreria standard GNU è l'identità.
+ *
+ * È constexpr, così da poter essere usata anche nelle strutture costruite a tempo di compilazione.
+ *
+ * @param h valore di hash da rimescolare
+ *
+ * @return valore di hash rimescolato
+ */
+constexpr std::uint64_t hash_mix(std::uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+#endif
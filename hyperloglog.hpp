@@ -0,0 +1,467 @@
+/**
+ * @file hyperloglog.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe hyperloglog
+ *
+ * File di dichiarazione e definizione della classe templata hyperloglog,
+ * uno sketch che stima il numero di elementi distinti di una sequenza in memoria costante.
+ * Contiene anche le funzioni globali per scrittura e lettura dello sketch su file.
+ */
+#ifndef HYPERLOGLOG_HPP
+#define HYPERLOGLOG_HPP
+
+#include <cstdint>   // std::uint64_t
+#include <cstring>   // std::memcmp
+#include <cmath>     // std::sqrt, std::log
+#include <limits>    // std::numeric_limits
+#include <fstream>   // std::ifstream, std::ofstream
+#include <stdexcept> // std::invalid_argument, std::runtime_error
+#include <string>    // std::string
+#include <algorithm> // std::copy, std::equal, swap
+#include "hashing.hpp"
+#include "set.hpp"
+
+/**
+ * @brief classe hyperloglog che rappresenta uno sketch di cardinalità
+ *
+ * Lo sketch stima quanti elementi distinti sono stati aggiunti, senza memorizzarli.
+ * I 64 bit dell'hash rimescolato di ogni elemento vengono divisi in due parti:
+ * i primi p bit scelgono uno tra m = 2^p registri, i restanti determinano il rango,
+ * cioè la posizione del primo bit a 1; ogni registro conserva il massimo rango visto.
+ * Aggiungere più volte lo stesso elemento non cambia lo sketch.
+ *
+ * È templata su due tipi:
+ * - T: tipo degli elementi
+ * - Hash: funtore di hash, lo stesso che si userebbe per un set degli stessi elementi
+ *
+ * La stima usa lo stimatore migliorato di Ertl, che non richiede correzioni empiriche
+ * ed è accurato sia per cardinalità piccole sia grandi.
+ * L'errore standard è circa 1.04 / sqrt(m): con la precisione di default p = 13
+ * lo sketch occupa 8 KB e l'errore è circa 1.1%.
+ * Due sketch con la stessa precisione possono essere uniti, ad esempio dopo averli costruiti
+ * in thread diversi o letti da file diversi: il risultato è lo sketch dell'unione.
+ */
+template <typename T, typename Hash>
+class hyperloglog
+{
+public:
+    static const unsigned int MIN_PRECISION = 4;      ///< precisione minima
+    static const unsigned int MAX_PRECISION = 18;     ///< precisione massima
+    static const unsigned int DEFAULT_PRECISION = 13; ///< precisione di default, 8 KB di registri
+
+private:
+    unsigned char *_registers; ///< puntatore all'array di 2^_precision registri
+    unsigned int _precision;   ///< numero di bit di hash che scelgono il registro
+
+    Hash _hash; ///< istanza del funtore di hash
+
+public:
+    /**
+     * @brief costruttore con precisione
+     *
+     * Crea uno sketch vuoto con 2^precision registri.
+     *
+     * @param precision numero di bit che scelgono il registro
+     *
+     * @post estimate() == 0
+     *
+     * @throws std::invalid_argument se precision non è compresa tra MIN_PRECISION e MAX_PRECISION
+     * @throws std::bad_alloc se l'allocazione dei registri fallisce
+     */
+    explicit hyperloglog(unsigned int precision = DEFAULT_PRECISION) : _registers(nullptr), _precision(precision)
+    {
+        if (precision < MIN_PRECISION || precision > MAX_PRECISION)
+        {
+            throw std::invalid_argument("Precision must be between 4 and 18!");
+        }
+
+        _registers = new unsigned char[registers()]();
+    }
+
+    /**
+     * @brief costruttore a partire da un set
+     *
+     * Crea lo sketch degli elementi di un set.
+     *
+     * @param s set di cui stimare la cardinalità
+     * @param precision numero di bit che scelgono il registro
+     *
+     * @throws std::invalid_argument se precision non è valida
+     * @throws std::bad_alloc se l'allocazione dei registri fallisce
+     */
+    template <typename Eql>
+    explicit hyperloglog(const set<T, Eql, Hash> &s, unsigned int precision = DEFAULT_PRECISION) : hyperloglog(precision)
+    {
+        for (unsigned int i = 0; i < s.size(); ++i)
+        {
+            add(s[i]);
+        }
+    }
+
+    /**
+     * @brief costruttore a partire da una sequenza
+     *
+     * Crea lo sketch degli elementi tra i due iteratori, in una sola passata e senza memorizzarli.
+     * La compatibilità tra il tipo puntato dall'iteratore e T è gestita tramite un cast statico esplicito, come in set.
+     *
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     * @param precision numero di bit che scelgono il registro
+     *
+     * @throws std::invalid_argument se precision non è valida
+     * @throws std::bad_alloc se l'allocazione dei registri fallisce
+     */
+    template <typename IterT>
+    hyperloglog(IterT begin, IterT end, unsigned int precision = DEFAULT_PRECISION) : hyperloglog(precision)
+    {
+        while (begin != end)
+        {
+            add(static_cast<T>(*begin));
+            ++begin;
+        }
+    }
+
+    /**
+     * @brief costruttore di copia
+     *
+     * @param other sketch da copiare
+     *
+     * @throws std::bad_alloc se l'allocazione dei registri fallisce
+     */
+    hyperloglog(const hyperloglog &other) : _registers(nullptr), _precision(other._precision)
+    {
+        _registers = new unsigned char[registers()];
+        std::copy(other._registers, other._registers + registers(), _registers);
+    }
+
+    /**
+     * @brief operatore di assegnamento
+     *
+     * In caso di errore l'operazione viene annullata.
+     *
+     * @param rhs sketch da copiare
+     *
+     * @return reference allo sketch modificato
+     *
+     * @throws std::bad_alloc se lanciata dal costruttore di copia
+     */
+    hyperloglog &operator=(const hyperloglog &rhs)
+    {
+        if (this != &rhs)
+        {
+            hyperloglog tmp(rhs);
+
+            std::swap(_registers, tmp._registers);
+            std::swap(_precision, tmp._precision);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Libera la memoria occupata dai registri.
+     */
+    ~hyperloglog()
+    {
+        delete[] _registers;
+        _registers = nullptr;
+    }
+
+    /**
+     * @brief aggiunge un elemento allo sketch
+     *
+     * Costo O(1), senza allocazioni.
+     *
+     * @param element elemento da aggiungere
+     */
+    void add(const T &element)
+    {
+        const std::uint64_t h = hash_mix(static_cast<std::uint64_t>(_hash(element)));
+        const std::uint64_t rest = h << _precision;
+        const unsigned int max_rank = 65 - _precision;
+
+        unsigned int rank = rest == 0 ? max_rank : static_cast<unsigned int>(__builtin_clzll(rest)) + 1;
+        if (rank > max_rank)
+        {
+            rank = max_rank;
+        }
+
+        unsigned char &reg = _registers[h >> (64 - _precision)];
+        if (rank > reg)
+        {
+            reg = static_cast<unsigned char>(rank);
+        }
+    }
+
+    /**
+     * @brief unisce un altro sketch a questo
+     *
+     * Dopo l'unione lo sketch stima la cardinalità dell'unione delle due sequenze.
+     *
+     * @param other sketch da unire
+     *
+     * @throws std::invalid_argument se i due sketch hanno precisione diversa
+     */
+    void merge(const hyperloglog &other)
+    {
+        if (_precision != other._precision)
+        {
+            throw std::invalid_argument("Sketches must have the same precision!");
+        }
+
+        for (unsigned int i = 0; i < registers(); ++i)
+        {
+            if (other._registers[i] > _registers[i])
+            {
+                _registers[i] = other._registers[i];
+            }
+        }
+    }
+
+    /**
+     * @brief stima del numero di elementi distinti
+     *
+     * Applica lo stimatore migliorato di Ertl all'istogramma dei registri.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return numero stimato di elementi distinti aggiunti
+     */
+    double estimate() const
+    {
+        const unsigned int q = 64 - _precision;
+        const double m = static_cast<double>(registers());
+
+        unsigned int histogram[66] = {0};
+        for (unsigned int i = 0; i < registers(); ++i)
+        {
+            ++histogram[_registers[i]];
+        }
+
+        if (histogram[0] == registers())
+        {
+            return 0.0;
+        }
+
+        double z = m * tau(1.0 - histogram[q + 1] / m);
+        for (unsigned int k = q; k >= 1; --k)
+        {
+            z = 0.5 * (z + histogram[k]);
+        }
+        z += m * sigma(histogram[0] / m);
+
+        return m * m / (2.0 * std::log(2.0) * z);
+    }
+
+    /**
+     * @brief stima arrotondata del numero di elementi distinti
+     *
+     * @return estimate() arrotondato all'intero più vicino
+     */
+    unsigned long long count() const
+    {
+        return static_cast<unsigned long long>(estimate() + 0.5);
+    }
+
+    /**
+     * @brief errore standard relativo della stima
+     *
+     * @return 1.04 / sqrt(2^precision)
+     */
+    double error() const
+    {
+        return 1.04 / std::sqrt(static_cast<double>(registers()));
+    }
+
+    /**
+     * @brief precisione dello sketch
+     *
+     * @return numero di bit di hash che scelgono il registro
+     */
+    unsigned int precision() const
+    {
+        return _precision;
+    }
+
+    /**
+     * @brief dimensione in byte dei registri
+     *
+     * @return numero di byte occupati dai registri
+     */
+    unsigned long long bytes() const
+    {
+        return registers();
+    }
+
+    /**
+     * @brief svuota lo sketch
+     *
+     * @post estimate() == 0
+     */
+    void clear()
+    {
+        std::fill(_registers, _registers + registers(), 0);
+    }
+
+    /**
+     * @brief operatore di uguaglianza
+     *
+     * @param other sketch da confrontare
+     *
+     * @return true se i due sketch hanno la stessa precisione e gli stessi registri
+     */
+    bool operator==(const hyperloglog &other) const
+    {
+        return _precision == other._precision && std::equal(_registers, _registers + registers(), other._registers);
+    }
+
+    template <typename U, typename H>
+    friend void save(const hyperloglog<U, H> &sketch, const std::string &filename);
+
+    template <typename U, typename H>
+    friend void load(const std::string &filename, hyperloglog<U, H> &sketch);
+
+private:
+    /**
+     * @brief numero di registri
+     *
+     * @return 2^_precision
+     */
+    unsigned int registers() const
+    {
+        return 1u << _precision;
+    }
+
+    /**
+     * @brief funzione sigma dello stimatore di Ertl
+     *
+     * @param x frazione di registri a zero
+     *
+     * @return x + sum_{k>=1} x^(2^k) 2^(k-1)
+     */
+    static double sigma(double x)
+    {
+        if (x == 1.0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        double y = 1.0;
+        double z = x;
+        double previous;
+        do
+        {
+            x *= x;
+            previous = z;
+            z += x * y;
+            y += y;
+        } while (z != previous);
+
+        return z;
+    }
+
+    /**
+     * @brief funzione tau dello stimatore di Ertl
+     *
+     * @param x frazione di registri non saturi
+     *
+     * @return (1 - x - sum_{k>=1} (1 - x^(2^-k))^2 2^-k) / 3
+     */
+    static double tau(double x)
+    {
+        if (x == 0.0 || x == 1.0)
+        {
+            return 0.0;
+        }
+
+        double y = 1.0;
+        double z = 1.0 - x;
+        double previous;
+        do
+        {
+            x = std::sqrt(x);
+            previous = z;
+            y *= 0.5;
+            z -= (1.0 - x) * (1.0 - x) * y;
+        } while (z != previous);
+
+        return z / 3.0;
+    }
+}; // hyperloglog
+
+/**
+ * @brief funzione per salvare uno sketch su file
+ *
+ * Il formato del file è binario:
+ * - intestazione: "HLLS", precisione (1 byte)
+ * - i 2^precisione registri, un byte ciascuno
+ *
+ * @param sketch sketch da salvare
+ * @param filename stringa contenente il file da salvare
+ *
+ * @throw std::runtime_error se il file non viene aperto
+ */
+template <typename T, typename Hash>
+void save(const hyperloglog<T, Hash> &sketch, const std::string &filename)
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    ofs.write("HLLS", 4);
+    ofs.put(static_cast<char>(sketch._precision));
+    ofs.write(reinterpret_cast<const char *>(sketch._registers), sketch.registers());
+    ofs.close();
+}
+
+/**
+ * @brief funzione per leggere uno sketch da file
+ *
+ * Legge uno sketch salvato con save. La precisione viene letta dal file.
+ * In caso di errore sketch rimane invariato.
+ *
+ * @param filename stringa contenente il file da leggere
+ * @param sketch sketch in cui leggere il contenuto del file
+ *
+ * @throw std::runtime_error se il file non esiste o non è uno sketch valido
+ * @throws std::bad_alloc se l'allocazione dei registri fallisce
+ */
+template <typename T, typename Hash>
+void load(const std::string &filename, hyperloglog<T, Hash> &sketch)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    char header[5];
+    if (!ifs.read(header, 5) || std::memcmp(header, "HLLS", 4) != 0 ||
+        static_cast<unsigned char>(header[4]) < hyperloglog<T, Hash>::MIN_PRECISION ||
+        static_cast<unsigned char>(header[4]) > hyperloglog<T, Hash>::MAX_PRECISION)
+    {
+        throw std::runtime_error("Corrupted file!");
+    }
+
+    hyperloglog<T, Hash> temp(static_cast<unsigned char>(header[4]));
+    if (!ifs.read(reinterpret_cast<char *>(temp._registers), temp.registers()))
+    {
+        throw std::runtime_error("Corrupted file!");
+    }
+
+    for (unsigned int i = 0; i < temp.registers(); ++i)
+    {
+        if (temp._registers[i] > 65 - temp._precision)
+        {
+            throw std::runtime_error("Corrupted file!");
+        }
+    }
+
+    sketch = temp;
+    ifs.close();
+}
+
+#endif
@@ -0,0 +1,1001 @@
+/**
+ * @file immutable_set.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe immutable_set
+ *
+ * File di dichiarazione e definizione della classe templata immutable_set,
+ * un insieme persistente in cui ogni modifica crea una nuova versione condividendo la struttura con la precedente.
+ * Contiene anche le funzioni globali per:
+ * - scrittura su stream
+ * - filtraggio
+ */
+#ifndef IMMUTABLE_SET_HPP
+#define IMMUTABLE_SET_HPP
+
+#include <atomic>    // std::atomic
+#include <cstdint>   // std::uint32_t, std::uint64_t
+#include <iterator>  // std::forward_iterator_tag
+#include <cstddef>   // std::ptrdiff_t
+#include <ostream>   // ostream
+#include <algorithm> // swap
+#include <cassert>   // assert
+#include "hashing.hpp"
+#include "set.hpp"
+
+/**
+ * @brief classe immutable_set che rappresenta un insieme persistente
+ *
+ * La classe immutable_set rappresenta un insieme di elementi senza duplicati che non viene mai modificato:
+ * add e remove ritornano una nuova versione dell'insieme, lasciando invariata quella su cui sono chiamati.
+ * È templata su tre tipi:
+ * - T: tipo contenuto nel set
+ * - Hash: funtore di hash, coerente con Eql
+ * - Eql: funtore di confronto tra due elementi
+ *
+ * L'insieme è implementato come hash array mapped trie: ogni nodo consuma 5 bit dell'hash rimescolato dell'elemento
+ * e contiene, in due array compatti indicizzati da bitmap, gli elementi memorizzati direttamente e i nodi figli.
+ * Una modifica copia solo i nodi sul cammino dalla radice all'elemento, O(log32 N), e condivide tutti gli altri:
+ * i nodi hanno un contatore atomico di riferimenti e vengono liberati quando nessuna versione li usa più.
+ * Gli elementi con hash identico a 64 bit finiscono in un nodo di collisione in fondo al trie.
+ * La rappresentazione è canonica: un nodo figlio ha sempre almeno due elementi,
+ * altrimenti il suo unico elemento viene riportato nel nodo padre.
+ */
+template <typename T, typename Hash, typename Eql>
+class immutable_set
+{
+private:
+    static const unsigned int BITS = 5;       ///< bit di hash consumati da ogni livello
+    static const unsigned int MAX_DEPTH = 14; ///< numero massimo di livelli, compreso quello dei nodi di collisione
+
+    /**
+     * @brief nodo del trie
+     *
+     * Nei nodi interni, il bit i di datamap indica che l'elemento con i 5 bit di hash pari a i è memorizzato in elements,
+     * il bit i di nodemap che si trova nel sottoalbero children[popcount(nodemap & (2^i - 1))].
+     * Nei nodi di collisione le bitmap non sono usate e elements contiene elementi con lo stesso hash.
+     */
+    struct node
+    {
+        std::atomic<unsigned int> refs; ///< numero di riferimenti al nodo
+        std::uint32_t datamap;          ///< bitmap degli elementi
+        std::uint32_t nodemap;          ///< bitmap dei figli
+        unsigned int element_count;     ///< numero di elementi
+        unsigned int child_count;       ///< numero di figli
+        T *elements;                    ///< array degli elementi
+        node **children;                ///< array dei figli
+    };
+
+    node *_root;        ///< radice del trie, nullptr se l'insieme è vuoto
+    unsigned int _size; ///< numero di elementi
+
+    Hash _hash; ///< istanza del funtore di hash
+    Eql _eql;   ///< istanza del funtore di confronto
+
+public:
+    /**
+     * @brief costruttore di default
+     *
+     * Crea un insieme vuoto.
+     *
+     * @post _root == nullptr
+     * @post _size == 0
+     */
+    immutable_set() : _root(nullptr), _size(0) {}
+
+    /**
+     * @brief costruttore di copia
+     *
+     * La copia condivide l'intera struttura: costa O(1) e non può fallire.
+     *
+     * @param other insieme da copiare
+     *
+     * @post _root == other._root
+     * @post _size == other._size
+     */
+    immutable_set(const immutable_set &other) : _root(other._root), _size(other._size)
+    {
+        retain(_root);
+    }
+
+    /**
+     * @brief costruttore da set
+     *
+     * Crea un insieme persistente con gli stessi elementi di un set.
+     *
+     * @param s set da convertire
+     *
+     * @throws std::bad_alloc se l'allocazione di un nodo fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     */
+    template <typename SetHash>
+    explicit immutable_set(const set<T, Eql, SetHash> &s) : _root(nullptr), _size(0)
+    {
+        for (unsigned int i = 0; i < s.size(); ++i)
+        {
+            immutable_set next = add(s[i]);
+            swap(next);
+        }
+    }
+
+    /**
+     * @brief operatore di assegnamento
+     *
+     * Condivide la struttura di rhs e rilascia quella attuale.
+     *
+     * @param rhs insieme da copiare
+     *
+     * @return reference all'insieme modificato
+     */
+    immutable_set &operator=(const immutable_set &rhs)
+    {
+        if (this != &rhs)
+        {
+            immutable_set tmp(rhs);
+            swap(tmp);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Rilascia la radice: vengono liberati i nodi non condivisi con altre versioni.
+     */
+    ~immutable_set()
+    {
+        release(_root);
+        _root = nullptr;
+    }
+
+    /**
+     * @brief metodo per la cardinalità dell'insieme
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return cardinalità dell'insieme
+     */
+    unsigned int size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief ricerca un elemento nell'insieme
+     *
+     * Scende nel trie seguendo i bit di hash dell'elemento, in al più MAX_DEPTH passi.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     *
+     * @return true se l'elemento è presente, false altrimenti
+     */
+    bool contains(const T &element) const
+    {
+        const std::uint64_t h = hash_of(element);
+        const node *n = _root;
+
+        for (unsigned int shift = 0; n != nullptr; shift += BITS)
+        {
+            if (shift >= 64)
+            {
+                for (unsigned int i = 0; i < n->element_count; ++i)
+                {
+                    if (_eql(n->elements[i], element))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            const std::uint32_t bit = bit_of(h, shift);
+            if (n->datamap & bit)
+            {
+                return _eql(n->elements[index_of(n->datamap, bit)], element);
+            }
+            if (!(n->nodemap & bit))
+            {
+                return false;
+            }
+            n = n->children[index_of(n->nodemap, bit)];
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief nuova versione con un elemento aggiunto
+     *
+     * Ritorna un insieme che contiene gli elementi di questo più element.
+     * Se element era già presente, ritorna una copia che condivide l'intera struttura.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da aggiungere
+     *
+     * @return la nuova versione dell'insieme
+     *
+     * @throws std::bad_alloc se l'allocazione di un nodo fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     */
+    immutable_set add(const T &element) const
+    {
+        immutable_set result;
+        bool added = false;
+
+        if (_root == nullptr)
+        {
+            result._root = make_node(0, 0, 1, 0);
+            try
+            {
+                result._root->datamap = bit_of(hash_of(element), 0);
+                result._root->elements[0] = element;
+            }
+            catch (...)
+            {
+                release(result._root);
+                result._root = nullptr;
+                throw;
+            }
+            added = true;
+        }
+        else
+        {
+            result._root = insert(_root, element, hash_of(element), 0, added);
+        }
+
+        result._size = _size + (added ? 1 : 0);
+        return result;
+    }
+
+    /**
+     * @brief nuova versione con un elemento rimosso
+     *
+     * Ritorna un insieme che contiene gli elementi di questo tranne element.
+     * Se element non era presente, ritorna una copia che condivide l'intera struttura.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da rimuovere
+     *
+     * @return la nuova versione dell'insieme
+     *
+     * @throws std::bad_alloc se l'allocazione di un nodo fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     */
+    immutable_set remove(const T &element) const
+    {
+        immutable_set result;
+
+        if (_root != nullptr)
+        {
+            bool removed = false;
+            result._root = erase(_root, element, hash_of(element), 0, removed);
+            result._size = _size - (removed ? 1 : 0);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief conversione a set
+     *
+     * Crea un set con gli stessi elementi, nell'ordine di iterazione.
+     * Il funtore di hash del set da creare può essere scelto con il parametro SetHash.
+     *
+     * @return un set contenente tutti e soli gli elementi di questo insieme
+     *
+     * @throws std::bad_alloc se l'allocazione dell'array fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T
+     */
+    template <typename SetHash = no_hash>
+    set<T, Eql, SetHash> to_set() const
+    {
+        return set<T, Eql, SetHash>::from_unique(begin(), end());
+    }
+
+    /**
+     * @brief scambia il contenuto di due insiemi
+     *
+     * @param other insieme con cui scambiare il contenuto
+     */
+    void swap(immutable_set &other)
+    {
+        std::swap(_root, other._root);
+        std::swap(_size, other._size);
+    }
+
+    /**
+     * @brief iteratore costante della classe immutable_set
+     *
+     * Rappresenta un forward const_iterator che visita il trie in profondità:
+     * in ogni nodo prima gli elementi, poi i figli.
+     * Mantiene una pila di al più MAX_DEPTH posizioni, senza allocazioni.
+     * È valido finché esiste l'insieme da cui è stato ottenuto.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief costruttore di default
+         *
+         * Crea un iteratore di fine sequenza.
+         *
+         * @post _depth == 0
+         */
+        const_iterator() : _depth(0) {}
+
+        /**
+         * @brief operatore di dereferenziamento
+         *
+         * @pre l'iteratore non è di fine sequenza
+         *
+         * @return l'elemento puntato dall'iteratore
+         */
+        reference operator*() const
+        {
+            const frame &f = _stack[_depth - 1];
+            return f.n->elements[f.pos];
+        }
+
+        /**
+         * @brief operatore freccia
+         *
+         * @pre l'iteratore non è di fine sequenza
+         *
+         * @return il puntatore all'elemento puntato dall'iteratore
+         */
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        /**
+         * @brief operatore di pre-incremento
+         *
+         * Sposta l'iteratore sull'elemento successivo.
+         *
+         * @return l'iteratore aggiornato
+         */
+        const_iterator &operator++()
+        {
+            ++_stack[_depth - 1].pos;
+            settle();
+            return *this;
+        }
+
+        /**
+         * @brief operatore di post-incremento
+         *
+         * @return un iteratore nello stato precedente alla chiamata
+         */
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+
+        /**
+         * @brief operatore di uguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori puntano allo stesso elemento o sono entrambi di fine sequenza
+         */
+        bool operator==(const const_iterator &other) const
+        {
+            if (_depth != other._depth)
+            {
+                return false;
+            }
+
+            return _depth == 0 ||
+                   (_stack[_depth - 1].n == other._stack[_depth - 1].n && _stack[_depth - 1].pos == other._stack[_depth - 1].pos);
+        }
+
+        /**
+         * @brief operatore di disuguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori non sono uguali
+         */
+        bool operator!=(const const_iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        /**
+         * @brief posizione in un nodo
+         */
+        struct frame
+        {
+            const node *n;    ///< nodo visitato
+            unsigned int pos; ///< prossima posizione: prima gli elementi, poi i figli
+        };
+
+        frame _stack[MAX_DEPTH]; ///< pila dei nodi dalla radice a quello corrente
+        unsigned int _depth;     ///< numero di nodi nella pila, 0 a fine sequenza
+
+        friend class immutable_set;
+
+        /**
+         * @brief costruttore privato di inizio sequenza
+         *
+         * @param root radice del trie, nullptr se l'insieme è vuoto
+         */
+        explicit const_iterator(const node *root) : _depth(0)
+        {
+            if (root != nullptr)
+            {
+                _stack[0].n = root;
+                _stack[0].pos = 0;
+                _depth = 1;
+                settle();
+            }
+        }
+
+        /**
+         * @brief porta l'iteratore sul prossimo elemento
+         *
+         * Scende nei figli o risale la pila finché la posizione in cima non indica un elemento,
+         * oppure la pila si svuota.
+         */
+        void settle()
+        {
+            while (_depth > 0)
+            {
+                frame &f = _stack[_depth - 1];
+                if (f.pos < f.n->element_count)
+                {
+                    return;
+                }
+
+                const unsigned int child = f.pos - f.n->element_count;
+                if (child < f.n->child_count)
+                {
+                    ++f.pos;
+                    _stack[_depth].n = f.n->children[child];
+                    _stack[_depth].pos = 0;
+                    ++_depth;
+                }
+                else
+                {
+                    --_depth;
+                }
+            }
+        }
+    }; // const_iterator
+
+    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return l'iteratore di inizio sequenza dell'insieme
+     */
+    iterator begin() const
+    {
+        return iterator(_root);
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return l'iteratore di fine sequenza dell'insieme
+     */
+    iterator end() const
+    {
+        return iterator();
+    }
+
+private:
+    /**
+     * @brief hash rimescolato di un elemento
+     *
+     * @param element elemento di cui calcolare l'hash
+     *
+     * @return hash a 64 bit dell'elemento
+     */
+    std::uint64_t hash_of(const T &element) const
+    {
+        return hash_mix(static_cast<std::uint64_t>(_hash(element)));
+    }
+
+    /**
+     * @brief bit della bitmap corrispondente a un hash a un dato livello
+     *
+     * @param h hash dell'elemento
+     * @param shift numero di bit di hash già consumati
+     *
+     * @return bitmap con il solo bit dell'elemento impostato
+     */
+    static std::uint32_t bit_of(std::uint64_t h, unsigned int shift)
+    {
+        return std::uint32_t(1) << ((h >> shift) & 31);
+    }
+
+    /**
+     * @brief posizione compatta di un bit in una bitmap
+     *
+     * @param bitmap bitmap del nodo
+     * @param bit bit di cui calcolare la posizione
+     *
+     * @return numero di bit impostati in bitmap prima di bit
+     */
+    static unsigned int index_of(std::uint32_t bitmap, std::uint32_t bit)
+    {
+        return static_cast<unsigned int>(__builtin_popcount(bitmap & (bit - 1)));
+    }
+
+    /**
+     * @brief aggiunge un riferimento a un nodo
+     *
+     * @param n nodo, può essere nullptr
+     */
+    static void retain(node *n)
+    {
+        if (n != nullptr)
+        {
+            n->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief rilascia un riferimento a un nodo
+     *
+     * Se era l'ultimo riferimento, libera il nodo e rilascia i suoi figli.
+     *
+     * @param n nodo, può essere nullptr
+     */
+    static void release(node *n)
+    {
+        if (n != nullptr && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            for (unsigned int i = 0; i < n->child_count; ++i)
+            {
+                release(n->children[i]);
+            }
+            delete[] n->elements;
+            delete[] n->children;
+            delete n;
+        }
+    }
+
+    /**
+     * @brief crea un nodo
+     *
+     * Crea un nodo con gli array della dimensione richiesta; i figli sono inizializzati a nullptr.
+     *
+     * @param datamap bitmap degli elementi
+     * @param nodemap bitmap dei figli
+     * @param element_count numero di elementi
+     * @param child_count numero di figli
+     *
+     * @return il nuovo nodo, con un riferimento
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     */
+    static node *make_node(std::uint32_t datamap, std::uint32_t nodemap, unsigned int element_count, unsigned int child_count)
+    {
+        node *n = new node;
+        n->refs.store(1, std::memory_order_relaxed);
+        n->datamap = datamap;
+        n->nodemap = nodemap;
+        n->element_count = element_count;
+        n->child_count = child_count;
+        n->elements = nullptr;
+        n->children = nullptr;
+
+        try
+        {
+            if (element_count > 0)
+            {
+                n->elements = new T[element_count];
+            }
+            if (child_count > 0)
+            {
+                n->children = new node *[child_count]();
+            }
+        }
+        catch (...)
+        {
+            delete[] n->elements;
+            delete n;
+            throw;
+        }
+
+        return n;
+    }
+
+    /**
+     * @brief crea la copia di un nodo con un elemento in meno e/o un figlio in più
+     *
+     * Copia n saltando l'elemento in posizione skip_element e inserendo child in posizione insert_child,
+     * e con un elemento in più (added, in posizione insert_element) e/o un figlio in meno (skip_child).
+     * I parametri non usati valgono NONE. I figli copiati ricevono un riferimento in più,
+     * child viene preso in carico dal nuovo nodo.
+     *
+     * @param n nodo da copiare
+     * @param datamap bitmap degli elementi del nuovo nodo
+     * @param nodemap bitmap dei figli del nuovo nodo
+     * @param skip_element posizione in n dell'elemento da non copiare
+     * @param added elemento da inserire, nullptr se nessuno
+     * @param insert_element posizione nel nuovo nodo dell'elemento da inserire
+     * @param skip_child posizione in n del figlio da non copiare
+     * @param child figlio da inserire, nullptr se nessuno
+     * @param insert_child posizione nel nuovo nodo del figlio da inserire
+     *
+     * @return il nuovo nodo, con un riferimento
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T; in questo caso child viene rilasciato
+     */
+    static node *rebuild(const node *n, std::uint32_t datamap, std::uint32_t nodemap,
+                         unsigned int skip_element, const T *added, unsigned int insert_element,
+                         unsigned int skip_child, node *child, unsigned int insert_child)
+    {
+        const unsigned int elements = n->element_count - (skip_element != NONE ? 1 : 0) + (added != nullptr ? 1 : 0);
+        const unsigned int children = n->child_count - (skip_child != NONE ? 1 : 0) + (child != nullptr ? 1 : 0);
+
+        node *r = nullptr;
+        try
+        {
+            r = make_node(datamap, nodemap, elements, children);
+
+            for (unsigned int i = 0, j = 0; j < elements; ++j)
+            {
+                if (added != nullptr && j == insert_element)
+                {
+                    r->elements[j] = *added;
+                    continue;
+                }
+                if (i == skip_element)
+                {
+                    ++i;
+                }
+                r->elements[j] = n->elements[i++];
+            }
+        }
+        catch (...)
+        {
+            release(r);
+            release(child);
+            throw;
+        }
+
+        for (unsigned int i = 0, j = 0; j < children; ++j)
+        {
+            if (child != nullptr && j == insert_child)
+            {
+                r->children[j] = child;
+                continue;
+            }
+            if (i == skip_child)
+            {
+                ++i;
+            }
+            r->children[j] = n->children[i++];
+            retain(r->children[j]);
+        }
+
+        return r;
+    }
+
+    static const unsigned int NONE = 0xFFFFFFFFu; ///< posizione non usata in rebuild
+
+    /**
+     * @brief crea il sottoalbero che contiene due elementi
+     *
+     * @param a primo elemento
+     * @param ha hash del primo elemento
+     * @param b secondo elemento
+     * @param hb hash del secondo elemento
+     * @param shift numero di bit di hash già consumati
+     *
+     * @return il nuovo nodo, con un riferimento
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T
+     */
+    static node *make_pair(const T &a, std::uint64_t ha, const T &b, std::uint64_t hb, unsigned int shift)
+    {
+        if (shift >= 64)
+        {
+            node *r = make_node(0, 0, 2, 0);
+            try
+            {
+                r->elements[0] = a;
+                r->elements[1] = b;
+            }
+            catch (...)
+            {
+                release(r);
+                throw;
+            }
+            return r;
+        }
+
+        const std::uint32_t bit_a = bit_of(ha, shift);
+        const std::uint32_t bit_b = bit_of(hb, shift);
+
+        if (bit_a == bit_b)
+        {
+            node *child = make_pair(a, ha, b, hb, shift + BITS);
+            node *r = nullptr;
+            try
+            {
+                r = make_node(0, bit_a, 0, 1);
+            }
+            catch (...)
+            {
+                release(child);
+                throw;
+            }
+            r->children[0] = child;
+            return r;
+        }
+
+        node *r = make_node(bit_a | bit_b, 0, 2, 0);
+        try
+        {
+            r->elements[bit_a < bit_b ? 0 : 1] = a;
+            r->elements[bit_a < bit_b ? 1 : 0] = b;
+        }
+        catch (...)
+        {
+            release(r);
+            throw;
+        }
+        return r;
+    }
+
+    /**
+     * @brief inserisce un elemento in un sottoalbero
+     *
+     * @param n radice del sottoalbero
+     * @param element elemento da inserire
+     * @param h hash dell'elemento
+     * @param shift numero di bit di hash già consumati
+     * @param added impostato a true se l'elemento non era presente
+     *
+     * @return la radice del nuovo sottoalbero, con un riferimento; coincide con n se l'elemento era presente
+     *
+     * @throws std::bad_alloc se l'allocazione di un nodo fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T
+     */
+    node *insert(node *n, const T &element, std::uint64_t h, unsigned int shift, bool &added) const
+    {
+        if (shift >= 64)
+        {
+            for (unsigned int i = 0; i < n->element_count; ++i)
+            {
+                if (_eql(n->elements[i], element))
+                {
+                    retain(n);
+                    return n;
+                }
+            }
+
+            added = true;
+            return rebuild(n, 0, 0, NONE, &element, n->element_count, NONE, nullptr, NONE);
+        }
+
+        const std::uint32_t bit = bit_of(h, shift);
+
+        if (n->datamap & bit)
+        {
+            const unsigned int i = index_of(n->datamap, bit);
+            if (_eql(n->elements[i], element))
+            {
+                retain(n);
+                return n;
+            }
+
+            node *child = make_pair(n->elements[i], hash_of(n->elements[i]), element, h, shift + BITS);
+            added = true;
+            return rebuild(n, n->datamap & ~bit, n->nodemap | bit, i, nullptr, NONE,
+                           NONE, child, index_of(n->nodemap, bit));
+        }
+
+        if (n->nodemap & bit)
+        {
+            const unsigned int j = index_of(n->nodemap, bit);
+            node *child = insert(n->children[j], element, h, shift + BITS, added);
+            if (child == n->children[j])
+            {
+                release(child);
+                retain(n);
+                return n;
+            }
+
+            return rebuild(n, n->datamap, n->nodemap, NONE, nullptr, NONE, j, child, j);
+        }
+
+        added = true;
+        return rebuild(n, n->datamap | bit, n->nodemap, NONE, &element, index_of(n->datamap, bit), NONE, nullptr, NONE);
+    }
+
+    /**
+     * @brief rimuove un elemento da un sottoalbero
+     *
+     * Se un figlio rimane con un solo elemento e nessun figlio, l'elemento viene riportato in n.
+     *
+     * @param n radice del sottoalbero
+     * @param element elemento da rimuovere
+     * @param h hash dell'elemento
+     * @param shift numero di bit di hash già consumati
+     * @param removed impostato a true se l'elemento era presente
+     *
+     * @return la radice del nuovo sottoalbero, con un riferimento, nullptr se vuoto; coincide con n se l'elemento non era presente
+     *
+     * @throws std::bad_alloc se l'allocazione di un nodo fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T
+     */
+    node *erase(node *n, const T &element, std::uint64_t h, unsigned int shift, bool &removed) const
+    {
+        if (shift >= 64)
+        {
+            for (unsigned int i = 0; i < n->element_count; ++i)
+            {
+                if (_eql(n->elements[i], element))
+                {
+                    removed = true;
+                    if (n->element_count == 1)
+                    {
+                        return nullptr;
+                    }
+                    return rebuild(n, 0, 0, i, nullptr, NONE, NONE, nullptr, NONE);
+                }
+            }
+
+            retain(n);
+            return n;
+        }
+
+        const std::uint32_t bit = bit_of(h, shift);
+
+        if (n->datamap & bit)
+        {
+            const unsigned int i = index_of(n->datamap, bit);
+            if (!_eql(n->elements[i], element))
+            {
+                retain(n);
+                return n;
+            }
+
+            removed = true;
+            if (n->element_count == 1 && n->child_count == 0)
+            {
+                return nullptr;
+            }
+            return rebuild(n, n->datamap & ~bit, n->nodemap, i, nullptr, NONE, NONE, nullptr, NONE);
+        }
+
+        if (n->nodemap & bit)
+        {
+            const unsigned int j = index_of(n->nodemap, bit);
+            node *child = erase(n->children[j], element, h, shift + BITS, removed);
+            if (child == n->children[j])
+            {
+                release(child);
+                retain(n);
+                return n;
+            }
+
+            if (child == nullptr)
+            {
+                if (n->element_count == 0 && n->child_count == 1)
+                {
+                    return nullptr;
+                }
+                return rebuild(n, n->datamap, n->nodemap & ~bit, NONE, nullptr, NONE, j, nullptr, NONE);
+            }
+
+            if (child->element_count == 1 && child->child_count == 0)
+            {
+                // il figlio ha un solo elemento: viene riportato in questo nodo
+                node *r = nullptr;
+                try
+                {
+                    r = rebuild(n, n->datamap | bit, n->nodemap & ~bit, NONE, &child->elements[0],
+                                index_of(n->datamap, bit), j, nullptr, NONE);
+                }
+                catch (...)
+                {
+                    release(child);
+                    throw;
+                }
+                release(child);
+                return r;
+            }
+
+            return rebuild(n, n->datamap, n->nodemap, NONE, nullptr, NONE, j, child, j);
+        }
+
+        retain(n);
+        return n;
+    }
+}; // immutable_set
+
+/**
+ * @brief funzione globale per stampare un immutable_set su stream
+ *
+ * Stampa un immutable_set su stream nello stesso formato di set:
+ * - {e1, e2, ..., en}
+ *
+ * @param os stream di output su cui stampare
+ * @param s insieme da stampare
+ */
+template <typename T, typename Hash, typename Eql>
+std::ostream &operator<<(std::ostream &os, const immutable_set<T, Hash, Eql> &s)
+{
+    typename immutable_set<T, Hash, Eql>::const_iterator i, ie;
+
+    i = s.begin();
+    ie = s.end();
+
+    os << "{";
+
+    while (i != ie)
+    {
+        os << *i;
+        i++;
+
+        if (i != ie)
+        {
+            os << ", ";
+        }
+    }
+
+    os << "}";
+
+    return os;
+}
+
+/**
+ * @brief funzione per filtrare un immutable_set
+ *
+ * Crea una nuova versione che contiene solo gli elementi che rispettano pred,
+ * rimuovendo gli altri da S: la nuova versione condivide con S i sottoalberi non toccati.
+ *
+ * @param S insieme da filtrare
+ * @param pred predicato booleano che prende in input un oggetto di tipo T
+ *
+ * @return un insieme contenente tutti e soli gli elementi di S che rispettano pred
+ */
+template <typename T, typename Hash, typename Eql, typename P>
+immutable_set<T, Hash, Eql> filter_out(const immutable_set<T, Hash, Eql> &S, P pred)
+{
+    immutable_set<T, Hash, Eql> result = S;
+
+    typename immutable_set<T, Hash, Eql>::const_iterator i, ie;
+    i = S.begin();
+    ie = S.end();
+
+    while (i != ie)
+    {
+        if (!pred(*i))
+        {
+            immutable_set<T, Hash, Eql> next = result.remove(*i);
+            result.swap(next);
+        }
+
+        i++;
+    }
+
+    return result;
+}
+
+#endif
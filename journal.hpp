@@ -0,0 +1,514 @@
+/**
+ * @file journal.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe journaled_set
+ *
+ * File di dichiarazione e definizione della classe templata journaled_set,
+ * un set che salva su file le modifiche in modo incrementale.
+ * Contiene anche la funzione globale load_journal per leggere un set da snapshot e journal.
+ */
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include <cstdio>     // std::FILE, std::fopen, std::fwrite, std::fflush, std::fclose, std::rename
+#include <filesystem> // std::filesystem::path, std::filesystem::resize_file
+#include <fstream>    // ifstream
+#include <sstream>    // ostringstream, istringstream
+#include <string>     // std::string, std::getline
+#include <stdexcept>  // std::runtime_error, std::invalid_argument
+#include <fcntl.h>    // open, O_RDONLY, O_DIRECTORY
+#include <unistd.h>   // fsync, close
+#include "set.hpp"
+
+/**
+ * @brief funzione per leggere un set da uno snapshot e dal suo journal
+ *
+ * Legge lo snapshot con load e vi applica in ordine le operazioni registrate nel journal.
+ * Lo snapshot è nel formato di save; il journal contiene un'operazione per riga:
+ * - "+ elemento" per un'aggiunta
+ * - "- elemento" per una rimozione
+ * Se lo snapshot o il journal non esistono vengono considerati vuoti.
+ * Un'ultima riga senza terminatore (scrittura interrotta) viene ignorata.
+ * Una riga con caratteri dopo l'elemento non è valida.
+ *
+ * @param snapshot nome del file di snapshot
+ * @param log nome del file di journal
+ * @param s set in cui leggere i dati
+ *
+ * @return numero di operazioni lette dal journal
+ *
+ * @throw std::runtime_error se il journal contiene una riga non valida
+ * @throws std::bad_alloc dal metodo add
+ * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+ */
+template <typename T, typename Eql, typename Hash>
+unsigned int load_journal(const std::string &snapshot, const std::string &log, set<T, Eql, Hash> &s)
+{
+    set<T, Eql, Hash> temp;
+    if constexpr (is_hash_enabled<Hash>::value)
+    {
+        if (s.has_filter())
+        {
+            temp.enable_filter(s.filter_fp_rate());
+        }
+    }
+
+    if (std::ifstream(snapshot).is_open())
+    {
+        load(snapshot, temp);
+    }
+
+    unsigned int records = 0;
+
+    std::ifstream ifs(log);
+    std::string line;
+    while (ifs.is_open() && std::getline(ifs, line))
+    {
+        if (ifs.eof())
+        {
+            break; // riga incompleta
+        }
+
+        std::istringstream iss(line);
+        char op;
+        T val;
+        if (!(iss >> op >> val) || (op != '+' && op != '-') || !(iss >> std::ws).eof())
+        {
+            throw std::runtime_error("Corrupted journal!");
+        }
+
+        if (op == '+')
+        {
+            temp.add(val);
+        }
+        else
+        {
+            temp.remove(val);
+        }
+
+        ++records;
+    }
+
+    s = temp;
+    return records;
+}
+
+/**
+ * @brief classe journaled_set che rappresenta un set persistente
+ *
+ * La classe journaled_set mantiene in memoria un set e ne rende persistenti le modifiche su due file:
+ * - uno snapshot completo nel formato di save
+ * - un journal in sola aggiunta, con una riga per ogni add o remove che ha modificato il set
+ * Il costo di ogni modifica su disco è quindi proporzionale alla modifica e non alla dimensione del set.
+ * Quando il journal supera ratio volte la dimensione del set, viene compattato in un nuovo snapshot.
+ *
+ * Le righe del journal vengono bufferizzate: sync le scrive e le rende durabili con fsync.
+ * Gli oggetti di questa classe non sono copiabili, perché possiedono il file di journal aperto.
+ */
+template <typename T, typename Eql, typename Hash = no_hash>
+class journaled_set
+{
+private:
+    static const unsigned int MIN_COMPACTION = 64; ///< numero minimo di operazioni nel journal prima di compattare
+
+    set<T, Eql, Hash> _set; ///< set in memoria
+
+    std::string _snapshot; ///< nome del file di snapshot
+    std::string _log;      ///< nome del file di journal
+    std::FILE *_file;      ///< file di journal aperto in aggiunta
+    unsigned int _records; ///< numero di operazioni nel journal
+    double _ratio;         ///< rapporto tra operazioni nel journal e dimensione del set oltre cui compattare
+
+public:
+    /**
+     * @brief costruttore a partire dai file
+     *
+     * Legge il set dallo snapshot e dal journal con load_journal e apre il journal in aggiunta.
+     * Un'ultima riga incompleta, ignorata da load_journal, viene prima tagliata dal journal:
+     * altrimenti la prossima operazione verrebbe scritta sulla stessa riga.
+     * Se i file non esistono il set parte vuoto.
+     *
+     * @param snapshot nome del file di snapshot
+     * @param log nome del file di journal
+     * @param ratio rapporto tra operazioni nel journal e dimensione del set oltre cui compattare
+     *
+     * @pre ratio > 0
+     *
+     * @throw std::invalid_argument se ratio non è positivo
+     * @throw std::runtime_error se il journal è corrotto o non può essere aperto
+     * @throws std::bad_alloc dal metodo add
+     */
+    journaled_set(const std::string &snapshot, const std::string &log, double ratio = 1.0)
+        : _snapshot(snapshot), _log(log), _file(nullptr), _records(0), _ratio(ratio)
+    {
+        if (!(ratio > 0.0))
+        {
+            throw std::invalid_argument("Compaction ratio must be positive!");
+        }
+
+        _records = load_journal(_snapshot, _log, _set);
+        trim_log();
+
+        _file = std::fopen(_log.c_str(), "a");
+        if (_file == nullptr)
+        {
+            throw std::runtime_error("File can't be opened!");
+        }
+    }
+
+    journaled_set(const journaled_set &other) = delete;
+
+    journaled_set &operator=(const journaled_set &other) = delete;
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Scrive le operazioni bufferizzate e chiude il journal, senza fsync.
+     */
+    ~journaled_set()
+    {
+        if (_file != nullptr)
+        {
+            std::fclose(_file);
+            _file = nullptr;
+        }
+    }
+
+    /**
+     * @brief aggiunge un elemento al set
+     *
+     * Aggiunge l'elemento al set in memoria e, se il set è cambiato, registra l'operazione nel journal.
+     * Se la scrittura sul journal fallisce, l'aggiunta in memoria viene annullata.
+     * Se necessario, compatta il journal.
+     *
+     * @param element valore da aggiungere al set
+     *
+     * @post contains(element) == true
+     *
+     * @throw std::runtime_error se la scrittura sul journal o la compattazione falliscono
+     * @throws std::bad_alloc se lanciata da set::add
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     */
+    void add(const T &element)
+    {
+        if (_set.contains(element))
+        {
+            return;
+        }
+
+        _set.add(element);
+        try
+        {
+            append('+', element);
+        }
+        catch (...)
+        {
+            _set.remove(element);
+            throw;
+        }
+        compact_if_needed();
+    }
+
+    /**
+     * @brief rimuove un elemento dal set
+     *
+     * Rimuove l'elemento dal set in memoria e, se il set è cambiato, registra l'operazione nel journal.
+     * Se la scrittura sul journal fallisce, la rimozione in memoria viene annullata.
+     * Se necessario, compatta il journal.
+     *
+     * @param element valore da rimuovere
+     *
+     * @post contains(element) == false
+     *
+     * @throw std::runtime_error se la scrittura sul journal o la compattazione falliscono
+     * @throws std::bad_alloc se lanciata da set::remove
+     * @throws ... eventuali eccezioni lanciate dal confronto o dall'assegnamento di T
+     */
+    void remove(const T &element)
+    {
+        if (!_set.contains(element))
+        {
+            return;
+        }
+
+        _set.remove(element);
+        try
+        {
+            append('-', element);
+        }
+        catch (...)
+        {
+            _set.add(element);
+            throw;
+        }
+        compact_if_needed();
+    }
+
+    /**
+     * @brief ricerca un elemento nel set
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     *
+     * @return true se l'elemento è presente, false altrimenti
+     */
+    bool contains(const T &element) const
+    {
+        return _set.contains(element);
+    }
+
+    /**
+     * @brief metodo per la cardinalità del set
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return cardinalità del set
+     */
+    unsigned int size() const
+    {
+        return _set.size();
+    }
+
+    /**
+     * @brief accesso al set in memoria
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return reference costante al set in memoria
+     */
+    const set<T, Eql, Hash> &get() const
+    {
+        return _set;
+    }
+
+    /**
+     * @brief numero di operazioni nel journal
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return numero di operazioni registrate dall'ultimo snapshot
+     */
+    unsigned int journal_records() const
+    {
+        return _records;
+    }
+
+    /**
+     * @brief rende durabili le operazioni registrate
+     *
+     * Scrive le operazioni bufferizzate sul journal e attende che siano su disco con fsync.
+     *
+     * @throw std::runtime_error se la scrittura o fsync falliscono
+     */
+    void sync()
+    {
+        if (std::fflush(_file) != 0 || fsync(fileno(_file)) != 0)
+        {
+            throw std::runtime_error("Journal can't be synced!");
+        }
+    }
+
+    /**
+     * @brief compatta il journal in un nuovo snapshot
+     *
+     * Salva il set in un file temporaneo e lo rende durabile con fsync, lo rinomina sullo snapshot,
+     * rende durabile la rinomina con fsync sulla directory e solo allora svuota il journal.
+     * In caso di interruzione rimane quindi valido lo snapshot precedente con il suo journal,
+     * oppure il nuovo snapshot completo con il vecchio journal, che riapplicato porta allo stesso set.
+     *
+     * @post journal_records() == 0
+     *
+     * @throw std::runtime_error se uno dei file non può essere scritto o reso durabile
+     */
+    void checkpoint()
+    {
+        sync();
+
+        std::string tmp = _snapshot + ".tmp";
+        write_snapshot(tmp);
+
+        if (std::rename(tmp.c_str(), _snapshot.c_str()) != 0)
+        {
+            throw std::runtime_error("Snapshot can't be replaced!");
+        }
+
+        sync_directory();
+
+        std::FILE *file = std::fopen(_log.c_str(), "w");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("File can't be opened!");
+        }
+
+        std::fclose(_file);
+        _file = file;
+        _records = 0;
+    }
+
+private:
+    /**
+     * @brief registra un'operazione nel journal
+     *
+     * Scrive la riga dell'operazione nel buffer del journal.
+     *
+     * @param op '+' per un'aggiunta, '-' per una rimozione
+     * @param element elemento dell'operazione
+     *
+     * @throw std::runtime_error se la scrittura fallisce
+     */
+    void append(char op, const T &element)
+    {
+        std::ostringstream oss;
+        oss << op << ' ' << element << '\n';
+        const std::string record = oss.str();
+
+        if (std::fwrite(record.data(), 1, record.size(), _file) != record.size())
+        {
+            throw std::runtime_error("Journal can't be written!");
+        }
+
+        ++_records;
+    }
+
+    /**
+     * @brief taglia dal journal un'ultima riga incompleta
+     *
+     * Riduce il file al carattere successivo all'ultimo '\n', oppure a lunghezza zero se non ne contiene.
+     * Se il file non esiste non fa nulla.
+     *
+     * @throw std::runtime_error se il file non può essere letto o ridimensionato
+     */
+    void trim_log() const
+    {
+        std::ifstream ifs(_log, std::ios::binary | std::ios::ate);
+        if (!ifs.is_open())
+        {
+            return;
+        }
+
+        const std::streamoff size = ifs.tellg();
+        std::streamoff end = size;
+        char buffer[4096];
+        while (end > 0)
+        {
+            const std::streamoff chunk = end < static_cast<std::streamoff>(sizeof(buffer)) ? end : sizeof(buffer);
+            ifs.seekg(end - chunk);
+            if (!ifs.read(buffer, chunk))
+            {
+                throw std::runtime_error("File can't be opened!");
+            }
+
+            std::streamoff i = chunk;
+            while (i > 0 && buffer[i - 1] != '\n')
+            {
+                --i;
+            }
+            end -= chunk - i;
+            if (i > 0)
+            {
+                break;
+            }
+        }
+        ifs.close();
+
+        if (end != size)
+        {
+            std::error_code ec;
+            std::filesystem::resize_file(_log, static_cast<std::uintmax_t>(end), ec);
+            if (ec)
+            {
+                throw std::runtime_error("Journal can't be written!");
+            }
+        }
+    }
+
+    /**
+     * @brief compatta il journal se necessario
+     *
+     * Chiama checkpoint se il journal ha superato ratio volte la dimensione del set.
+     *
+     * @throw std::runtime_error se la compattazione fallisce
+     */
+    void compact_if_needed()
+    {
+        if (_records >= MIN_COMPACTION && _records > _ratio * _set.size())
+        {
+            checkpoint();
+        }
+    }
+
+    /**
+     * @brief scrive uno snapshot durabile
+     *
+     * Scrive il set nel formato di save e attende che il file sia su disco con fsync.
+     *
+     * @param filename file da scrivere
+     *
+     * @throw std::runtime_error se il file non può essere scritto o reso durabile
+     */
+    void write_snapshot(const std::string &filename) const
+    {
+        std::FILE *file = std::fopen(filename.c_str(), "w");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("File can't be opened!");
+        }
+
+        std::ostringstream oss;
+        oss << _set.size() << '\n';
+        bool ok = true;
+
+        auto flush_chunk = [&]()
+        {
+            const std::string chunk = oss.str();
+            ok = ok && std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+            oss.str("");
+        };
+
+        // gli elementi vengono formattati a blocchi per non tenere in memoria l'intero file
+        for (auto i = _set.begin(), ie = _set.end(); i != ie; ++i)
+        {
+            oss << *i << '\n';
+            if (oss.tellp() >= 65536)
+            {
+                flush_chunk();
+            }
+        }
+        flush_chunk();
+
+        ok = ok && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok)
+        {
+            throw std::runtime_error("File can't be written!");
+        }
+    }
+
+    /**
+     * @brief rende durabili le rinomine nella directory dello snapshot
+     *
+     * @throw std::runtime_error se fsync sulla directory fallisce
+     */
+    void sync_directory() const
+    {
+        std::string directory = std::filesystem::path(_snapshot).parent_path().string();
+        if (directory.empty())
+        {
+            directory = ".";
+        }
+
+        const int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        const bool ok = fd >= 0 && fsync(fd) == 0;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        if (!ok)
+        {
+            throw std::runtime_error("Snapshot can't be replaced!");
+        }
+    }
+}; // journaled_set
+
+#endif
@@ -0,0 +1,507 @@
+/**
+ * @file packed_io.hpp
+ *
+ * @brief file di dichiarazione e definizione del formato compresso per i set
+ *
+ * File di dichiarazione e definizione del formato binario compresso per salvare su file
+ * set di interi o di tipi riconducibili a coordinate intere.
+ * Contiene:
+ * - l'enumerazione set_format per scegliere il formato di save e load
+ * - il trait packed_traits, con la specializzazione per int
+ * - le versioni di save e load con il parametro di formato
+ */
+#ifndef PACKED_IO_HPP
+#define PACKED_IO_HPP
+
+#include <cstdint>   // std::int64_t, std::uint64_t, std::uint32_t
+#include <cstring>   // std::memcpy
+#include <array>     // std::array
+#include <algorithm> // std::sort, std::lexicographical_compare, std::equal, std::copy
+#include <fstream>   // ofstream, ifstream
+#include <string>    // std::string
+#include <stdexcept> // std::runtime_error
+#include "set.hpp"
+
+/**
+ * @brief formato di salvataggio di un set su file
+ *
+ * - text: formato testuale di save, un elemento per riga
+ * - packed: formato binario compresso, disponibile per i tipi con una specializzazione di packed_traits
+ */
+enum class set_format
+{
+    text,
+    packed
+};
+
+/**
+ * @brief trait per la conversione di un tipo in coordinate intere
+ *
+ * Per poter usare il formato compresso con un tipo T va specializzato questo trait con:
+ * - COORDS: numero di coordinate intere dell'elemento
+ * - to_coords(const T &, std::int64_t *): scrive le coordinate dell'elemento
+ * - from_coords(const std::int64_t *): ricostruisce l'elemento dalle coordinate
+ * Elementi equivalenti devono avere le stesse coordinate.
+ */
+template <typename T>
+struct packed_traits;
+
+/**
+ * @brief specializzazione di packed_traits per gli interi
+ *
+ * Un intero ha una sola coordinata, il suo valore.
+ */
+template <>
+struct packed_traits<int>
+{
+    static const unsigned int COORDS = 1; ///< numero di coordinate
+
+    /**
+     * @brief coordinate di un intero
+     *
+     * @param value intero da convertire
+     * @param coords array di una coordinata in cui scrivere il valore
+     */
+    static void to_coords(const int &value, std::int64_t *coords)
+    {
+        coords[0] = value;
+    }
+
+    /**
+     * @brief intero a partire dalle coordinate
+     *
+     * @param coords array di una coordinata
+     *
+     * @return l'intero corrispondente
+     */
+    static int from_coords(const std::int64_t *coords)
+    {
+        return static_cast<int>(coords[0]);
+    }
+};
+
+/**
+ * @brief funzioni di supporto al formato compresso
+ *
+ * Il formato compresso è così organizzato:
+ * - intestazione: "SETP", versione (1 byte), numero di coordinate (1 byte),
+ *   numero di elementi e numero di blocchi (4 byte little endian ciascuno)
+ * - blocchi di al più BLOCK elementi, ognuno con numero di elementi e lunghezza in byte (4 byte ciascuno)
+ *   seguiti da una sequenza per ogni coordinata
+ * Gli elementi sono ordinati lessicograficamente per coordinate.
+ * Ogni sequenza contiene le differenze tra la coordinata di un elemento e quella dell'elemento precedente,
+ * codificate zig-zag e poi varint (7 bit per byte, il bit alto indica che seguono altri byte).
+ * Ogni blocco parte da zero, quindi è decodificabile indipendentemente dagli altri.
+ */
+namespace packed_detail
+{
+    const unsigned int BLOCK = 1024;  ///< numero massimo di elementi in un blocco
+    const unsigned char VERSION = 1;  ///< versione del formato
+    const unsigned int MAX_VARINT = 10; ///< byte massimi di un varint a 64 bit
+
+    /**
+     * @brief codifica zig-zag
+     *
+     * Mappa gli interi con segno su quelli senza segno in modo che i valori piccoli in modulo restino piccoli.
+     *
+     * @param v valore con segno
+     *
+     * @return valore codificato
+     */
+    inline std::uint64_t zigzag(std::int64_t v)
+    {
+        return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+    }
+
+    /**
+     * @brief decodifica zig-zag
+     *
+     * @param u valore codificato
+     *
+     * @return valore con segno
+     */
+    inline std::int64_t unzigzag(std::uint64_t u)
+    {
+        return static_cast<std::int64_t>(u >> 1) ^ -static_cast<std::int64_t>(u & 1);
+    }
+
+    /**
+     * @brief scrive un intero a 32 bit little endian
+     *
+     * @param os stream di output
+     * @param v valore da scrivere
+     */
+    inline void write_u32(std::ostream &os, std::uint32_t v)
+    {
+        unsigned char bytes[4] = {static_cast<unsigned char>(v), static_cast<unsigned char>(v >> 8),
+                                  static_cast<unsigned char>(v >> 16), static_cast<unsigned char>(v >> 24)};
+        os.write(reinterpret_cast<const char *>(bytes), 4);
+    }
+
+    /**
+     * @brief legge un intero a 32 bit little endian
+     *
+     * @param is stream di input
+     *
+     * @return valore letto
+     *
+     * @throw std::runtime_error se il file termina prima
+     */
+    inline std::uint32_t read_u32(std::istream &is)
+    {
+        unsigned char bytes[4];
+        if (!is.read(reinterpret_cast<char *>(bytes), 4))
+        {
+            throw std::runtime_error("Corrupted file!");
+        }
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+    }
+
+    /**
+     * @brief scrive un varint
+     *
+     * @param out puntatore al buffer, avanzato oltre i byte scritti
+     * @param v valore da scrivere
+     */
+    inline void put_varint(unsigned char *&out, std::uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            *out++ = static_cast<unsigned char>(v | 0x80);
+            v >>= 7;
+        }
+        *out++ = static_cast<unsigned char>(v);
+    }
+
+    /**
+     * @brief decodifica una sequenza di varint
+     *
+     * Decodifica count varint a partire da in e ne scrive i valori in out.
+     * Quando gli 8 byte successivi sono tutti varint da un byte (nessun bit alto impostato,
+     * verificato con una sola maschera su una parola a 64 bit) vengono decodificati in blocco:
+     * è il caso comune per le differenze tra elementi ordinati e vicini.
+     * Altrimenti si procede un varint alla volta.
+     *
+     * @param in puntatore al primo byte
+     * @param end puntatore alla fine del buffer
+     * @param out array di almeno count valori
+     * @param count numero di varint da decodificare
+     *
+     * @return puntatore al primo byte non decodificato
+     *
+     * @throw std::runtime_error se il buffer termina prima o contiene un varint non valido
+     */
+    inline const unsigned char *get_varints(const unsigned char *in, const unsigned char *end, std::uint64_t *out, unsigned int count)
+    {
+        unsigned int i = 0;
+        while (i < count)
+        {
+            if (count - i >= 8 && end - in >= 8)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, in, 8);
+                if ((word & 0x8080808080808080ULL) == 0)
+                {
+                    for (unsigned int j = 0; j < 8; ++j)
+                    {
+                        out[i + j] = in[j];
+                    }
+                    in += 8;
+                    i += 8;
+                    continue;
+                }
+            }
+
+            std::uint64_t v = 0;
+            unsigned int shift = 0;
+            while (true)
+            {
+                if (in == end || shift >= 64)
+                {
+                    throw std::runtime_error("Corrupted file!");
+                }
+
+                unsigned char byte = *in++;
+                v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    break;
+                }
+                shift += 7;
+            }
+            out[i++] = v;
+        }
+
+        return in;
+    }
+}
+
+/**
+ * @brief funzione per salvare un set su file nel formato compresso
+ *
+ * Ordina gli elementi per coordinate e li scrive a blocchi come differenze zig-zag varint.
+ * È necessaria una specializzazione di packed_traits per T.
+ *
+ * @param s set da salvare
+ * @param filename stringa contenente il file da salvare
+ *
+ * @throw std::runtime_error se il file non viene aperto
+ * @throws std::bad_alloc se l'allocazione dei buffer fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+void save_packed(const set<T, Eql, Hash> &s, const std::string &filename)
+{
+    using namespace packed_detail;
+    typedef packed_traits<T> traits;
+    typedef std::array<std::int64_t, traits::COORDS> row;
+
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    const unsigned int n = s.size();
+    const unsigned int blocks = (n + BLOCK - 1) / BLOCK;
+
+    row *rows = new row[n];
+    unsigned char *buffer = nullptr;
+
+    try
+    {
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            traits::to_coords(s[i], rows[i].data());
+        }
+        std::sort(rows, rows + n);
+
+        buffer = new unsigned char[BLOCK * traits::COORDS * MAX_VARINT];
+
+        ofs.write("SETP", 4);
+        ofs.put(static_cast<char>(VERSION));
+        ofs.put(static_cast<char>(traits::COORDS));
+        write_u32(ofs, n);
+        write_u32(ofs, blocks);
+
+        for (unsigned int b = 0; b < blocks; ++b)
+        {
+            unsigned int first = b * BLOCK;
+            unsigned int count = (n - first < BLOCK) ? n - first : BLOCK;
+
+            unsigned char *out = buffer;
+            for (unsigned int c = 0; c < traits::COORDS; ++c)
+            {
+                std::int64_t previous = 0;
+                for (unsigned int i = first; i < first + count; ++i)
+                {
+                    put_varint(out, zigzag(rows[i][c] - previous));
+                    previous = rows[i][c];
+                }
+            }
+
+            write_u32(ofs, count);
+            write_u32(ofs, static_cast<std::uint32_t>(out - buffer));
+            ofs.write(reinterpret_cast<const char *>(buffer), out - buffer);
+        }
+    }
+    catch (...)
+    {
+        delete[] rows;
+        delete[] buffer;
+        throw;
+    }
+
+    delete[] rows;
+    delete[] buffer;
+    ofs.close();
+}
+
+/**
+ * @brief funzione per leggere un set da un file nel formato compresso
+ *
+ * Legge i blocchi scritti da save_packed, decodificando ogni coordinata di un blocco in un'unica passata.
+ * L'array viene allocato una sola volta dal numero di elementi dell'intestazione e gli elementi
+ * vengono accodati senza cercarli: sono distinti perché il file deve contenerli in ordine strettamente crescente
+ * di coordinate, e ogni riga viene verificata.
+ * Se s ha il filtro di Bloom o la cache degli hash abilitati, il set letto li mantiene.
+ *
+ * @param filename nome del file da leggere
+ * @param s set in cui leggere i dati
+ *
+ * @throw std::runtime_error se il file non esiste o non è nel formato compresso per T, ad esempio se gli elementi
+ *        non sono in ordine strettamente crescente o le coordinate non rappresentano un elemento di T
+ * @throws std::bad_alloc se l'allocazione dei buffer, dell'array o del filtro fallisce
+ * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+ */
+template <typename T, typename Eql, typename Hash>
+void load_packed(const std::string &filename, set<T, Eql, Hash> &s)
+{
+    using namespace packed_detail;
+    typedef packed_traits<T> traits;
+
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    char header[6];
+    if (!ifs.read(header, 6) || std::memcmp(header, "SETP", 4) != 0 ||
+        static_cast<unsigned char>(header[4]) != VERSION ||
+        static_cast<unsigned char>(header[5]) != traits::COORDS)
+    {
+        throw std::runtime_error("Corrupted file!");
+    }
+
+    const std::uint32_t n = read_u32(ifs);
+    const std::uint32_t blocks = read_u32(ifs);
+
+    // ogni elemento occupa almeno un byte per coordinata: un conteggio maggiore non viene da save_packed
+    const std::streamoff start = ifs.tellg();
+    ifs.seekg(0, std::ios::end);
+    const std::streamoff remaining = ifs.tellg() - start;
+    ifs.seekg(start);
+    if (static_cast<std::uint64_t>(n) * traits::COORDS > static_cast<std::uint64_t>(remaining))
+    {
+        throw std::runtime_error("Corrupted file!");
+    }
+
+    set<T, Eql, Hash> temp;
+    if constexpr (is_hash_enabled<Hash>::value)
+    {
+        if (s.has_filter())
+        {
+            temp.enable_filter(s.filter_fp_rate());
+        }
+        if (s.has_hash_cache())
+        {
+            temp.enable_hash_cache();
+        }
+    }
+    temp.reserve(n);
+
+    const unsigned int capacity = BLOCK * traits::COORDS * MAX_VARINT;
+    unsigned char *buffer = new unsigned char[capacity];
+    std::uint64_t *values = nullptr;
+
+    try
+    {
+        values = new std::uint64_t[BLOCK * traits::COORDS];
+
+        std::uint32_t total = 0;
+        std::int64_t previous[traits::COORDS] = {}; // coordinate dell'ultimo elemento letto
+        for (std::uint32_t b = 0; b < blocks; ++b)
+        {
+            const std::uint32_t count = read_u32(ifs);
+            const std::uint32_t bytes = read_u32(ifs);
+            if (count > BLOCK || bytes > capacity ||
+                !ifs.read(reinterpret_cast<char *>(buffer), bytes))
+            {
+                throw std::runtime_error("Corrupted file!");
+            }
+
+            const unsigned char *in = buffer;
+            const unsigned char *end = buffer + bytes;
+            for (unsigned int c = 0; c < traits::COORDS; ++c)
+            {
+                in = get_varints(in, end, values + c * BLOCK, count);
+            }
+
+            std::int64_t coords[traits::COORDS] = {};
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                for (unsigned int c = 0; c < traits::COORDS; ++c)
+                {
+                    // somma modulo 2^64: un file corrotto non deve causare overflow con segno
+                    coords[c] = static_cast<std::int64_t>(static_cast<std::uint64_t>(coords[c]) +
+                                                          static_cast<std::uint64_t>(unzigzag(values[c * BLOCK + i])));
+                }
+
+                // le righe devono essere strettamente crescenti, quindi distinte, e rappresentare un elemento
+                if (temp._size == n ||
+                    (temp._size > 0 && !std::lexicographical_compare(previous, previous + traits::COORDS,
+                                                                     coords, coords + traits::COORDS)))
+                {
+                    throw std::runtime_error("Corrupted file!");
+                }
+                const T element = traits::from_coords(coords);
+                std::int64_t check[traits::COORDS];
+                traits::to_coords(element, check);
+                if (!std::equal(check, check + traits::COORDS, coords))
+                {
+                    throw std::runtime_error("Corrupted file!");
+                }
+
+                temp.append(element);
+                std::copy(coords, coords + traits::COORDS, previous);
+            }
+
+            total += count;
+        }
+
+        if (total != n)
+        {
+            throw std::runtime_error("Corrupted file!");
+        }
+    }
+    catch (...)
+    {
+        delete[] buffer;
+        delete[] values;
+        throw;
+    }
+
+    delete[] buffer;
+    delete[] values;
+
+    s = temp;
+    ifs.close();
+}
+
+/**
+ * @brief funzione per salvare un set su file nel formato scelto
+ *
+ * @param s set da salvare
+ * @param filename stringa contenente il file da salvare
+ * @param format formato del file
+ *
+ * @throw std::runtime_error se il file non viene aperto
+ */
+template <typename T, typename Eql, typename Hash>
+void save(const set<T, Eql, Hash> &s, const std::string &filename, set_format format)
+{
+    if (format == set_format::packed)
+    {
+        save_packed(s, filename);
+    }
+    else
+    {
+        save(s, filename);
+    }
+}
+
+/**
+ * @brief funzione per leggere un set da un file nel formato scelto
+ *
+ * @param filename nome del file da leggere
+ * @param s set in cui leggere i dati
+ * @param format formato del file
+ *
+ * @throw std::runtime_error se il file non esiste o non è nel formato indicato
+ * @throws std::bad_alloc dal metodo add
+ * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+ */
+template <typename T, typename Eql, typename Hash>
+void load(const std::string &filename, set<T, Eql, Hash> &s, set_format format)
+{
+    if (format == set_format::packed)
+    {
+        load_packed(filename, s);
+    }
+    else
+    {
+        load(filename, s);
+    }
+}
+
+#endif
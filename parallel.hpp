@@ -0,0 +1,106 @@
+/**
+ * @file parallel.hpp
+ *
+ * @brief file di dichiarazione e definizione delle funzioni di supporto al parallelismo
+ *
+ * File di dichiarazione e definizione delle funzioni usate dagli algoritmi paralleli sui set.
+ */
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+
+/**
+ * @brief esegue un lavoro su più thread
+ *
+ * Chiama job(t) per t=0,...,threads-1, ognuna su un thread diverso (la prima sul thread chiamante),
+ * e attende che tutte terminino.
+ * Se una o più chiamate lanciano un'eccezione, dopo l'attesa viene rilanciata quella del thread con indice minore.
+ *
+ * @param threads numero di thread da usare
+ * @param job funzione che prende in input l'indice del thread
+ *
+ * @throws std::system_error se la creazione di un thread fallisce
+ * @throws ... la prima eccezione lanciata da job
+ */
+template <typename Job>
+void parallel_run(unsigned int threads, Job job)
+{
+    if (threads <= 1)
+    {
+        job(0u);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    try
+    {
+        for (unsigned int t = 1; t < threads; ++t)
+        {
+            workers.emplace_back([&job, &errors, t]() {
+                try
+                {
+                    job(t);
+                }
+                catch (...)
+                {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+    }
+    catch (...)
+    {
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        throw;
+    }
+
+    try
+    {
+        job(0u);
+    }
+    catch (...)
+    {
+        errors[0] = std::current_exception();
+    }
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+        if (errors[t])
+        {
+            std::rethrow_exception(errors[t]);
+        }
+    }
+}
+
+/**
+ * @brief inizio della porzione di un intervallo assegnata a un thread
+ *
+ * Divide l'intervallo [0, count) in parti di dimensione il più possibile uguale.
+ * La porzione del thread t è [chunk_begin(count, threads, t), chunk_begin(count, threads, t + 1)).
+ *
+ * @param count dimensione dell'intervallo
+ * @param threads numero di parti
+ * @param t indice della parte
+ *
+ * @return primo indice della porzione
+ */
+inline unsigned int chunk_begin(unsigned int count, unsigned int threads, unsigned int t)
+{
+    return static_cast<unsigned int>(static_cast<unsigned long long>(count) * t / threads);
+}
+
+#endif
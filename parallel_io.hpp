@@ -0,0 +1,221 @@
+/**
+ * @file parallel_io.hpp
+ *
+ * @brief file di dichiarazione e definizione delle funzioni di salvataggio e lettura parallele
+ *
+ * File di dichiarazione e definizione delle versioni parallele di save e load,
+ * per file di testo grandi: la conversione degli elementi da e verso testo viene divisa tra più thread,
+ * mentre le scritture e le letture su disco restano sequenziali.
+ * I file hanno lo stesso formato, byte per byte, di quelli di save.
+ */
+#ifndef PARALLEL_IO_HPP
+#define PARALLEL_IO_HPP
+
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <fstream>   // ofstream, ifstream
+#include <sstream>   // ostringstream, istringstream
+#include <stdexcept> // std::runtime_error
+#include <string>    // std::string
+#include <vector>    // std::vector
+#include "parallel.hpp"
+#include "set.hpp"
+
+namespace parallel_io_detail
+{
+    static const unsigned int SAVE_CHUNK = 16384;   ///< elementi formattati da ogni thread per ogni scrittura
+    static const std::size_t LOAD_BLOCK = 1u << 20; ///< byte letti per ogni thread prima di ogni analisi
+}
+
+/**
+ * @brief funzione per salvare un set su un file usando più thread
+ *
+ * Salva il set nello stesso formato di save, producendo un file identico byte per byte.
+ * Gli elementi vengono divisi in blocchi di parallel_io_detail::SAVE_CHUNK elementi:
+ * a ogni passo ogni thread formatta un blocco in un proprio buffer e i buffer vengono poi scritti in ordine,
+ * quindi la memoria usata non dipende dalla dimensione del set.
+ * È necessario che la stampa su stream di T possa essere eseguita contemporaneamente da più thread.
+ *
+ * @param s set da salvare
+ * @param filename stringa contenente il file da salvare
+ * @param threads numero di thread da usare
+ *
+ * @throw std::runtime_error se il file non viene aperto o scritto
+ * @throws std::system_error se la creazione di un thread fallisce
+ * @throws std::bad_alloc se l'allocazione dei buffer fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+void save_parallel(const set<T, Eql, Hash> &s, const std::string &filename, unsigned int threads)
+{
+    std::ofstream ofs(filename);
+    if (!ofs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    ofs << s.size() << '\n';
+
+    const unsigned int parts = threads > 1 ? threads : 1;
+    const unsigned long long step = static_cast<unsigned long long>(parallel_io_detail::SAVE_CHUNK) * parts;
+    std::vector<std::string> buffers(parts);
+
+    for (unsigned long long base = 0; base < s.size(); base += step)
+    {
+        const unsigned int round = static_cast<unsigned int>(s.size() - base < step ? s.size() - base : step);
+
+        parallel_run(parts, [&](unsigned int t) {
+            const unsigned int begin = static_cast<unsigned int>(base) + chunk_begin(round, parts, t);
+            const unsigned int end = static_cast<unsigned int>(base) + chunk_begin(round, parts, t + 1);
+
+            std::ostringstream oss;
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                oss << s[i] << '\n';
+            }
+            buffers[t] = oss.str();
+        });
+
+        for (const std::string &buffer : buffers)
+        {
+            ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+
+        if (!ofs)
+        {
+            throw std::runtime_error("File can't be written!");
+        }
+    }
+
+    ofs.close();
+    if (!ofs)
+    {
+        throw std::runtime_error("File can't be written!");
+    }
+}
+
+/**
+ * @brief funzione per leggere un set da un file di testo usando più thread
+ *
+ * Legge un file nel formato di save. Il file viene letto a blocchi di parallel_io_detail::LOAD_BLOCK byte per thread;
+ * ogni blocco viene tagliato dopo l'ultima riga completa e diviso tra i thread a inizio riga,
+ * ogni thread converte le proprie righe in elementi con l'operatore di lettura da stream di T
+ * e infine le porzioni vengono aggiunte al set nell'ordine del file con add_many, che elimina i duplicati
+ * e rialloca l'array una sola volta per porzione.
+ * Il set risultante ha quindi gli stessi elementi, nello stesso ordine, di quello letto da load.
+ * Come load, legge solo il numero di elementi indicato nella prima riga e,
+ * se s ha il filtro di Bloom o la cache degli hash abilitati, il set letto li mantiene.
+ * In caso di errore s rimane invariato.
+ *
+ * @param filename stringa contenente il file da leggere
+ * @param s set in cui leggere il file
+ * @param threads numero di thread da usare
+ *
+ * @throw std::runtime_error se il file non esiste, se un elemento non può essere letto
+ *        o se il file contiene meno elementi di quelli dichiarati
+ * @throws std::system_error se la creazione di un thread fallisce
+ * @throws std::bad_alloc dal metodo add_many o se l'allocazione dei buffer fallisce
+ * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+ */
+template <typename T, typename Eql, typename Hash>
+void load_parallel(const std::string &filename, set<T, Eql, Hash> &s, unsigned int threads)
+{
+    std::ifstream ifs(filename);
+    if (!ifs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    set<T, Eql, Hash> temp;
+    if constexpr (is_hash_enabled<Hash>::value)
+    {
+        if (s.has_filter())
+        {
+            temp.enable_filter(s.filter_fp_rate());
+        }
+        if (s.has_hash_cache())
+        {
+            temp.enable_hash_cache();
+        }
+    }
+
+    unsigned int count;
+    if (!(ifs >> count))
+    {
+        throw std::runtime_error("Corrupted file!");
+    }
+
+    const unsigned int parts = threads > 1 ? threads : 1;
+    std::vector<std::vector<T>> chunks(parts);
+    std::vector<std::size_t> cuts(parts + 1);
+    std::vector<std::uint64_t> mask;
+    std::string text; // testo letto e non ancora analizzato
+    unsigned int read = 0;
+    bool finished = false;
+
+    while (read < count && !finished)
+    {
+        const std::size_t old = text.size();
+        text.resize(old + parallel_io_detail::LOAD_BLOCK * parts);
+        ifs.read(&text[old], static_cast<std::streamsize>(parallel_io_detail::LOAD_BLOCK * parts));
+        text.resize(old + static_cast<std::size_t>(ifs.gcount()));
+        finished = !ifs;
+
+        // le righe incomplete restano in text fino alla lettura successiva
+        std::size_t end = text.size();
+        if (!finished)
+        {
+            end = text.rfind('\n');
+            if (end == std::string::npos)
+            {
+                continue;
+            }
+            ++end;
+        }
+
+        cuts[0] = 0;
+        cuts[parts] = end;
+        for (unsigned int t = 1; t < parts; ++t)
+        {
+            std::size_t pos = end / parts * t;
+            pos = pos < cuts[t - 1] ? cuts[t - 1] : pos;
+            pos = text.find('\n', pos);
+            cuts[t] = pos == std::string::npos || pos >= end ? end : pos + 1;
+        }
+
+        parallel_run(parts, [&](unsigned int t) {
+            chunks[t].clear();
+
+            std::istringstream iss(text.substr(cuts[t], cuts[t + 1] - cuts[t]));
+            T val;
+            while (iss >> val)
+            {
+                chunks[t].push_back(val);
+            }
+
+            if (!iss.eof())
+            {
+                throw std::runtime_error("Corrupted file!");
+            }
+        });
+
+        for (const std::vector<T> &chunk : chunks)
+        {
+            const std::size_t n = chunk.size() < count - read ? chunk.size() : count - read;
+            mask.resize((n + 63) / 64);
+            temp.add_many(chunk.begin(), chunk.begin() + n, mask.data());
+            read += static_cast<unsigned int>(n);
+        }
+
+        text.erase(0, end);
+    }
+
+    if (read < count)
+    {
+        throw std::runtime_error("Corrupted file!");
+    }
+
+    s = temp;
+    ifs.close();
+}
+
+#endif
@@ -8,9 +8,11 @@
 #include <iostream>
 #include "point.h"
 
-bool ArePointEqual::operator()(const point &a, const point &b) const
+std::size_t PointHash::operator()(const point &p) const
 {
-    return a.x == b.x && a.y == b.y;
+    unsigned long long x = static_cast<unsigned int>(p.x);
+    unsigned long long y = static_cast<unsigned int>(p.y);
+    return static_cast<std::size_t>((x << 32) | y);
 }
 
 std::ostream &operator<<(std::ostream &os, const point &p)
@@ -5,12 +5,14 @@
  *
  * File di dichiarazione della struct point.
  * Contiene anche la dichiarazione delle funzioni per lettura e scrittura su stream.
- * VIene dichiarato anche un funtore per confrontare due punti.
+ * VIene dichiarato anche un funtore per confrontare due punti, uno per ordinarli e uno per calcolarne l'hash.
  */
 #ifndef POINT_H
 #define POINT_H
 
 #include <iostream>
+#include <cstddef> // std::size_t
+#include <cstdint> // std::int64_t
 
 /**
  * @brief struct point
@@ -34,13 +36,98 @@ struct ArePointEqual
      * @brief operatore () di confronto tra due punti
      *
      * Ritorna se i due punti sono uguali.
+     * È constexpr per poter essere usato nella costruzione di static_set a tempo di compilazione.
      *
      * @param a primo punto
      * @param b secondo punto
      *
      * @return true se a equivale a b, false altrimenti
      */
-    bool operator()(const point &a, const point &b) const;
+    constexpr bool operator()(const point &a, const point &b) const
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+};
+
+/**
+ * @brief funtore di hash per un punto
+ *
+ * Funtore di hash per un punto, coerente con ArePointEqual.
+ */
+struct PointHash
+{
+    /**
+     * @brief operatore () di hash di un punto
+     *
+     * Combina le due coordinate in un unico valore di hash.
+     * Due punti uguali secondo ArePointEqual hanno lo stesso hash.
+     *
+     * @param p punto di cui calcolare l'hash
+     *
+     * @return valore di hash del punto
+     */
+    std::size_t operator()(const point &p) const;
+};
+
+/**
+ * @brief funtore di ordinamento tra due punti
+ *
+ * Ordina i punti per x e, a parità di x, per y.
+ * Due punti sono equivalenti per questo ordinamento se e solo se sono uguali secondo ArePointEqual.
+ */
+struct PointLess
+{
+    /**
+     * @brief operatore () di ordinamento tra due punti
+     *
+     * @param a primo punto
+     * @param b secondo punto
+     *
+     * @return true se a precede b, false altrimenti
+     */
+    constexpr bool operator()(const point &a, const point &b) const
+    {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    }
+};
+
+template <typename T>
+struct packed_traits; // definito in packed_io.hpp
+
+/**
+ * @brief specializzazione di packed_traits per un punto
+ *
+ * Permette di salvare set di punti nel formato compresso.
+ * Un punto ha due coordinate: x e y.
+ */
+template <>
+struct packed_traits<point>
+{
+    static const unsigned int COORDS = 2; ///< numero di coordinate
+
+    /**
+     * @brief coordinate di un punto
+     *
+     * @param p punto da convertire
+     * @param coords array di due coordinate in cui scrivere x e y
+     */
+    static void to_coords(const point &p, std::int64_t *coords)
+    {
+        coords[0] = p.x;
+        coords[1] = p.y;
+    }
+
+    /**
+     * @brief punto a partire dalle coordinate
+     *
+     * @param coords array di due coordinate
+     *
+     * @return il punto corrispondente
+     */
+    static point from_coords(const std::int64_t *coords)
+    {
+        return {static_cast<int>(coords[0]), static_cast<int>(coords[1])};
+    }
 };
 
 /**
@@ -17,33 +17,100 @@
 #include <ostream>   // ostream
 #include <istream>   // istream
 #include <fstream>   // ofstream, ifstream
-#include <algorithm> // swap
-#include <iterator>  // std::forward_iterator_tag
+#include <algorithm> // swap, std::sort
+#include <iterator>  // std::random_access_iterator_tag, std::contiguous_iterator_tag
 #include <cstddef>   // std::ptrdiff_t
 #include <stdexcept> // std::logic_error, std::runtime_error
 #include <cassert>   // assert
 #include <string>
+#include <vector>    // std::vector
+#include <cstdint>   // std::uint32_t, std::uint64_t
+#include <cstring>   // std::memcpy
+#include <atomic>    // std::atomic
+#include <type_traits> // std::is_base_of, std::is_arithmetic, std::is_same
+#include <memory>    // std::addressof
+#include <functional> // std::equal_to, std::less
+#include <utility>   // std::move, std::pair
+#if __cplusplus >= 202002L
+#include <span> // std::span
+#endif
+#include "hashing.hpp"
+#include "bloom_filter.hpp"
+#include "hash_index.hpp"
+#include "parallel.hpp"
+#include "storage.hpp"
+#include "footprint.hpp"
+#include "trace.hpp"
 
 /**
  * @brief classe set che rappresenta un insieme
  *
  * La classe set rappresenta un insieme di elementi senza duplicati, in cui l'ordine non conta.
- * È templata su due tipi, che rappresentano:
+ * È templata su tre tipi, che rappresentano:
  * - T: tipo contenuto nel set. È importante che gli oggetti di questo tipo implementino un metodo per stampare su stream
  * - Eql: funtore che prende in input due oggetti di tipo T e ritorna vero se sono equivalenti, falso altrimenti
+ * - Hash: funtore opzionale che prende in input un oggetto di tipo T e ritorna un valore di hash.
+ *   Elementi equivalenti secondo Eql devono avere lo stesso hash.
+ *   Il default no_hash indica che non è disponibile alcuna funzione di hash
  *
  * Per rispettare il requisito della minima occupazione di memoria possibile si è scelto di implementare il set mediante un array.
  * Questo array viene ridimensionato ad ogni aggiunta o rimozione di un elemento.
+ * Quando il numero di elementi da aggiungere è noto in anticipo, reserve permette di allocare l'array una sola volta.
+ *
+ * L'array e il filtro sono condivisi tra le copie di un set (copy-on-write):
+ * copiare un set costa O(1) e incrementa un contatore atomico di riferimenti;
+ * la prima modifica su una copia condivisa ne crea una versione privata.
+ * Più thread possono leggere contemporaneamente set diversi che condividono la stessa memoria.
+ *
+ * Se è disponibile un funtore di hash, è possibile abilitare un filtro di Bloom (enable_filter)
+ * che permette a contains di scartare la maggior parte degli elementi assenti senza scorrere l'array.
+ *
+ * Sempre se è disponibile un funtore di hash, la rappresentazione si adatta alla dimensione del set:
+ * finché gli elementi sono pochi, contains scorre l'array, che per pochi elementi è la soluzione più veloce;
+ * superata una soglia (index_threshold) all'array viene affiancato un hash_index che rende le ricerche O(1),
+ * condiviso tra le copie insieme all'array. L'indice viene eliminato quando il set scende sotto metà soglia.
+ * L'array resta l'unica copia degli elementi, quindi ordine, operator[] e iteratori non cambiano.
+ *
+ * Per elementi con un confronto costoso è possibile abilitare una cache degli hash (enable_hash_cache):
+ * accanto a ogni elemento viene memorizzato il suo hash a 32 bit, le ricerche lineari confrontano prima gli hash
+ * e chiamano Eql solo sugli elementi con lo stesso hash, e gli hash memorizzati vengono riusati da ==, -, +
+ * e dalla ricostruzione dell'indice, così che ogni elemento venga passato a Hash una sola volta.
+ *
+ * L'array è memoria non inizializzata di _capacity celle, di cui solo le prime _size contengono elementi costruiti:
+ * le celle libere non vengono costruite di default. Quando l'array non è condiviso, il ridimensionamento
+ * sposta gli elementi invece di copiarli: con realloc e memmove se T è banalmente copiabile,
+ * con il costruttore di spostamento se questo non lancia eccezioni (vedi storage.hpp).
+ *
+ * Compilando con -DSET_TRACING, add, remove, contains, +, -, filter_out, save e load registrano la propria durata
+ * in trace_registry (vedi trace.hpp); senza la macro non viene generato alcun codice di misura.
  */
-template <typename T, typename Eql>
+template <typename T, typename Eql, typename Hash = no_hash>
 class set
 {
 private:
-    T *_set;            ///< puntatore a un array di oggetti di tipo T
-    unsigned int _size; ///< dimensione dell'array
+    T *_set;                ///< puntatore a un array di oggetti di tipo T, allocato con storage_detail::allocate
+    unsigned int _size;     ///< numero di elementi del set
+    unsigned int _capacity; ///< dimensione dell'array, _size <= _capacity
+
+    bloom_filter<T, Hash> *_filter; ///< filtro di Bloom opzionale sugli elementi, nullptr se disabilitato
+
+    hash_index<T, Eql, Hash> *_index; ///< indice hash delle posizioni degli elementi, nullptr finché il set è piccolo
+
+    std::uint32_t *_hashes; ///< hash degli elementi come calcolati da hash_index::hash_of, di _capacity celle; nullptr se la cache è disabilitata o _capacity == 0
+    bool _hash_cache;       ///< true se la cache degli hash è abilitata
+
+    std::atomic<unsigned int> *_refs; ///< numero di set che condividono _set, _filter, _index e _hashes, nullptr se sono tutti nullptr
 
     Eql _eql; ///< istanza del funtore di confronto
 
+    inline static std::atomic<unsigned int> _index_threshold{8}; ///< soglia oltre la quale viene creato l'indice hash
+
+    static const unsigned int NO_POSITION = 0xFFFFFFFFu; ///< posizione non valida, usata per indicare che nessun elemento è stato rimosso
+
+    static const unsigned int BLOCK_BYTES = 16384; ///< byte dell'array confrontati con tutte le ricerche di un lotto prima di passare oltre
+
+    static const unsigned int PREFETCH_GROUP = 16; ///< ricerche di un lotto di cui viene anticipato l'accesso all'indice
+
 public:
     /**
      * @brief costruttore di default
@@ -53,43 +120,39 @@ public:
      *
      * @post _set == nullptr
      * @post _size == 0
+     * @post _capacity == 0
+     * @post _filter == nullptr
+     * @post _index == nullptr
+     * @post _hashes == nullptr
+     * @post _refs == nullptr
      */
-    set() : _set(nullptr), _size(0) {}
+    set() : _set(nullptr), _size(0), _capacity(0), _filter(nullptr), _index(nullptr), _hashes(nullptr), _hash_cache(false), _refs(nullptr) {}
 
     /**
      * @brief costruttore di copia
      *
      * Costruttore di copia della classe.
-     * Crea una copia esatta del contenuto del set passato come parametro.
-     * In caso di errore durante l'i-esima copia, viene liberata la memoria occupata dalle prime i-1 copie.
+     * Il nuovo set condivide l'array, il filtro di Bloom, l'indice e la cache degli hash di other, senza copiarli:
+     * l'operazione costa O(1) e non può fallire.
+     * La copia effettiva avviene alla prima modifica di uno dei due set.
      *
      * @param other set da copiare
      *
-     * @post _set != other._set
-     * @post _set[i] == other._set[i] i=0,...,_size-1
+     * @post _set == other._set
      * @post _size == other._size
-     *
-     * @throws std::bad_alloc se l'allocazione del nuovo array fallisce
-     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     * @post _capacity == other._capacity
+     * @post _filter == other._filter
+     * @post _index == other._index
+     * @post _hashes == other._hashes
+     * @post *_refs incrementato di 1, se other possiede memoria
      */
-    set(const set &other) : _set(nullptr), _size(0)
+    set(const set &other)
+        : _set(other._set), _size(other._size), _capacity(other._capacity), _filter(other._filter), _index(other._index),
+          _hashes(other._hashes), _hash_cache(other._hash_cache), _refs(other._refs)
     {
-        if (other._size > 0)
+        if (_refs != nullptr)
         {
-            try
-            {
-                _set = new T[other._size];
-                for (unsigned int i = 0; i < other._size; ++i)
-                {
-                    _set[i] = other._set[i];
-                }
-                _size = other._size;
-            }
-            catch (...)
-            {
-                clear();
-                throw;
-            }
+            _refs->fetch_add(1, std::memory_order_relaxed);
         }
     }
 
@@ -111,7 +174,8 @@ public:
      * @throw ... eventuali eccezioni lanciate dalla conversione dei tipi o dal costruttore di copia di T
      */
     template <typename IterT>
-    set(IterT begin, IterT end) : _set(nullptr), _size(0)
+    set(IterT begin, IterT end)
+        : _set(nullptr), _size(0), _capacity(0), _filter(nullptr), _index(nullptr), _hashes(nullptr), _hash_cache(false), _refs(nullptr)
     {
         try
         {
@@ -129,14 +193,180 @@ public:
         }
     }
 
+    /**
+     * @brief costruttore parallelo da sequenza di iteratori
+     *
+     * Crea lo stesso set del costruttore da sequenza, con gli stessi elementi nello stesso ordine
+     * (vince la prima occorrenza di ogni elemento), dividendo il lavoro tra più thread:
+     * - gli elementi vengono convertiti a T con un cast statico esplicito e ne viene calcolato l'hash,
+     *   ogni thread su una porzione contigua della sequenza
+     * - ogni elemento viene assegnato a una partizione in base al suo hash, così che elementi uguali
+     *   finiscano sempre nella stessa partizione
+     * - ogni thread elimina i duplicati della propria partizione con un hash_index, visitando gli elementi
+     *   nell'ordine della sequenza, e segna le prime occorrenze
+     * - le prime occorrenze vengono copiate nell'array finale, allocato una sola volta, ogni thread nella propria porzione
+     * Il costo complessivo è O(N) invece di O(N^2). Richiede un funtore di hash.
+     * Se l'iteratore non è ad accesso casuale, la conversione avviene su un solo thread.
+     * In caso di errore il set non viene creato.
+     *
+     * @param begin iteratore all'inizio della sequenza
+     * @param end iteratore alla fine della sequenza
+     * @param threads numero di thread da usare
+     *
+     * @post _set contiene gli elementi contenuti tra i due iteratori castati al tipo T (esclusi eventuali duplicati)
+     *
+     * @throw std::bad_alloc se l'allocazione dell'array o delle strutture di appoggio fallisce
+     * @throw std::system_error se la creazione di un thread fallisce
+     * @throw ... eventuali eccezioni lanciate dalla conversione dei tipi, dall'assegnamento di T, da Eql o da Hash
+     */
+    template <typename IterT>
+    set(IterT begin, IterT end, unsigned int threads)
+        : _set(nullptr), _size(0), _capacity(0), _filter(nullptr), _index(nullptr), _hashes(nullptr), _hash_cache(false), _refs(nullptr)
+    {
+        static_assert(is_hash_enabled<Hash>::value, "Parallel construction requires a hash functor");
+
+        const unsigned int parts = threads > 1 ? threads : 1;
+
+        try
+        {
+            std::vector<T> items;
+            if constexpr (std::is_base_of<std::random_access_iterator_tag,
+                                          typename std::iterator_traits<IterT>::iterator_category>::value)
+            {
+                items.resize(static_cast<std::size_t>(end - begin));
+                const unsigned int n = static_cast<unsigned int>(items.size());
+                parallel_run(parts, [&](unsigned int t) {
+                    for (unsigned int i = chunk_begin(n, parts, t); i < chunk_begin(n, parts, t + 1); ++i)
+                    {
+                        items[i] = static_cast<T>(begin[i]);
+                    }
+                });
+            }
+            else
+            {
+                while (begin != end)
+                {
+                    items.push_back(static_cast<T>(*begin));
+                    ++begin;
+                }
+            }
+
+            const unsigned int n = static_cast<unsigned int>(items.size());
+            if (n == 0)
+            {
+                return;
+            }
+
+            // hash di ogni elemento e posizioni divise per porzione di origine e partizione di destinazione
+            const hash_index<T, Eql, Hash> hasher;
+            std::vector<std::uint32_t> hashes(n);
+            std::vector<std::vector<unsigned int>> buckets(static_cast<std::size_t>(parts) * parts);
+
+            parallel_run(parts, [&](unsigned int t) {
+                for (unsigned int i = chunk_begin(n, parts, t); i < chunk_begin(n, parts, t + 1); ++i)
+                {
+                    hashes[i] = hasher.hash_of(items[i]);
+                    const unsigned int p = static_cast<unsigned int>((static_cast<std::uint64_t>(hashes[i]) * parts) >> 32);
+                    buckets[t * parts + p].push_back(i);
+                }
+            });
+
+            // ogni thread segna le prime occorrenze degli elementi della propria partizione
+            std::vector<unsigned char> keep(n, 0);
+            parallel_run(parts, [&](unsigned int p) {
+                std::size_t expected = 0;
+                for (unsigned int t = 0; t < parts; ++t)
+                {
+                    expected += buckets[t * parts + p].size();
+                }
+
+                hash_index<T, Eql, Hash> index(static_cast<unsigned int>(expected));
+                auto get = [&items](unsigned int j) -> const T & { return items[j]; };
+
+                for (unsigned int t = 0; t < parts; ++t)
+                {
+                    for (unsigned int i : buckets[t * parts + p])
+                    {
+                        if (index.find(items[i], hashes[i], get) == index.NOT_FOUND)
+                        {
+                            index.insert(i, hashes[i]);
+                            keep[i] = 1;
+                        }
+                    }
+                }
+            });
+
+            std::vector<unsigned int> offsets(parts + 1, 0);
+            parallel_run(parts, [&](unsigned int t) {
+                for (unsigned int i = chunk_begin(n, parts, t); i < chunk_begin(n, parts, t + 1); ++i)
+                {
+                    offsets[t + 1] += keep[i];
+                }
+            });
+            for (unsigned int t = 0; t < parts; ++t)
+            {
+                offsets[t + 1] += offsets[t];
+            }
+
+            reserve(offsets[parts]);
+
+            // ogni thread costruisce gli elementi della propria porzione; in caso di errore vengono distrutti
+            // quelli costruiti, dato che le celle oltre _size non vengono distrutte da clear
+            std::vector<unsigned char> built(parts, 0);
+            try
+            {
+                parallel_run(parts, [&](unsigned int t) {
+                    unsigned int pos = offsets[t];
+                    try
+                    {
+                        for (unsigned int i = chunk_begin(n, parts, t); i < chunk_begin(n, parts, t + 1); ++i)
+                        {
+                            if (keep[i])
+                            {
+                                ::new (static_cast<void *>(_set + pos)) T(std::move(items[i]));
+                                ++pos;
+                            }
+                        }
+                    }
+                    catch (...)
+                    {
+                        std::destroy(_set + offsets[t], _set + pos);
+                        throw;
+                    }
+                    built[t] = 1;
+                });
+            }
+            catch (...)
+            {
+                for (unsigned int t = 0; t < parts; ++t)
+                {
+                    if (built[t])
+                    {
+                        std::destroy(_set + offsets[t], _set + offsets[t + 1]);
+                    }
+                }
+                throw;
+            }
+            _size = offsets[parts];
+            _index = updated_index(_set, _size, nullptr);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
     /**
      * @brief metodo distruttore
      *
      * Distruttore della classe.
-     * Libera la memoria occupata da _set e reimposta allo stato coerente vuoto.
+     * Rilascia la memoria occupata da _set e dal filtro (liberandola se nessun altro set la condivide)
+     * e reimposta allo stato coerente vuoto.
      *
      * @post _size == 0
      * @post _set == nullptr
+     * @post _filter == nullptr
      */
     ~set()
     {
@@ -157,50 +387,215 @@ public:
     }
 
     /**
-     * @brief aggiunge un elemento al set
+     * @brief metodo per la dimensione dell'array
      *
-     * Aggiunge l'elemento passato come parametro al set.
-     * Se l'elemento era già presente l'operazione viene ignorata, in quanto il set non ammette duplicati.
-     * Per rispettare la minima occupazione di memoria viene creato un nuovo array di dimensione _size + 1,
-     * che contiene esattamente gli stessi valori contenuti da _set e in ultima posizione l'elemento da aggiungere.
+     * Metodo per ottenere il numero di elementi che il set può contenere senza riallocare l'array.
+     * Questo metodo non altera lo stato della classe.
      *
-     * @param element valore da aggiungere al set
+     * @return dimensione dell'array
+     */
+    unsigned int capacity() const
+    {
+        return _capacity;
+    }
+
+    /**
+     * @brief prepara il set per un numero di elementi
      *
-     * @post contains(element) == true
-     * @post _size incrementata di 1 se l'elemento non era già presente
-     * @post _size invariata se l'elemento era già presente
+     * Se n è maggiore della dimensione attuale dell'array, porta l'array a dimensione n
+     * con gli stessi elementi: le successive aggiunte fino a n elementi non riallocano l'array.
+     * Le celle aggiunte non vengono costruite.
+     * La prima rimozione riporta l'array alla dimensione minima.
+     * In caso di errore l'operazione viene annullata senza intaccare lo stato precedente.
+     *
+     * @param n numero di elementi previsto
      *
-     * @throws std::bad_alloc se l'allocazione del nuovo array fallisce
-     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     * @post _capacity >= n
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array o del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
      */
-    void add(const T &element)
+    void reserve(unsigned int n)
+    {
+        if (n > _capacity)
+        {
+            reallocate(n);
+        }
+    }
+
+    /**
+     * @brief memoria occupata dal set
+     *
+     * Riporta separatamente i byte degli elementi, delle celle libere (vedi reserve),
+     * di indice hash, filtro di Bloom e cache degli hash, dell'oggetto set con le intestazioni delle strutture
+     * e della memoria posseduta dagli elementi fuori dall'array, stimata con il funtore heap.
+     * La memoria condivisa con altri set viene contata per intero; per non contarla più volte
+     * su molti set si usa memory_report.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param heap funtore che dato un elemento ritorna i byte che possiede fuori dall'array
+     *
+     * @return il resoconto della memoria occupata
+     *
+     * @throws ... eventuali eccezioni lanciate da heap
+     */
+    template <typename Heap = heap_bytes<T>>
+    memory_footprint memory_usage(Heap heap = Heap()) const
+    {
+        memory_footprint m;
+        m.sets = 1;
+        m.metadata = sizeof(set);
+        storage_usage(m, heap);
+
+        return m;
+    }
+
+    /**
+     * @brief compatta il set
+     *
+     * Riduce la memoria occupata al minimo per gli elementi attuali e ne migliora la località:
+     * - l'array e la cache degli hash vengono ridotti a _size celle
+     * - se T non è banalmente spostabile gli elementi vengono copiati in ordine in un nuovo array,
+     *   così che anche la memoria che possiedono (ad esempio i caratteri delle stringhe) venga allocata in sequenza
+     * - l'indice hash viene ricostruito della dimensione minima inserendo gli elementi in ordine,
+     *   usando gli hash memorizzati se la cache è abilitata
+     * - il filtro di Bloom viene ricostruito per _size elementi (almeno 16) se era stato dimensionato per più elementi
+     * Le successive aggiunte faranno crescere di nuovo array, indice e filtro.
+     * Se la memoria è condivisa con altri set il metodo non fa nulla, perché compattare
+     * richiederebbe una copia privata che occuperebbe più memoria di quella liberata.
+     * In caso di errore l'operazione viene annullata senza intaccare lo stato precedente.
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, dell'indice o del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T o da Hash
+     */
+    void compact()
     {
-        if (contains(element))
+        if (_refs == nullptr || shared())
         {
             return;
         }
 
-        T *copySet = new T[_size + 1];
+        bloom_filter<T, Hash> *newFilter = _filter;
+        hash_index<T, Eql, Hash> *newIndex = nullptr;
+        T *copySet = nullptr;
 
         try
         {
-            for (unsigned int i = 0; i < _size; ++i)
+            if constexpr (is_hash_enabled<Hash>::value)
             {
-                copySet[i] = _set[i];
+                if (_filter != nullptr && _filter->capacity() > (_size < 16 ? 16 : _size))
+                {
+                    newFilter = build_filter(_set, _size, _size, _filter->fp_rate());
+                }
             }
 
-            copySet[_size] = element;
+            newIndex = updated_index(_set, _size, nullptr);
+
+            if constexpr (!is_trivially_relocatable<T>::value)
+            {
+                copySet = storage_detail::copy(_set, _size, _size);
+            }
         }
         catch (...)
         {
-            delete[] copySet;
+            if (newFilter != _filter)
+            {
+                delete newFilter;
+            }
+            delete newIndex;
             throw;
         }
 
-        delete[] _set;
+        if (newFilter != _filter)
+        {
+            delete _filter;
+            _filter = newFilter;
+        }
+
+        delete _index;
+        _index = newIndex;
 
-        _set = copySet;
-        ++_size;
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            if (_size == 0)
+            {
+                storage_detail::deallocate(_set);
+                _set = nullptr;
+                _capacity = 0;
+            }
+            else if (T *shrunk = _capacity > _size ? storage_detail::shrink(_set, _size) : nullptr)
+            {
+                _set = shrunk;
+                _capacity = _size;
+            }
+        }
+        else
+        {
+            storage_detail::release(_set, _size);
+            _set = copySet;
+            _capacity = _size;
+        }
+
+        if (_hash_cache)
+        {
+            if (_capacity == 0)
+            {
+                storage_detail::deallocate(_hashes);
+                _hashes = nullptr;
+            }
+            else if (std::uint32_t *shrunk = storage_detail::shrink(_hashes, _capacity))
+            {
+                _hashes = shrunk;
+            }
+        }
+    }
+
+    /**
+     * @brief aggiunge un elemento al set
+     *
+     * Aggiunge l'elemento passato come parametro al set.
+     * Se l'elemento era già presente l'operazione viene ignorata, in quanto il set non ammette duplicati.
+     * Se l'array ha spazio libero (vedi reserve) e non è condiviso con altri set,
+     * l'elemento viene costruito direttamente in ultima posizione.
+     * Altrimenti, per rispettare la minima occupazione di memoria l'array viene portato a dimensione _size + 1
+     * (spostando gli elementi se non è condiviso, copiandoli altrimenti) e l'elemento viene costruito in ultima posizione.
+     * Se il filtro di Bloom è abilitato, l'elemento viene aggiunto anche al filtro;
+     * quando il numero di elementi supera quello per cui è dimensionato, il filtro viene ricostruito di dimensione doppia.
+     *
+     * @param element valore da aggiungere al set
+     *
+     * @post contains(element) == true
+     * @post _size incrementata di 1 se l'elemento non era già presente
+     * @post _size invariata se l'elemento era già presente
+     *
+     * In caso di errore gli elementi del set non cambiano; può cambiare solo la dimensione dell'array.
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array o del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
+     */
+    void add(const T &element)
+    {
+        SET_TRACE_SCOPE("add", T, _size);
+
+        // con indice o cache l'hash viene calcolato una sola volta per la ricerca e per l'inserimento
+        std::uint32_t h = 0;
+        const bool hashed = uses_hashes();
+        if (hashed)
+        {
+            h = element_hash(element);
+        }
+
+        if ((hashed ? position_of(element, h) : position_of(element)) != NO_POSITION)
+        {
+            return;
+        }
+
+        if (_size == _capacity || shared())
+        {
+            reallocate(_size + 1);
+        }
+
+        append(element, hashed ? &h : nullptr);
     }
 
     /**
@@ -209,8 +604,12 @@ public:
      * Cerca l'elemento specificato nel set e, se presente, lo rimuove.
      * Se l'elemento non è contenuto nel set, l'operazione non ha effetto.
      * L'elemento viene cercato mediante il funtore Eql.
+     * Se l'array non è condiviso gli elementi successivi vengono spostati (con memmove se T è banalmente copiabile,
+     * riducendo poi l'array con realloc), altrimenti vengono copiati in un nuovo array di dimensione _size - 1.
      * In caso di errore durante l'i-esima copia, viene liberata la memoria occupata dalle prime i-1 copie.
      * Inoltre, l'operazione viene annullata senza intaccare lo stato precedente.
+     * Se il filtro di Bloom è abilitato, viene ricostruito sugli elementi rimasti,
+     * dato che non è possibile togliere un elemento da un filtro di Bloom.
      *
      * @param element valore da rimuovere
      *
@@ -218,47 +617,115 @@ public:
      * @post _size decrementata di 1 se l'elemento era presente
      * @post _size invariata se l'elemento non era presente
      *
-     * @throws std::bad_alloc se l'allocazione del nuovo array fallisce
-     * @throws ... eventuali eccezioni lanciate dal confronto o dall'assegnamento di T
+     * @throws std::bad_alloc se l'allocazione del nuovo array o del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal confronto o dal costruttore di copia di T
      */
     void remove(const T &element)
     {
-        if (!contains(element))
-        {
-            return;
-        }
+        SET_TRACE_SCOPE("remove", T, _size);
 
-        if (_size == 1)
+        const unsigned int position = position_of(element);
+        if (position == NO_POSITION)
         {
-            clear();
             return;
         }
 
-        T *copySet = new T[_size - 1];
+        const unsigned int count = _size - 1;
+        const bool exclusive = _refs != nullptr && !shared() && storage_detail::movable<T>::value;
+        const bool in_place = exclusive && is_trivially_relocatable<T>::value && count > 0;
+
+        T *copySet = nullptr;
+        std::uint32_t *newHashes = nullptr;
+        std::atomic<unsigned int> *refs = nullptr;
+        bloom_filter<T, Hash> *newFilter = nullptr;
+        hash_index<T, Eql, Hash> *newIndex = nullptr;
 
         try
         {
-            for (unsigned int i = 0, j = 0; i < _size; ++i)
+            // filtro e indice vengono calcolati prima di toccare l'array, che in caso di errore resta invariato
+            newFilter = updated_filter(_set, count, nullptr, position);
+
+            // le posizioni successive all'elemento rimosso cambiano: l'indice viene ricostruito
+            newIndex = updated_index(_set, count, nullptr, position);
+
+            if (!in_place)
             {
-                if (_eql(_set[i], element))
+                refs = new std::atomic<unsigned int>(1);
+                copySet = storage_detail::allocate<T>(count);
+
+                if (_hash_cache)
                 {
-                    continue;
+                    newHashes = storage_detail::allocate<std::uint32_t>(count);
+                    if (count > 0)
+                    {
+                        storage_detail::copy_without(_hashes, _size, position, newHashes);
+                    }
                 }
 
-                copySet[j] = _set[i];
-                ++j;
+                if (!exclusive && count > 0)
+                {
+                    storage_detail::copy_without(_set, _size, position, copySet);
+                }
             }
         }
         catch (...)
         {
-            delete[] copySet;
+            delete newFilter;
+            delete newIndex;
+            delete refs;
+            storage_detail::deallocate(newHashes);
+            storage_detail::deallocate(copySet);
             throw;
         }
 
-        delete[] _set;
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            if (in_place)
+            {
+                // l'array resta di questo set: gli elementi successivi vengono spostati e l'array ridotto
+                storage_detail::erase(_set, _size, position);
+                if (_hash_cache)
+                {
+                    storage_detail::erase(_hashes, _size, position);
+                }
+
+                // la cache degli hash non viene mai ridotta sotto _capacity
+                if (T *shrunk = storage_detail::shrink(_set, count))
+                {
+                    _set = shrunk;
+                    _capacity = count;
+
+                    std::uint32_t *shrunkHashes = _hash_cache ? storage_detail::shrink(_hashes, count) : nullptr;
+                    if (shrunkHashes != nullptr)
+                    {
+                        _hashes = shrunkHashes;
+                    }
+                }
+                _size = count;
+
+                delete _filter;
+                _filter = newFilter;
+                delete _index;
+                _index = newIndex;
+                return;
+            }
+        }
+
+        if constexpr (storage_detail::movable<T>::value)
+        {
+            if (exclusive && count > 0)
+            {
+                storage_detail::move_without(_set, _size, position, copySet);
+            }
+        }
+
+        if (copySet == nullptr && newFilter == nullptr)
+        {
+            delete refs;
+            refs = nullptr;
+        }
 
-        _set = copySet;
-        --_size;
+        commit(copySet, count, count, newFilter, newIndex, newHashes, refs);
     }
 
     /**
@@ -266,6 +733,9 @@ public:
      *
      * Cerca se l'elemento è presente o meno nel set.
      * Per confrontare gli elementi viene usato il funtore Eql.
+     * Se il set ha un indice hash, la ricerca costa O(1) e confronta solo gli elementi con lo stesso hash.
+     * Altrimenti, se il filtro di Bloom è abilitato viene consultato prima di scorrere l'array:
+     * se il filtro esclude l'elemento, la ricerca termina subito.
      * Questo metodo non altera lo stato della classe.
      *
      * @param element elemento da cercare
@@ -274,328 +744,2206 @@ public:
      */
     bool contains(const T &element) const
     {
-        for (unsigned int i = 0; i < _size; ++i)
-        {
-            if (_eql(_set[i], element))
-            {
-                return true;
-            }
-        }
+        SET_TRACE_SCOPE("contains", T, _size);
 
-        return false;
+        return position_of(element) != NO_POSITION;
     }
 
     /**
-     * @brief operatore di assegnamento tra due set
-     *
-     * Ridefinizione dell'operatore di assegnamento tra due set compatibili.
-     * In caso di errore l'operazione viene annullata.
+     * @brief ricerca di più elementi
      *
-     * @param rhs elemento di destra dell'operazione, da cui vanno copiati i dati
+     * Risponde con una sola chiamata a contains per ogni elemento della sequenza [first, last),
+     * scrivendo i risultati in out nello stesso ordine.
+     * Se il set ha un indice hash, gli hash di un gruppo di ricerche vengono calcolati e le relative celle
+     * portate in cache prima di eseguire le ricerche, così che gli accessi alla memoria si sovrappongano.
+     * Altrimenti, dopo aver scartato le ricerche escluse dal filtro di Bloom (se abilitato), l'array viene
+     * percorso a blocchi di BLOCK_BYTES byte: ogni blocco viene confrontato con tutte le ricerche ancora aperte
+     * mentre è in cache, e una ricerca si chiude appena trova il proprio elemento.
+     * Per tipi aritmetici confrontati con std::equal_to il confronto con un blocco usa istruzioni SIMD.
+     * Questo metodo non altera lo stato della classe.
      *
-     * @post _set[i] == rhs._set[i] i=0,...,rhs._size
-     * @post _size == rhs._size
+     * @param first iteratore al primo elemento da cercare
+     * @param last iteratore successivo all'ultimo elemento da cercare
+     * @param out iteratore di output su cui scrivere un bool per ogni elemento cercato
      *
-     * @return reference al set modificato
+     * @return l'iteratore di output successivo all'ultimo risultato scritto
      *
-     * @throws std::bad_alloc se lanciata dal costruttore di copia
-     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     * @throws std::bad_alloc se l'allocazione delle strutture temporanee fallisce
+     * @throws ... eventuali eccezioni lanciate da Eql, Hash o dalla conversione degli elementi a T
      */
-    set &operator=(const set &rhs)
+    template <typename InputIt, typename OutIt>
+    OutIt contains_many(InputIt first, InputIt last, OutIt out) const
     {
-        if (this != &rhs)
-        {
-            set tmp(rhs);
+        std::vector<T> copies;
+        std::vector<const T *> queries;
+        gather(first, last, copies, queries);
 
-            std::swap(_set, tmp._set);
-            std::swap(_size, tmp._size);
+        std::vector<unsigned char> found(queries.size(), 0);
+        find_many(queries, found);
+
+        for (unsigned char f : found)
+        {
+            *out = f != 0;
+            ++out;
         }
 
-        return *this;
+        return out;
     }
 
     /**
-     * @brief operatore di accesso diretto all'i-esimo elemento
+     * @brief ricerca di più elementi con risultato a maschera di bit
      *
-     * Ridefinizione dell'operatore di accesso diretto all'i-esimo elemento.
-     * Non è possibile modificare l'elemento ritornato per non violare il principio di singolarità degli elementi.
+     * Come contains_many con iteratore di output, ma il risultato dell'i-esima ricerca
+     * viene scritto nel bit i % 64 di mask[i / 64]. Le parole di mask vengono sovrascritte per intero.
      * Questo metodo non altera lo stato della classe.
      *
-     * @param i indice dell'elemento da ottenere
+     * @param first iteratore al primo elemento da cercare
+     * @param last iteratore successivo all'ultimo elemento da cercare
+     * @param mask array di almeno (N + 63) / 64 parole, con N numero di elementi cercati
      *
-     * @pre i < _size
+     * @return numero di elementi trovati
      *
-     * @return elemento in posizione i
+     * @throws std::bad_alloc se l'allocazione delle strutture temporanee fallisce
+     * @throws ... eventuali eccezioni lanciate da Eql, Hash o dalla conversione degli elementi a T
      */
-    const T &operator[](unsigned int i) const
+    template <typename InputIt>
+    unsigned int contains_many(InputIt first, InputIt last, std::uint64_t *mask) const
     {
-        assert(i < _size);
-        return _set[i];
+        std::vector<T> copies;
+        std::vector<const T *> queries;
+        gather(first, last, copies, queries);
+
+        std::vector<unsigned char> found(queries.size(), 0);
+        find_many(queries, found);
+
+        return to_mask(found, mask);
     }
 
     /**
-     * @brief operatore di confronto tra due set
+     * @brief aggiunge più elementi al set
      *
-     * Ridefinizione dell'operatore di confronto tra due set.
-     * Questo metodo non altera lo stato della classe.
+     * Equivale a chiamare add per ogni elemento della sequenza [first, last), scrivendo in out,
+     * nello stesso ordine, true per gli elementi effettivamente aggiunti e false per quelli già presenti
+     * nel set o ripetuti prima nella sequenza.
+     * Gli elementi già presenti vengono individuati con contains_many, i duplicati interni alla sequenza
+     * con un hash_index temporaneo se è disponibile un funtore di hash (altrimenti confrontandoli tra loro);
+     * l'array viene poi ingrandito una sola volta della quantità esatta e gli elementi nuovi vengono accodati.
+     * In caso di errore durante gli inserimenti, gli elementi già aggiunti restano nel set.
      *
-     * @param other secondo set da confrontare
+     * @param first iteratore al primo elemento da aggiungere
+     * @param last iteratore successivo all'ultimo elemento da aggiungere
+     * @param out iteratore di output su cui scrivere un bool per ogni elemento della sequenza
      *
-     * @return false se i due set hanno numero diverso di elementi,
-     *         oppure true se tutti gli elementi in questo set sono presenti anche in other,
-     *         false altrimenti
+     * @return l'iteratore di output successivo all'ultimo risultato scritto
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, del filtro o delle strutture temporanee fallisce
+     * @throws ... eventuali eccezioni lanciate da Eql, Hash, dal costruttore di copia di T o dalla conversione a T
      */
-    bool operator==(const set &other) const
+    template <typename InputIt, typename OutIt>
+    OutIt add_many(InputIt first, InputIt last, OutIt out)
     {
-        if (_size != other._size)
-        {
-            return false;
-        }
+        std::vector<T> copies;
+        std::vector<const T *> queries;
+        gather(first, last, copies, queries);
 
-        for (unsigned int i = 0; i < _size; ++i)
+        std::vector<unsigned char> added(queries.size(), 0);
+        insert_many(queries, added);
+
+        for (unsigned char a : added)
         {
-            if (!other.contains(_set[i]))
-            {
-                return false;
-            }
+            *out = a != 0;
+            ++out;
         }
 
-        return true;
+        return out;
     }
 
     /**
-     * @brief operatore di intersezione tra due set
+     * @brief aggiunge più elementi al set con risultato a maschera di bit
+     *
+     * Come add_many con iteratore di output, ma il risultato dell'i-esimo elemento
+     * viene scritto nel bit i % 64 di mask[i / 64]. Le parole di mask vengono sovrascritte per intero.
+     *
+     * @param first iteratore al primo elemento da aggiungere
+     * @param last iteratore successivo all'ultimo elemento da aggiungere
+     * @param mask array di almeno (N + 63) / 64 parole, con N numero di elementi della sequenza
+     *
+     * @return numero di elementi aggiunti
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, del filtro o delle strutture temporanee fallisce
+     * @throws ... eventuali eccezioni lanciate da Eql, Hash, dal costruttore di copia di T o dalla conversione a T
+     */
+    template <typename InputIt>
+    unsigned int add_many(InputIt first, InputIt last, std::uint64_t *mask)
+    {
+        std::vector<T> copies;
+        std::vector<const T *> queries;
+        gather(first, last, copies, queries);
+
+        std::vector<unsigned char> added(queries.size(), 0);
+        insert_many(queries, added);
+
+        return to_mask(added, mask);
+    }
+
+    /**
+     * @brief operatore di assegnamento tra due set
+     *
+     * Ridefinizione dell'operatore di assegnamento tra due set compatibili.
+     * Come per il costruttore di copia, la memoria di rhs viene condivisa e non copiata.
+     * La memoria precedente viene rilasciata.
+     *
+     * @param rhs elemento di destra dell'operazione, da cui vanno copiati i dati
+     *
+     * @post _set == rhs._set
+     * @post _size == rhs._size
+     *
+     * @return reference al set modificato
+     */
+    set &operator=(const set &rhs)
+    {
+        if (this != &rhs)
+        {
+            set tmp(rhs);
+
+            std::swap(_set, tmp._set);
+            std::swap(_size, tmp._size);
+            std::swap(_capacity, tmp._capacity);
+            std::swap(_filter, tmp._filter);
+            std::swap(_index, tmp._index);
+            std::swap(_hashes, tmp._hashes);
+            std::swap(_hash_cache, tmp._hash_cache);
+            std::swap(_refs, tmp._refs);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief operatore di accesso diretto all'i-esimo elemento
+     *
+     * Ridefinizione dell'operatore di accesso diretto all'i-esimo elemento.
+     * Non è possibile modificare l'elemento ritornato per non violare il principio di singolarità degli elementi.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param i indice dell'elemento da ottenere
+     *
+     * @pre i < _size
+     *
+     * @return elemento in posizione i
+     */
+    const T &operator[](unsigned int i) const
+    {
+        assert(i < _size);
+        return _set[i];
+    }
+
+    /**
+     * @brief accesso all'array degli elementi
+     *
+     * Ritorna il puntatore al primo degli _size elementi, contigui in memoria.
+     * Il puntatore resta valido fino alla successiva modifica del set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return puntatore al primo elemento, nullptr se il set è vuoto
+     */
+    const T *data() const
+    {
+        return _set;
+    }
+
+#if __cplusplus >= 202002L
+    /**
+     * @brief vista sugli elementi
+     *
+     * Ritorna una std::span costante sugli elementi, valida fino alla successiva modifica del set.
+     * Disponibile solo compilando con C++20.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return std::span di _size elementi a partire da data()
+     */
+    std::span<const T> as_span() const
+    {
+        return std::span<const T>(_set, _size);
+    }
+#endif
+
+    /**
+     * @brief operatore di confronto tra due set
+     *
+     * Ridefinizione dell'operatore di confronto tra due set.
+     * I filtri di Bloom non vengono confrontati: possono contenere bit di elementi non presenti,
+     * quindi set uguali possono avere filtri diversi.
+     * Se entrambi i set hanno la cache degli hash, somme e xor degli hash diversi permettono di concludere
+     * subito che i set sono diversi, senza chiamare Eql.
+     * Altrimenti la ricerca in other usa il suo filtro, se presente, e l'hash memorizzato di ogni elemento se disponibile.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param other secondo set da confrontare
+     *
+     * @return false se i due set hanno numero diverso di elementi,
+     *         oppure true se tutti gli elementi in questo set sono presenti anche in other,
+     *         false altrimenti
+     */
+    bool operator==(const set &other) const
+    {
+        if (_size != other._size)
+        {
+            return false;
+        }
+
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            // elementi uguali hanno hash uguali: somma e xor degli hash non dipendono dall'ordine
+            if (_hash_cache && other._hash_cache)
+            {
+                std::uint64_t sum = 0, otherSum = 0;
+                std::uint32_t bits = 0, otherBits = 0;
+                for (unsigned int i = 0; i < _size; ++i)
+                {
+                    sum += _hashes[i];
+                    bits ^= _hashes[i];
+                    otherSum += other._hashes[i];
+                    otherBits ^= other._hashes[i];
+                }
+
+                if (sum != otherSum || bits != otherBits)
+                {
+                    return false;
+                }
+            }
+        }
+
+        for (unsigned int i = 0; i < _size; ++i)
+        {
+            if (position_in(other, i) == NO_POSITION)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief operatore di intersezione tra due set
      *
      * Ridefinizione dell'operatore di sottrazione tra due set.
      * Viene applicata la definizione di intersezione insiemistica.
+     * La ricerca degli elementi in other usa il suo filtro di Bloom, se presente:
+     * gli elementi non in comune vengono scartati senza scorrere other.
+     * Se questo set ha la cache degli hash, la ricerca usa gli hash memorizzati e il risultato eredita la cache,
+     * copiando gli hash invece di ricalcolarli.
+     * L'array del risultato viene allocato una sola volta.
      * Questo metodo non altera lo stato della classe, in quanto viene creato un nuovo set.
      *
      * @param other secondo set da intersecare
      *
      * @return un set che corrisponde all'intersezione insiemistica tra i due set
      *
-     * @throws std::bad_alloc se lanciata da add
-     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     * @throws std::bad_alloc se l'allocazione del risultato fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T, da Eql o da Hash
      */
     set operator-(const set &other) const
     {
-        set result;
+        SET_TRACE_SCOPE("operator-", T, _size + other._size);
 
+        std::vector<unsigned int> common;
         for (unsigned int i = 0; i < _size; ++i)
         {
-            if (other.contains(_set[i]))
+            if (position_in(other, i) != NO_POSITION)
             {
-                result.add(_set[i]);
+                common.push_back(i);
             }
         }
 
+        set result;
+        result._hash_cache = _hash_cache;
+        result.reserve(static_cast<unsigned int>(common.size()));
+        for (unsigned int i : common)
+        {
+            result.append(_set[i], _hash_cache ? &_hashes[i] : nullptr);
+        }
+
         return result;
     }
 
-    class const_iterator; // forward declaration
+    /**
+     * @brief abilita la cache degli hash
+     *
+     * Calcola e memorizza l'hash di ogni elemento, che viene poi mantenuto da add e remove.
+     * Da questo momento:
+     * - le ricerche senza indice confrontano prima gli hash e chiamano Eql solo sugli elementi con lo stesso hash
+     * - la ricostruzione dell'indice, ==, - e + usano gli hash memorizzati invece di ricalcolarli
+     * La cache occupa 4 byte per ogni cella dell'array ed è condivisa tra le copie come l'array.
+     * È disponibile solo se il set ha un funtore di hash.
+     * In caso di errore l'operazione viene annullata senza intaccare lo stato precedente.
+     *
+     * @post has_hash_cache() == true
+     *
+     * @throws std::bad_alloc se l'allocazione della cache o della versione privata del set fallisce
+     * @throws ... eventuali eccezioni lanciate da Hash o dal costruttore di copia di T
+     */
+    void enable_hash_cache()
+    {
+        static_assert(is_hash_enabled<Hash>::value, "enable_hash_cache requires a Hash functor");
 
-    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+        if (_hash_cache)
+        {
+            return;
+        }
+
+        std::uint32_t *hashes = storage_detail::allocate<std::uint32_t>(_capacity);
+        try
+        {
+            for (unsigned int i = 0; i < _size; ++i)
+            {
+                hashes[i] = element_hash(_set[i]);
+            }
+
+            detach();
+        }
+        catch (...)
+        {
+            storage_detail::deallocate(hashes);
+            throw;
+        }
+
+        // detach può solo ridurre l'array, quindi la cache ha almeno _capacity celle
+        _hashes = hashes;
+        _hash_cache = true;
+    }
 
     /**
-     * @brief iteratore costante della classe set
+     * @brief disabilita la cache degli hash
      *
-     * Rappresenta un iteratore costante per la classe set.
-     * È un forward const_iterator.
-     * In sostanza è un wrapper per un puntatore a un oggetto di tipo T.
+     * Libera la memoria occupata dalla cache.
+     * Se la cache è condivisa con altri set, viene prima creata una versione privata del set.
+     *
+     * @post has_hash_cache() == false
+     *
+     * @throws std::bad_alloc se la creazione della versione privata fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
      */
-    class const_iterator
+    void disable_hash_cache()
     {
-    public:
-        typedef std::forward_iterator_tag iterator_category;
-        typedef T value_type;
-        typedef ptrdiff_t difference_type;
-        typedef const T *pointer;
-        typedef const T &reference;
+        if (!_hash_cache)
+        {
+            return;
+        }
 
-        /**
-         * @brief costruttore di default
-         *
-         * Costruttore di default per il const iterator.
-         * Inizializza a nullptr.
-         *
-         * @post _t == nullptr
-         */
-        const_iterator() : _t(nullptr) {}
+        detach();
 
-        /**
-         * @brief costruttore di copia
-         *
-         * Costruttore di copia per il const iterator.
-         * Copia il puntatore dell'iterator passato come parametro.
-         *
-         * @param other const_iterator da cui copiare il puntatore
-         *
-         * @post _t == other._t
-         */
-        const_iterator(const const_iterator &other) : _t(other._t) {}
+        storage_detail::deallocate(_hashes);
+        _hashes = nullptr;
+        _hash_cache = false;
+    }
 
-        /**
-         * @brief operatore di assegnamento
-         *
-         * Assegna il valore dell'iteratore passato come parametro a questo iteratore.
-         *
-         * @post _t == other._t
-         *
-         * @return l'iteratore corrente
-         */
-        const_iterator &operator=(const const_iterator &other)
+    /**
+     * @brief verifica se la cache degli hash è abilitata
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return true se la cache è abilitata, false altrimenti
+     */
+    bool has_hash_cache() const
+    {
+        return _hash_cache;
+    }
+
+    /**
+     * @brief abilita il filtro di Bloom
+     *
+     * Costruisce un filtro di Bloom sugli elementi attuali, che viene poi mantenuto da add e remove
+     * e consultato da contains prima della ricerca esatta.
+     * Il filtro è dimensionato per il doppio degli elementi attuali (almeno 16).
+     * Se il filtro era già abilitato viene ricostruito con la nuova probabilità.
+     * È disponibile solo se il set ha un funtore di hash.
+     *
+     * @param fp_rate probabilità di falso positivo desiderata
+     *
+     * @pre 0 < fp_rate < 1
+     *
+     * @post has_filter() == true
+     *
+     * @throws std::invalid_argument se fp_rate non è compreso tra 0 e 1
+     * @throws std::bad_alloc se l'allocazione del filtro fallisce
+     */
+    void enable_filter(double fp_rate = 0.01)
+    {
+        static_assert(is_hash_enabled<Hash>::value, "enable_filter requires a Hash functor");
+
+        bloom_filter<T, Hash> *newFilter = build_filter(_set, _size, 2 * _size, fp_rate);
+
+        try
         {
-            _t = other._t;
-            return *this;
+            detach();
+        }
+        catch (...)
+        {
+            delete newFilter;
+            throw;
         }
 
-        /**
-         * @brief metodo distruttore
-         *
-         * Distruttore della classe const_iterator.
-         */
-        ~const_iterator() {}
+        delete _filter;
+        _filter = newFilter;
+    }
 
-        /**
-         * @brief operatore di dereferenziamento
-         *
-         * Operatore di dereferenziamento dell'iteratore.
-         *
-         * @return il valore puntato dall'iteratore
-         */
-        reference operator*() const
+    /**
+     * @brief disabilita il filtro di Bloom
+     *
+     * Libera la memoria occupata dal filtro.
+     * Se il filtro è condiviso con altri set, viene prima creata una versione privata del set.
+     *
+     * @post has_filter() == false
+     *
+     * @throws std::bad_alloc se la creazione della versione privata fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T
+     */
+    void disable_filter()
+    {
+        if (_filter == nullptr)
         {
-            return *_t;
+            return;
         }
 
-        /**
-         * @brief operatore freccia
-         *
-         * Operatore freccia dell'iteratore.
-         *
-         * @return il puntatore attuale dell'iteratore
-         */
-        pointer operator->() const
+        detach();
+
+        delete _filter;
+        _filter = nullptr;
+    }
+
+    /**
+     * @brief verifica se il filtro di Bloom è abilitato
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return true se il filtro è abilitato, false altrimenti
+     */
+    bool has_filter() const
+    {
+        return _filter != nullptr;
+    }
+
+    /**
+     * @brief probabilità di falso positivo del filtro di Bloom
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @pre has_filter() == true
+     *
+     * @return la probabilità di falso positivo con cui è stato abilitato il filtro
+     */
+    double filter_fp_rate() const
+    {
+        assert(_filter != nullptr);
+        return _filter->fp_rate();
+    }
+
+    /**
+     * @brief verifica se il set usa l'indice hash
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return true se le ricerche usano l'indice hash, false se scorrono l'array
+     */
+    bool has_index() const
+    {
+        return _index != nullptr;
+    }
+
+    /**
+     * @brief soglia per l'indice hash
+     *
+     * @return numero di elementi oltre il quale i set di questo tipo creano l'indice hash
+     */
+    static unsigned int index_threshold()
+    {
+        return _index_threshold.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief imposta la soglia per l'indice hash
+     *
+     * La soglia vale per tutti i set con gli stessi parametri template e viene applicata alla successiva modifica di ogni set:
+     * un set senza indice lo crea quando supera n elementi, un set con indice lo elimina quando scende a n/2.
+     * Il valore di default, 8, è stato scelto con bench.cpp, che riporta i punti di incrocio misurati per int, std::string e point.
+     * Con n == 0xFFFFFFFF l'indice non viene mai creato; con n == 0 viene creato dal primo elemento.
+     *
+     * @param n nuova soglia
+     */
+    static void set_index_threshold(unsigned int n)
+    {
+        _index_threshold.store(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief memoria occupata da una sequenza di set
+     *
+     * Somma i resoconti di memory_usage dei set tra i due iteratori, contando una sola volta
+     * la memoria condivisa da più set (vedi il costruttore di copia): ogni set contribuisce
+     * con il proprio oggetto, mentre array, indice, filtro, cache e memoria degli elementi
+     * vengono contati per il primo set che li possiede.
+     *
+     * @param first iteratore al primo set
+     * @param last iteratore alla fine della sequenza di set
+     * @param heap funtore che dato un elemento ritorna i byte che possiede fuori dall'array
+     *
+     * @return il resoconto della memoria occupata dai set
+     *
+     * @throws std::bad_alloc se l'allocazione delle strutture di appoggio fallisce
+     * @throws ... eventuali eccezioni lanciate da heap
+     */
+    template <typename SetIter, typename Heap = heap_bytes<T>>
+    static memory_footprint memory_report(SetIter first, SetIter last, Heap heap = Heap())
+    {
+        memory_footprint m;
+        std::vector<std::pair<const std::atomic<unsigned int> *, const set *>> sharing;
+
+        for (SetIter it = first; it != last; ++it)
+        {
+            const set &s = *it;
+            ++m.sets;
+            m.metadata += sizeof(set);
+
+            if (s.shared())
+            {
+                sharing.emplace_back(s._refs, &s);
+            }
+            else
+            {
+                s.storage_usage(m, heap);
+            }
+        }
+
+        // la memoria condivisa viene contata una volta per contatore di riferimenti
+        std::sort(sharing.begin(), sharing.end(),
+                  [](const auto &a, const auto &b) { return std::less<const void *>()(a.first, b.first); });
+        for (std::size_t i = 0; i < sharing.size(); ++i)
+        {
+            if (i == 0 || sharing[i].first != sharing[i - 1].first)
+            {
+                sharing[i].second->storage_usage(m, heap);
+            }
+        }
+
+        return m;
+    }
+
+    /**
+     * @brief unione di una sequenza di set
+     *
+     * Crea un set che contiene l'unione di tutti i set tra i due iteratori, in un'unica passata.
+     * L'array del risultato viene allocato una sola volta, della somma delle dimensioni dei set.
+     * Se è disponibile un funtore di hash i duplicati vengono individuati con un hash_index;
+     * con più thread gli elementi vengono partizionati per hash e ogni thread elimina i duplicati della propria partizione.
+     * Senza funtore di hash viene usato contains sul risultato.
+     * Con un solo thread l'ordine degli elementi è lo stesso che si otterrebbe concatenando gli operatori +.
+     *
+     * @param first iteratore al primo set
+     * @param last iteratore alla fine della sequenza di set
+     * @param threads numero di thread da usare, ignorato se non è disponibile un funtore di hash
+     *
+     * @return nuovo set contenente l'unione insiemistica dei set
+     *
+     * @throws std::bad_alloc se l'allocazione del risultato o delle strutture di appoggio fallisce
+     * @throws std::system_error se la creazione di un thread fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T, da Eql o da Hash
+     */
+    template <typename SetIter>
+    static set union_all(SetIter first, SetIter last, unsigned int threads = 1)
+    {
+        std::vector<const set *> sets;
+        unsigned long long total = 0;
+        for (SetIter it = first; it != last; ++it)
+        {
+            sets.push_back(&*it);
+            total += it->_size;
+        }
+
+        set result;
+        if (total == 0)
+        {
+            return result;
+        }
+
+        if constexpr (!is_hash_enabled<Hash>::value)
+        {
+            result.reserve(static_cast<unsigned int>(total));
+            for (const set *s : sets)
+            {
+                for (unsigned int i = 0; i < s->_size; ++i)
+                {
+                    if (!result.contains(s->_set[i]))
+                    {
+                        result.append(s->_set[i]);
+                    }
+                }
+            }
+        }
+        else
+        {
+            const hash_index<T, Eql, Hash> hasher;
+
+            // hash di tutti gli elementi, calcolati una sola volta
+            std::vector<unsigned long long> offsets(sets.size() + 1, 0);
+            for (unsigned int k = 0; k < sets.size(); ++k)
+            {
+                offsets[k + 1] = offsets[k] + sets[k]->_size;
+            }
+
+            std::vector<std::uint32_t> hashes(total);
+            std::vector<std::vector<const T *>> partitions(threads > 1 ? threads : 1);
+            const unsigned int parts = static_cast<unsigned int>(partitions.size());
+
+            parallel_run(parts, [&](unsigned int t) {
+                for (unsigned int k = 0; k < sets.size(); ++k)
+                {
+                    const unsigned int n = sets[k]->_size;
+                    for (unsigned int i = chunk_begin(n, parts, t); i < chunk_begin(n, parts, t + 1); ++i)
+                    {
+                        hashes[offsets[k] + i] = sets[k]->_hash_cache ? sets[k]->_hashes[i] : hasher.hash_of(sets[k]->_set[i]);
+                    }
+                }
+            });
+
+            // ogni thread elimina i duplicati degli elementi con hash nella propria partizione
+            parallel_run(parts, [&](unsigned int t) {
+                std::vector<const T *> &unique = partitions[t];
+                hash_index<T, Eql, Hash> index;
+                auto get = [&unique](unsigned int j) -> const T & { return *unique[j]; };
+
+                for (unsigned int k = 0; k < sets.size(); ++k)
+                {
+                    for (unsigned int i = 0; i < sets[k]->_size; ++i)
+                    {
+                        const std::uint32_t h = hashes[offsets[k] + i];
+                        if ((static_cast<std::uint64_t>(h) * parts) >> 32 != t)
+                        {
+                            continue;
+                        }
+
+                        if (index.find(sets[k]->_set[i], h, get) == index.NOT_FOUND)
+                        {
+                            index.insert(static_cast<unsigned int>(unique.size()), h);
+                            unique.push_back(&sets[k]->_set[i]);
+                        }
+                    }
+                }
+            });
+
+            unsigned int count = 0;
+            for (const std::vector<const T *> &unique : partitions)
+            {
+                count += static_cast<unsigned int>(unique.size());
+            }
+
+            result.reserve(count);
+            for (const std::vector<const T *> &unique : partitions)
+            {
+                for (const T *element : unique)
+                {
+                    result.append(*element);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief intersezione di una sequenza di set
+     *
+     * Crea un set che contiene gli elementi comuni a tutti i set tra i due iteratori.
+     * Vengono scorsi solo gli elementi del set più piccolo, nel loro ordine, e l'array del risultato viene allocato una sola volta.
+     * Se è disponibile un funtore di hash, per ogni altro set viene costruito un hash_index temporaneo;
+     * con più thread gli elementi del set più piccolo vengono divisi tra i thread.
+     * Senza funtore di hash viene usato contains sugli altri set.
+     *
+     * @param first iteratore al primo set
+     * @param last iteratore alla fine della sequenza di set
+     * @param threads numero di thread da usare, ignorato se non è disponibile un funtore di hash
+     *
+     * @return nuovo set contenente l'intersezione insiemistica dei set, vuoto se la sequenza è vuota
+     *
+     * @throws std::bad_alloc se l'allocazione del risultato o delle strutture di appoggio fallisce
+     * @throws std::system_error se la creazione di un thread fallisce
+     * @throws ... eventuali eccezioni lanciate dall'assegnamento di T, da Eql o da Hash
+     */
+    template <typename SetIter>
+    static set intersect_all(SetIter first, SetIter last, unsigned int threads = 1)
+    {
+        std::vector<const set *> sets;
+        unsigned int smallest = 0;
+        for (SetIter it = first; it != last; ++it)
+        {
+            if (sets.empty() || it->_size < sets[smallest]->_size)
+            {
+                smallest = static_cast<unsigned int>(sets.size());
+            }
+            sets.push_back(&*it);
+        }
+
+        set result;
+        if (sets.empty() || sets[smallest]->_size == 0)
+        {
+            return result;
+        }
+
+        const set &base = *sets[smallest];
+        std::vector<unsigned char> keep(base._size, 1);
+
+        if constexpr (!is_hash_enabled<Hash>::value)
+        {
+            for (unsigned int i = 0; i < base._size; ++i)
+            {
+                for (unsigned int k = 0; k < sets.size() && keep[i]; ++k)
+                {
+                    if (k != smallest && !sets[k]->contains(base._set[i]))
+                    {
+                        keep[i] = 0;
+                    }
+                }
+            }
+        }
+        else
+        {
+            const unsigned int parts = threads > 1 ? threads : 1;
+            std::vector<hash_index<T, Eql, Hash>> indexes(sets.size());
+
+            parallel_run(parts, [&](unsigned int t) {
+                for (unsigned int k = t; k < sets.size(); k += parts)
+                {
+                    if (k == smallest)
+                    {
+                        continue;
+                    }
+
+                    indexes[k].reserve(sets[k]->_size);
+                    for (unsigned int i = 0; i < sets[k]->_size; ++i)
+                    {
+                        indexes[k].insert(i, sets[k]->_hash_cache ? sets[k]->_hashes[i] : indexes[k].hash_of(sets[k]->_set[i]));
+                    }
+                }
+            });
+
+            parallel_run(parts, [&](unsigned int t) {
+                for (unsigned int i = chunk_begin(base._size, parts, t); i < chunk_begin(base._size, parts, t + 1); ++i)
+                {
+                    const std::uint32_t h = base._hash_cache ? base._hashes[i] : indexes[smallest].hash_of(base._set[i]);
+                    for (unsigned int k = 0; k < sets.size() && keep[i]; ++k)
+                    {
+                        const set *other = sets[k];
+                        auto get = [other](unsigned int j) -> const T & { return other->_set[j]; };
+                        if (k != smallest && indexes[k].find(base._set[i], h, get) == indexes[k].NOT_FOUND)
+                        {
+                            keep[i] = 0;
+                        }
+                    }
+                }
+            });
+        }
+
+        unsigned int count = 0;
+        for (unsigned int i = 0; i < base._size; ++i)
+        {
+            count += keep[i];
+        }
+
+        result.reserve(count);
+        for (unsigned int i = 0; i < base._size; ++i)
+        {
+            if (keep[i])
+            {
+                result.append(base._set[i]);
+            }
+        }
+
+        return result;
+    }
+
+    class const_iterator; // forward declaration
+
+    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief iteratore costante della classe set
+     *
+     * Rappresenta un iteratore costante per la classe set.
+     * È un random access const_iterator e, compilando con C++20, un contiguous iterator:
+     * gli elementi sono contigui in memoria, quindi può essere usato con gli algoritmi paralleli della libreria standard.
+     * In sostanza è un wrapper per un puntatore a un oggetto di tipo T.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+#if __cplusplus >= 202002L
+        typedef std::contiguous_iterator_tag iterator_concept;
+#endif
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief costruttore di default
+         *
+         * Costruttore di default per il const iterator.
+         * Inizializza a nullptr.
+         *
+         * @post _t == nullptr
+         */
+        const_iterator() : _t(nullptr) {}
+
+        /**
+         * @brief costruttore di copia
+         *
+         * Costruttore di copia per il const iterator.
+         * Copia il puntatore dell'iterator passato come parametro.
+         *
+         * @param other const_iterator da cui copiare il puntatore
+         *
+         * @post _t == other._t
+         */
+        const_iterator(const const_iterator &other) : _t(other._t) {}
+
+        /**
+         * @brief operatore di assegnamento
+         *
+         * Assegna il valore dell'iteratore passato come parametro a questo iteratore.
+         *
+         * @post _t == other._t
+         *
+         * @return l'iteratore corrente
+         */
+        const_iterator &operator=(const const_iterator &other)
+        {
+            _t = other._t;
+            return *this;
+        }
+
+        /**
+         * @brief metodo distruttore
+         *
+         * Distruttore della classe const_iterator.
+         */
+        ~const_iterator() {}
+
+        /**
+         * @brief operatore di dereferenziamento
+         *
+         * Operatore di dereferenziamento dell'iteratore.
+         *
+         * @return il valore puntato dall'iteratore
+         */
+        reference operator*() const
+        {
+            return *_t;
+        }
+
+        /**
+         * @brief operatore freccia
+         *
+         * Operatore freccia dell'iteratore.
+         *
+         * @return il puntatore attuale dell'iteratore
+         */
+        pointer operator->() const
+        {
+            return _t;
+        }
+
+        /**
+         * @brief operatore di post-incremento
+         *
+         * Operatore di post-incremento dell'iteratore.
+         * Sposta avanti l'iteratore e ritorna una copia nello stato precendente.
+         *
+         * @post _t == ++_t_precedente
+         *
+         * @return un iteratore nello stato precedente alla chiamata
+         */
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++_t;
+            return tmp;
+        }
+
+        /**
+         * @brief operatore di pre-incremento
+         *
+         * Operatore di pre-incremento dell'iteratore.
+         * Sposta avanti l'iteratore e lo ritorna.
+         *
+         * @return l'iteratore aggiornato
+         */
+        const_iterator &operator++()
+        {
+            ++_t;
+            return *this;
+        }
+
+        /**
+         * @brief operatore di post-decremento
+         *
+         * Operatore di post-decremento dell'iteratore.
+         * Sposta indietro l'iteratore e ritorna una copia nello stato precendente.
+         *
+         * @return un iteratore nello stato precedente alla chiamata
+         */
+        const_iterator operator--(int)
+        {
+            const_iterator tmp(*this);
+            --_t;
+            return tmp;
+        }
+
+        /**
+         * @brief operatore di pre-decremento
+         *
+         * Operatore di pre-decremento dell'iteratore.
+         * Sposta indietro l'iteratore e lo ritorna.
+         *
+         * @return l'iteratore aggiornato
+         */
+        const_iterator &operator--()
+        {
+            --_t;
+            return *this;
+        }
+
+        /**
+         * @brief operatore di avanzamento
+         *
+         * Sposta l'iteratore di n posizioni, in avanti se n è positivo e indietro se negativo.
+         *
+         * @param n numero di posizioni
+         *
+         * @return l'iteratore aggiornato
+         */
+        const_iterator &operator+=(difference_type n)
+        {
+            _t += n;
+            return *this;
+        }
+
+        /**
+         * @brief operatore di arretramento
+         *
+         * Sposta l'iteratore di n posizioni all'indietro.
+         *
+         * @param n numero di posizioni
+         *
+         * @return l'iteratore aggiornato
+         */
+        const_iterator &operator-=(difference_type n)
+        {
+            _t -= n;
+            return *this;
+        }
+
+        /**
+         * @brief operatore di somma
+         *
+         * @param n numero di posizioni
+         *
+         * @return un iteratore spostato di n posizioni rispetto a questo
+         */
+        const_iterator operator+(difference_type n) const
+        {
+            return const_iterator(_t + n);
+        }
+
+        /**
+         * @brief operatore di somma con l'intero a sinistra
+         *
+         * @param n numero di posizioni
+         * @param it iteratore da spostare
+         *
+         * @return un iteratore spostato di n posizioni rispetto a it
+         */
+        friend const_iterator operator+(difference_type n, const const_iterator &it)
+        {
+            return const_iterator(it._t + n);
+        }
+
+        /**
+         * @brief operatore di differenza con un intero
+         *
+         * @param n numero di posizioni
+         *
+         * @return un iteratore spostato di n posizioni all'indietro rispetto a questo
+         */
+        const_iterator operator-(difference_type n) const
+        {
+            return const_iterator(_t - n);
+        }
+
+        /**
+         * @brief operatore di distanza tra iteratori
+         *
+         * @param other iteratore dello stesso set
+         *
+         * @return numero di posizioni da other a questo iteratore
+         */
+        difference_type operator-(const const_iterator &other) const
+        {
+            return _t - other._t;
+        }
+
+        /**
+         * @brief operatore di accesso con indice
+         *
+         * @param n posizione relativa all'iteratore
+         *
+         * @return l'elemento n posizioni dopo quello puntato dall'iteratore
+         */
+        reference operator[](difference_type n) const
+        {
+            return _t[n];
+        }
+
+        /**
+         * @brief operatore di uguaglianza
+         *
+         * Operatore di uguaglianza dell'iteratore.
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se _t == other._t, false altrimenti
+         */
+        bool operator==(const const_iterator &other) const
+        {
+            return _t == other._t;
+        }
+
+        /**
+         * @brief operatore di disuguaglianza
+         *
+         * Operatore di disuguaglianza dell'iteratore.
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se _t != other._t, false altrimenti
+         */
+        bool operator!=(const const_iterator &other) const
+        {
+            return _t != other._t;
+        }
+
+        /**
+         * @brief operatore minore
+         *
+         * @param other iteratore dello stesso set
+         *
+         * @return true se questo iteratore precede other
+         */
+        bool operator<(const const_iterator &other) const
+        {
+            return _t < other._t;
+        }
+
+        /**
+         * @brief operatore maggiore
+         *
+         * @param other iteratore dello stesso set
+         *
+         * @return true se questo iteratore segue other
+         */
+        bool operator>(const const_iterator &other) const
+        {
+            return _t > other._t;
+        }
+
+        /**
+         * @brief operatore minore o uguale
+         *
+         * @param other iteratore dello stesso set
+         *
+         * @return true se questo iteratore non segue other
+         */
+        bool operator<=(const const_iterator &other) const
+        {
+            return _t <= other._t;
+        }
+
+        /**
+         * @brief operatore maggiore o uguale
+         *
+         * @param other iteratore dello stesso set
+         *
+         * @return true se questo iteratore non precede other
+         */
+        bool operator>=(const const_iterator &other) const
+        {
+            return _t >= other._t;
+        }
+
+    private:
+        const T *_t; ///< puntatore ad un oggetto costatnte di tipo T
+
+        friend class set;
+
+        /**
+         * @brief costruttore privato di inizializzazione
+         *
+         * Costruttore privato di inizializzazione del const_iterator.
+         *
+         * @param t puntatore ad un oggetto di tipo T
+         *
+         * @post _t == t
+         */
+        const_iterator(pointer t) : _t(t) {}
+    }; // const_iterator
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * Ritorna l'iteratore di inizio sequenza del set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return l'iteratore di inizio sequenza del set
+     */
+    iterator begin() const
+    {
+        return iterator(_set);
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * Ritorna l'iteratore di fine sequenza del set.
+     * Questo metodo non altera lo stateo della classe.
+     *
+     * @return l'iteratore di fine sequenza del set
+     */
+    iterator end() const
+    {
+        return iterator(_set + _size);
+    }
+
+private:
+    /**
+     * @brief posizione di un elemento nell'array
+     *
+     * Se il set ha un indice hash, la ricerca costa O(1) e confronta solo gli elementi con lo stesso hash.
+     * Altrimenti, se il filtro di Bloom è abilitato viene consultato prima di scorrere l'array.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     *
+     * @return posizione dell'elemento, NO_POSITION se non è presente
+     */
+    unsigned int position_of(const T &element) const
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (uses_hashes())
+            {
+                return position_of(element, element_hash(element));
+            }
+
+            if (_filter != nullptr && !_filter->possibly_contains(element))
+            {
+                return NO_POSITION;
+            }
+        }
+
+        for (unsigned int i = 0; i < _size; ++i)
+        {
+            if (_eql(_set[i], element))
+            {
+                return i;
+            }
+        }
+
+        return NO_POSITION;
+    }
+
+    /**
+     * @brief memoria occupata dai dati del set
+     *
+     * Aggiunge a m i byte di array, cache degli hash, indice, filtro e contatore di riferimenti
+     * e la memoria posseduta dagli elementi, ma non l'oggetto set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param m resoconto da aggiornare
+     * @param heap funtore che dato un elemento ritorna i byte che possiede fuori dall'array
+     *
+     * @throws ... eventuali eccezioni lanciate da heap
+     */
+    template <typename Heap>
+    void storage_usage(memory_footprint &m, Heap &heap) const
+    {
+        const unsigned long long unused = _capacity - _size;
+
+        m.elements += static_cast<unsigned long long>(_size) * sizeof(T);
+        m.slack += unused * sizeof(T);
+
+        if (_hash_cache)
+        {
+            m.index += static_cast<unsigned long long>(_size) * sizeof(std::uint32_t);
+            m.slack += unused * sizeof(std::uint32_t);
+        }
+
+        if (_index != nullptr)
+        {
+            m.index += _index->bytes();
+            m.metadata += sizeof(hash_index<T, Eql, Hash>);
+        }
+
+        if (_filter != nullptr)
+        {
+            m.index += _filter->bytes();
+            m.metadata += sizeof(bloom_filter<T, Hash>);
+        }
+
+        if (_refs != nullptr)
+        {
+            m.metadata += sizeof(std::atomic<unsigned int>);
+        }
+
+        for (unsigned int i = 0; i < _size; ++i)
+        {
+            m.heap += heap(_set[i]);
+        }
+    }
+
+    /**
+     * @brief posizione di un elemento di cui è noto l'hash
+     *
+     * Come position_of, ma usa l'hash passato invece di calcolarlo:
+     * con l'indice la ricerca costa O(1), con la cache degli hash Eql viene chiamato solo sugli elementi con lo stesso hash.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     * @param h hash dell'elemento, come calcolato da element_hash
+     *
+     * @return posizione dell'elemento, NO_POSITION se non è presente
+     */
+    unsigned int position_of(const T &element, std::uint32_t h) const
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (_index != nullptr)
+            {
+                auto get = [this](unsigned int i) -> const T & { return _set[i]; };
+                const unsigned int i = _index->find(element, h, get);
+                return i == _index->NOT_FOUND ? NO_POSITION : i;
+            }
+
+            if (_filter != nullptr && !_filter->possibly_contains(element))
+            {
+                return NO_POSITION;
+            }
+
+            if (_hash_cache)
+            {
+                for (unsigned int i = 0; i < _size; ++i)
+                {
+                    if (_hashes[i] == h && _eql(_set[i], element))
+                    {
+                        return i;
+                    }
+                }
+
+                return NO_POSITION;
+            }
+        }
+
+        for (unsigned int i = 0; i < _size; ++i)
+        {
+            if (_eql(_set[i], element))
+            {
+                return i;
+            }
+        }
+
+        return NO_POSITION;
+    }
+
+    /**
+     * @brief posizione in un altro set di un elemento di questo
+     *
+     * Se questo set ha la cache degli hash e other può usarli, passa a other l'hash memorizzato.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param other set in cui cercare
+     * @param i posizione dell'elemento in questo set
+     *
+     * @return posizione dell'elemento in other, NO_POSITION se non è presente
+     */
+    unsigned int position_in(const set &other, unsigned int i) const
+    {
+        if (_hash_cache && other.uses_hashes())
+        {
+            return other.position_of(_set[i], _hashes[i]);
+        }
+
+        return other.position_of(_set[i]);
+    }
+
+    /**
+     * @brief verifica se le ricerche usano l'hash degli elementi
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return true se il set ha un indice o la cache degli hash, false altrimenti
+     */
+    bool uses_hashes() const
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            return _index != nullptr || _hash_cache;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    /**
+     * @brief hash di un elemento
+     *
+     * Calcola l'hash dell'elemento come usato dall'indice e dalla cache degli hash.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento di cui calcolare l'hash
+     *
+     * @return 32 bit bassi dell'hash rimescolato, 0 se non è disponibile un funtore di hash
+     *
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    static std::uint32_t element_hash(const T &element)
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            return hash_index<T, Eql, Hash>().hash_of(element);
+        }
+        else
+        {
+            (void)element;
+            return 0;
+        }
+    }
+
+    /**
+     * @brief crea un set da una sequenza di elementi distinti
+     *
+     * Crea un nuovo set con gli elementi contenuti tra i due iteratori, senza cercare duplicati:
+     * l'array viene allocato una sola volta e ogni elemento viene scritto in coda.
+     * Usato da immutable_set, che ne garantisce già l'unicità; è privato perché una sequenza con duplicati
+     * violerebbe l'invariante del set senza alcun controllo.
+     * La compatibilità tra il tipo puntato dall'iteratore e il tipo T del set è gestita tramite un cast statico esplicito.
+     *
+     * @param begin iteratore all'inizio della sequenza
+     * @param end iteratore alla fine della sequenza
+     *
+     * @pre gli elementi tra begin e end sono distinti secondo Eql
+     * @pre IterT è almeno un forward iterator, dato che la sequenza viene percorsa due volte
+     *
+     * @return un set con gli elementi della sequenza, nello stesso ordine
+     *
+     * @throws std::bad_alloc se l'allocazione dell'array fallisce
+     * @throws ... eventuali eccezioni lanciate dalla conversione dei tipi o dall'assegnamento di T
+     */
+    template <typename IterT>
+    static set from_unique(IterT begin, IterT end)
+    {
+        set result;
+        result.reserve(static_cast<unsigned int>(std::distance(begin, end)));
+
+        while (begin != end)
+        {
+            result.append(static_cast<T>(*begin));
+            ++begin;
+        }
+
+        return result;
+    }
+
+    template <typename U, typename E, typename H>
+    friend set<U, E, H> operator+(const set<U, E, H> &left, const set<U, E, H> &right);
+
+    template <typename U, typename H, typename E>
+    friend class immutable_set;
+
+    template <typename U, typename E, typename H>
+    friend void load_packed(const std::string &filename, set<U, E, H> &s);
+
+    /**
+     * @brief unisce a questo set gli elementi di un altro
+     *
+     * Implementazione di operator+: cerca gli elementi di other assenti da questo set
+     * (usando gli hash memorizzati in other, se presenti), ingrandisce l'array una sola volta
+     * e li accoda con il loro hash.
+     * In caso di errore durante gli inserimenti, gli elementi già aggiunti restano nel set.
+     *
+     * @param other set da unire
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, del filtro o dell'indice fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T, da Eql o da Hash
+     */
+    void unite(const set &other)
+    {
+        std::vector<unsigned int> missing;
+        for (unsigned int i = 0; i < other._size; ++i)
+        {
+            if (other.position_in(*this, i) == NO_POSITION)
+            {
+                missing.push_back(i);
+            }
+        }
+
+        if (missing.empty())
+        {
+            return;
+        }
+
+        const unsigned int needed = _size + static_cast<unsigned int>(missing.size());
+        if (needed > _capacity || shared())
+        {
+            reallocate(needed > _capacity ? needed : _capacity);
+        }
+
+        for (unsigned int i : missing)
+        {
+            append(other._set[i], other._hash_cache ? &other._hashes[i] : nullptr);
+        }
+    }
+
+    /**
+     * @brief raccoglie gli elementi di un lotto
+     *
+     * Se la sequenza è percorribile più volte e i suoi elementi sono già di tipo T, ne raccoglie gli indirizzi;
+     * altrimenti ne salva in copies una copia convertita a T e raccoglie gli indirizzi delle copie.
+     *
+     * @param first iteratore al primo elemento
+     * @param last iteratore successivo all'ultimo elemento
+     * @param copies vettore in cui salvare le copie, che deve sopravvivere a queries
+     * @param queries vettore in cui raccogliere gli indirizzi degli elementi
+     *
+     * @throws std::bad_alloc se l'allocazione dei vettori fallisce
+     * @throws ... eventuali eccezioni lanciate dalla conversione degli elementi a T
+     */
+    template <typename InputIt>
+    static void gather(InputIt first, InputIt last, std::vector<T> &copies, std::vector<const T *> &queries)
+    {
+        typedef typename std::iterator_traits<InputIt>::reference reference;
+
+        if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>::value &&
+                      std::is_reference<reference>::value &&
+                      std::is_same<typename std::remove_cv<typename std::remove_reference<reference>::type>::type, T>::value)
+        {
+            for (; first != last; ++first)
+            {
+                queries.push_back(std::addressof(*first));
+            }
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                copies.push_back(static_cast<T>(*first));
+            }
+
+            queries.reserve(copies.size());
+            for (const T &c : copies)
+            {
+                queries.push_back(&c);
+            }
+        }
+    }
+
+    /**
+     * @brief cerca un lotto di elementi
+     *
+     * Implementazione di contains_many: imposta found[i] a 1 se *queries[i] è presente nel set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param queries indirizzi degli elementi da cercare
+     * @param found vettore dei risultati, della stessa dimensione di queries e inizializzato a 0
+     *
+     * @throws std::bad_alloc se l'allocazione delle strutture temporanee fallisce
+     * @throws ... eventuali eccezioni lanciate da Eql o Hash
+     */
+    void find_many(const std::vector<const T *> &queries, std::vector<unsigned char> &found) const
+    {
+        const std::size_t n = queries.size();
+
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (_index != nullptr)
+            {
+                auto get = [this](unsigned int i) -> const T & { return _set[i]; };
+                std::uint32_t hashes[PREFETCH_GROUP];
+
+                for (std::size_t base = 0; base < n; base += PREFETCH_GROUP)
+                {
+                    const std::size_t count = n - base < PREFETCH_GROUP ? n - base : PREFETCH_GROUP;
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        hashes[i] = _index->hash_of(*queries[base + i]);
+                        _index->prefetch(hashes[i]);
+                    }
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        found[base + i] = _index->find(*queries[base + i], hashes[i], get) != _index->NOT_FOUND;
+                    }
+                }
+                return;
+            }
+        }
+
+        // ricerche ancora aperte, dopo aver scartato quelle escluse dal filtro
+        std::vector<std::size_t> pending;
+        pending.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if constexpr (is_hash_enabled<Hash>::value)
+            {
+                if (_filter != nullptr && !_filter->possibly_contains(*queries[i]))
+                {
+                    continue;
+                }
+            }
+            pending.push_back(i);
+        }
+
+        // con la cache l'hash di ogni ricerca viene calcolato una volta e Eql chiamato solo sugli hash uguali
+        std::vector<std::uint32_t> hashes;
+        if (_hash_cache)
+        {
+            hashes.resize(n);
+            for (std::size_t i : pending)
+            {
+                hashes[i] = element_hash(*queries[i]);
+            }
+        }
+
+        const unsigned int block = sizeof(T) < BLOCK_BYTES ? static_cast<unsigned int>(BLOCK_BYTES / sizeof(T)) : 1;
+        for (unsigned int start = 0; start < _size && !pending.empty(); start += block)
+        {
+            const unsigned int stop = _size - start < block ? _size : start + block;
+
+            std::size_t open = 0;
+            for (std::size_t k = 0; k < pending.size(); ++k)
+            {
+                if (block_contains(start, stop, *queries[pending[k]], _hash_cache ? &hashes[pending[k]] : nullptr))
+                {
+                    found[pending[k]] = 1;
+                }
+                else
+                {
+                    pending[open++] = pending[k];
+                }
+            }
+            pending.resize(open);
+        }
+    }
+
+    /**
+     * @brief cerca un elemento in un blocco dell'array
+     *
+     * Per tipi aritmetici confrontati con std::equal_to scorre tutto il blocco confrontando 16 byte alla volta
+     * con le estensioni vettoriali di GCC; altrimenti si ferma al primo elemento uguale,
+     * chiamando Eql solo sugli elementi con lo stesso hash se questo è noto.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param start posizione del primo elemento del blocco
+     * @param stop posizione successiva all'ultimo elemento del blocco
+     * @param element elemento da cercare
+     * @param h hash dell'elemento da confrontare con la cache degli hash, nullptr se non è noto
+     *
+     * @return true se l'elemento è in _set[start, stop), false altrimenti
+     *
+     * @throws ... eventuali eccezioni lanciate da Eql
+     */
+    bool block_contains(unsigned int start, unsigned int stop, const T &element, const std::uint32_t *h = nullptr) const
+    {
+        if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+                      (std::is_same<Eql, std::equal_to<T>>::value || std::is_same<Eql, std::equal_to<>>::value))
+        {
+            // confronto a gruppi di 16 byte con le estensioni vettoriali di GCC, senza salti nel ciclo
+            typedef T lanes __attribute__((vector_size(16)));
+            const unsigned int width = sizeof(lanes) / sizeof(T);
+
+            const lanes needle = lanes{} + element;
+            decltype(needle == needle) any{};
+
+            unsigned int i = start;
+            for (; i + width <= stop; i += width)
+            {
+                lanes chunk;
+                std::memcpy(&chunk, _set + i, sizeof(lanes));
+                any |= chunk == needle;
+            }
+
+            for (unsigned int k = 0; k < width; ++k)
+            {
+                if (any[k] != 0)
+                {
+                    return true;
+                }
+            }
+
+            for (; i < stop; ++i)
+            {
+                if (_set[i] == element)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        else
+        {
+            for (unsigned int i = start; i < stop; ++i)
+            {
+                if ((h == nullptr || _hashes[i] == *h) && _eql(_set[i], element))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    /**
+     * @brief aggiunge un lotto di elementi
+     *
+     * Implementazione di add_many: imposta added[i] a 1 se *queries[i] viene aggiunto al set.
+     *
+     * @param queries indirizzi degli elementi da aggiungere
+     * @param added vettore dei risultati, della stessa dimensione di queries e inizializzato a 0
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, del filtro o delle strutture temporanee fallisce
+     * @throws ... eventuali eccezioni lanciate da Eql, Hash o dal costruttore di copia di T
+     */
+    void insert_many(const std::vector<const T *> &queries, std::vector<unsigned char> &added)
+    {
+        std::vector<unsigned char> found(queries.size(), 0);
+        find_many(queries, found);
+
+        // elementi assenti dal set, senza ripetizioni all'interno del lotto
+        std::vector<unsigned int> fresh;
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            hash_index<T, Eql, Hash> seen;
+            auto get = [&queries](unsigned int j) -> const T & { return *queries[j]; };
+            for (unsigned int i = 0; i < queries.size(); ++i)
+            {
+                if (!found[i])
+                {
+                    const std::uint32_t h = seen.hash_of(*queries[i]);
+                    if (seen.find(*queries[i], h, get) == seen.NOT_FOUND)
+                    {
+                        seen.insert(i, h);
+                        fresh.push_back(i);
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < queries.size(); ++i)
+            {
+                if (!found[i])
+                {
+                    bool repeated = false;
+                    for (unsigned int j = 0; j < fresh.size() && !repeated; ++j)
+                    {
+                        repeated = _eql(*queries[fresh[j]], *queries[i]);
+                    }
+                    if (!repeated)
+                    {
+                        fresh.push_back(i);
+                    }
+                }
+            }
+        }
+
+        if (fresh.empty())
+        {
+            return;
+        }
+
+        const unsigned int needed = _size + static_cast<unsigned int>(fresh.size());
+        if (needed > _capacity || shared())
+        {
+            reallocate(needed > _capacity ? needed : _capacity);
+        }
+
+        for (unsigned int i : fresh)
+        {
+            append(*queries[i]);
+            added[i] = 1;
+        }
+    }
+
+    /**
+     * @brief converte un vettore di risultati in una maschera di bit
+     *
+     * @param results vettore di risultati, 0 o 1
+     * @param mask array di almeno (N + 63) / 64 parole, con N dimensione di results
+     *
+     * @return numero di risultati pari a 1
+     */
+    static unsigned int to_mask(const std::vector<unsigned char> &results, std::uint64_t *mask)
+    {
+        unsigned int ones = 0;
+        for (std::size_t base = 0; base < results.size(); base += 64)
+        {
+            std::uint64_t word = 0;
+            for (std::size_t i = base; i < results.size() && i < base + 64; ++i)
+            {
+                word |= static_cast<std::uint64_t>(results[i]) << (i - base);
+                ones += results[i];
+            }
+            mask[base / 64] = word;
+        }
+        return ones;
+    }
+
+    /**
+     * @brief metodo di pulizia della memoria occupata
+     *
+     * Rilascia la memoria occupata dal set corrente e reimposta allo stato coerente iniziale vuoto.
+     * La memoria viene liberata solo se non è condivisa con altri set.
+     *
+     * @post _set == nullptr
+     * @post _size == 0
+     * @post _capacity == 0
+     * @post _filter == nullptr
+     * @post _hashes == nullptr
+     */
+    void clear()
+    {
+        commit(nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr);
+    }
+
+    /**
+     * @brief verifica se la memoria del set è condivisa
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return true se almeno un altro set condivide _set, _filter, _index e _hashes, false altrimenti
+     */
+    bool shared() const
+    {
+        return _refs != nullptr && _refs->load(std::memory_order_acquire) > 1;
+    }
+
+    /**
+     * @brief sostituisce la memoria del set
+     *
+     * Rilascia la memoria attuale (liberandola se nessun altro set la condivide) e installa quella passata,
+     * posseduta esclusivamente da questo set. Il filtro e l'indice passati possono coincidere con quelli attuali
+     * solo se la memoria attuale non è condivisa: in questo caso non vengono liberati.
+     *
+     * @param data nuovo array
+     * @param size numero di elementi nel nuovo array
+     * @param capacity dimensione del nuovo array
+     * @param filter nuovo filtro, nullptr se disabilitato
+     * @param index nuovo indice, nullptr se il set è piccolo
+     * @param hashes nuova cache degli hash, nullptr se disabilitata o se capacity == 0
+     * @param refs nuovo contatore di riferimenti pari a 1, nullptr se data, filter e index sono nullptr
+     *
+     * @post _set == data
+     * @post _size == size
+     * @post _capacity == capacity
+     * @post _filter == filter
+     * @post _index == index
+     * @post _hashes == hashes
+     * @post _refs == refs
+     */
+    void commit(T *data, unsigned int size, unsigned int capacity, bloom_filter<T, Hash> *filter,
+                hash_index<T, Eql, Hash> *index, std::uint32_t *hashes, std::atomic<unsigned int> *refs)
+    {
+        if (_refs != nullptr && _refs->fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            storage_detail::release(_set, _size);
+            storage_detail::deallocate(_hashes);
+            if (_filter != filter)
+            {
+                delete _filter;
+            }
+            if (_index != index)
+            {
+                delete _index;
+            }
+            delete _refs;
+        }
+
+        _set = data;
+        _size = size;
+        _capacity = capacity;
+        _filter = filter;
+        _index = index;
+        _hashes = hashes;
+        _refs = refs;
+    }
+
+    /**
+     * @brief crea una versione privata del set
+     *
+     * Se la memoria del set è condivisa, copia l'array (di dimensione minima), il filtro e l'indice e rilascia quelli condivisi.
+     * Al termine il set possiede esclusivamente la propria memoria e ha un contatore di riferimenti valido.
+     * In caso di errore l'operazione viene annullata senza intaccare lo stato precedente.
+     *
+     * @post shared() == false
+     * @post _refs != nullptr
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, del filtro o del contatore fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
+     */
+    void detach()
+    {
+        if (_refs != nullptr && !shared())
         {
-            return _t;
+            return;
         }
 
-        /**
-         * @brief operatore di post-incremento
-         *
-         * Operatore di post-incremento dell'iteratore.
-         * Sposta avanti l'iteratore e ritorna una copia nello stato precendente.
-         *
-         * @post _t == ++_t_precedente
-         *
-         * @return un iteratore nello stato precedente alla chiamata
-         */
-        const_iterator operator++(int)
+        if (_refs == nullptr)
         {
-            const_iterator tmp(*this);
-            ++_t;
-            return tmp;
+            _refs = new std::atomic<unsigned int>(1);
+            return;
         }
 
-        /**
-         * @brief operatore di pre-incremento
-         *
-         * Operatore di pre-incremento dell'iteratore.
-         * Sposta avanti l'iteratore e lo ritorna.
-         *
-         * @return l'iteratore aggiornato
-         */
-        const_iterator &operator++()
+        reallocate(_size);
+    }
+
+    /**
+     * @brief cambia la dimensione dell'array
+     *
+     * Porta l'array a capacity celle con gli stessi elementi, rendendolo privato:
+     * - se l'array non è condiviso lo sposta con storage_detail::relocate, insieme alla cache degli hash;
+     *   filtro e indice restano gli stessi
+     * - altrimenti copia gli elementi, la cache, il filtro e l'indice, rilasciando quelli condivisi
+     * Le posizioni degli elementi non cambiano, quindi l'indice resta valido.
+     * In caso di errore l'operazione viene annullata senza intaccare lo stato precedente.
+     *
+     * @param capacity nuova dimensione dell'array
+     *
+     * @pre capacity >= _size
+     * @pre capacity >= _capacity se l'array non è condiviso
+     *
+     * @post _capacity == capacity
+     * @post shared() == false
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo array, del filtro o del contatore fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
+     */
+    void reallocate(unsigned int capacity)
+    {
+        assert(capacity >= _size);
+
+        if (_refs != nullptr && !shared())
         {
-            ++_t;
-            return *this;
+            // la cache viene ingrandita per prima: se poi fallisce l'array, resta solo più grande di _capacity
+            if (_hash_cache)
+            {
+                _hashes = storage_detail::relocate(_hashes, _size, capacity);
+            }
+            _set = storage_detail::relocate(_set, _size, capacity);
+            _capacity = capacity;
+            return;
         }
 
-        /**
-         * @brief operatore di uguaglianza
-         *
-         * Operatore di uguaglianza dell'iteratore.
-         *
-         * @param other iteratore da confrontare
-         *
-         * @return true se _t == other._t, false altrimenti
-         */
-        bool operator==(const const_iterator &other) const
+        T *copySet = nullptr;
+        std::uint32_t *newHashes = nullptr;
+        std::atomic<unsigned int> *refs = nullptr;
+        bloom_filter<T, Hash> *newFilter = nullptr;
+        hash_index<T, Eql, Hash> *newIndex = nullptr;
+
+        try
         {
-            return _t == other._t;
-        }
+            refs = new std::atomic<unsigned int>(1);
 
-        /**
-         * @brief operatore di disuguaglianza
-         *
-         * Operatore di disuguaglianza dell'iteratore.
-         *
-         * @param other iteratore da confrontare
-         *
-         * @return true se _t != other._t, false altrimenti
-         */
-        bool operator!=(const const_iterator &other) const
+            if (_hash_cache)
+            {
+                newHashes = storage_detail::copy(_hashes, _size, capacity);
+            }
+
+            copySet = storage_detail::copy(_set, _size, capacity);
+
+            if (_filter != nullptr)
+            {
+                newFilter = new bloom_filter<T, Hash>(*_filter);
+            }
+
+            if (_index != nullptr)
+            {
+                newIndex = new hash_index<T, Eql, Hash>(*_index);
+            }
+        }
+        catch (...)
         {
-            return _t != other._t;
+            delete newFilter;
+            storage_detail::release(copySet, _size);
+            storage_detail::deallocate(newHashes);
+            delete refs;
+            throw;
         }
 
-    private:
-        const T *_t; ///< puntatore ad un oggetto costatnte di tipo T
+        commit(copySet, _size, capacity, newFilter, newIndex, newHashes, refs);
+    }
 
-        friend class set;
+    /**
+     * @brief filtro di Bloom dopo una modifica degli elementi
+     *
+     * Calcola il filtro da usare quando gli elementi del set diventano data[0,...,count-1],
+     * oppure data[0,...,count] tranne data[removed] se removed è indicato:
+     * - se il filtro è disabilitato ritorna nullptr
+     * - se è stato aggiunto un elemento, c'è spazio nel filtro e il filtro non è condiviso, lo aggiorna e lo ritorna
+     * - se è stato aggiunto un elemento, c'è spazio nel filtro ma il filtro è condiviso, ne ritorna una copia aggiornata
+     * - altrimenti ritorna un nuovo filtro costruito su data, di dimensione doppia se quella attuale non basta
+     * Un'eccezione durante l'aggiornamento lascia al più qualche bit in più impostato, senza falsi negativi.
+     *
+     * @param data array con gli elementi dopo la modifica
+     * @param count numero di elementi dopo la modifica
+     * @param added elemento aggiunto, nullptr se la modifica non è un'aggiunta
+     * @param removed posizione in data dell'elemento rimosso, NO_POSITION se la modifica non è una rimozione
+     *
+     * @return il filtro da usare dopo la modifica
+     *
+     * @throws std::bad_alloc se l'allocazione del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    bloom_filter<T, Hash> *updated_filter(const T *data, unsigned int count, const T *added, unsigned int removed = NO_POSITION)
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (_filter == nullptr)
+            {
+                return nullptr;
+            }
 
-        /**
-         * @brief costruttore privato di inizializzazione
-         *
-         * Costruttore privato di inizializzazione del const_iterator.
-         *
-         * @param t puntatore ad un oggetto di tipo T
-         *
-         * @post _t == t
-         */
-        const_iterator(pointer t) : _t(t) {}
-    }; // const_iterator
+            if (added != nullptr && count <= _filter->capacity())
+            {
+                if (!shared())
+                {
+                    _filter->add(*added);
+                    return _filter;
+                }
+
+                bloom_filter<T, Hash> *filter = new bloom_filter<T, Hash>(*_filter);
+                try
+                {
+                    filter->add(*added);
+                }
+                catch (...)
+                {
+                    delete filter;
+                    throw;
+                }
+                return filter;
+            }
+
+            unsigned int capacity = count > _filter->capacity() ? 2 * count : _filter->capacity();
+            return build_filter(data, count, capacity, _filter->fp_rate(), removed);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
 
     /**
-     * @brief iteratore di inizio
+     * @brief aggiunge in coda un elemento sicuramente assente
      *
-     * Ritorna l'iteratore di inizio sequenza del set.
-     * Questo metodo non altera lo stato della classe.
+     * Costruisce l'elemento nella prima cella libera dell'array e aggiorna il filtro di Bloom, l'indice
+     * e la cache degli hash, se presenti. Se l'hash dell'elemento è già noto viene usato invece di ricalcolarlo.
+     * Se la costruzione o l'aggiornamento falliscono la cella torna non inizializzata e gli elementi del set non cambiano;
+     * il filtro di Bloom, aggiornato sul posto, può però conservare i bit dell'elemento, che valgono come un falso positivo.
      *
-     * @return l'iteratore di inizio sequenza del set
+     * @param element valore da aggiungere al set
+     * @param h hash dell'elemento come calcolato da element_hash, nullptr se non è noto
+     *
+     * @pre contains(element) == false
+     * @pre _size < _capacity
+     * @pre shared() == false
+     *
+     * @post _size incrementata di 1
+     *
+     * @throws std::bad_alloc se l'allocazione del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
      */
-    iterator begin() const
+    void append(const T &element, const std::uint32_t *h = nullptr)
     {
-        return iterator(_set);
+        assert(_size < _capacity && !shared());
+
+        ::new (static_cast<void *>(_set + _size)) T(element);
+
+        bloom_filter<T, Hash> *newFilter = nullptr;
+        hash_index<T, Eql, Hash> *newIndex = nullptr;
+
+        try
+        {
+            std::uint32_t known = 0;
+            if (_hash_cache)
+            {
+                known = h != nullptr ? *h : element_hash(element);
+                _hashes[_size] = known;
+                h = &known;
+            }
+
+            newFilter = updated_filter(_set, _size + 1, &element);
+            newIndex = updated_index(_set, _size + 1, &element, NO_POSITION, h);
+        }
+        catch (...)
+        {
+            if (newFilter != _filter)
+            {
+                delete newFilter;
+            }
+            _set[_size].~T();
+            throw;
+        }
+
+        ++_size;
+
+        if (newFilter != _filter)
+        {
+            delete _filter;
+            _filter = newFilter;
+        }
+
+        if (newIndex != _index)
+        {
+            delete _index;
+            _index = newIndex;
+        }
     }
 
     /**
-     * @brief iteratore di fine
+     * @brief indice hash dopo una modifica degli elementi
      *
-     * Ritorna l'iteratore di fine sequenza del set.
-     * Questo metodo non altera lo stateo della classe.
+     * Calcola l'indice da usare quando gli elementi del set diventano data[0,...,count-1],
+     * oppure data[0,...,count] tranne data[removed] se removed è indicato:
+     * - se non è disponibile un funtore di hash, o il set senza indice non supera la soglia,
+     *   o il set con indice scende a metà soglia, ritorna nullptr
+     * - se è stato aggiunto un elemento in ultima posizione e l'indice non è condiviso, lo aggiorna e lo ritorna
+     * - se è stato aggiunto un elemento in ultima posizione ma l'indice è condiviso, ne ritorna una copia aggiornata
+     * - altrimenti ritorna un nuovo indice costruito su data
+     * In caso di errore l'indice attuale rimane invariato.
      *
-     * @return l'iteratore di fine sequenza del set
+     * @param data array con gli elementi dopo la modifica
+     * @param count numero di elementi dopo la modifica
+     * @param added elemento aggiunto in posizione count - 1, nullptr se la modifica non è un'aggiunta
+     * @param removed posizione in data dell'elemento rimosso, NO_POSITION se la modifica non è una rimozione
+     * @param added_hash hash dell'elemento aggiunto, nullptr se deve essere calcolato
+     *
+     * @pre se la cache degli hash è abilitata, data == _set e _hashes corrisponde a data
+     *
+     * @return l'indice da usare dopo la modifica
+     *
+     * @throws std::bad_alloc se l'allocazione dell'indice fallisce
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
      */
-    iterator end() const
+    hash_index<T, Eql, Hash> *updated_index(const T *data, unsigned int count, const T *added, unsigned int removed = NO_POSITION,
+                                            const std::uint32_t *added_hash = nullptr)
     {
-        return iterator(_set + _size);
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            const unsigned int threshold = index_threshold();
+            if (_index == nullptr ? count <= threshold : count <= threshold / 2)
+            {
+                return nullptr;
+            }
+
+            assert(!_hash_cache || data == _set);
+
+            if (added != nullptr && _index != nullptr)
+            {
+                const std::uint32_t h = added_hash != nullptr ? *added_hash : _index->hash_of(*added);
+                if (!shared())
+                {
+                    _index->insert(count - 1, h);
+                    return _index;
+                }
+
+                hash_index<T, Eql, Hash> *index = new hash_index<T, Eql, Hash>(*_index);
+                try
+                {
+                    index->insert(count - 1, h);
+                }
+                catch (...)
+                {
+                    delete index;
+                    throw;
+                }
+                return index;
+            }
+
+            hash_index<T, Eql, Hash> *index = new hash_index<T, Eql, Hash>(count);
+            try
+            {
+                const unsigned int total = removed == NO_POSITION ? count : count + 1;
+                for (unsigned int i = 0; i < total; ++i)
+                {
+                    if (i != removed)
+                    {
+                        index->insert(i < removed ? i : i - 1, _hash_cache ? _hashes[i] : index->hash_of(data[i]));
+                    }
+                }
+            }
+            catch (...)
+            {
+                delete index;
+                throw;
+            }
+            return index;
+        }
+        else
+        {
+            return nullptr;
+        }
     }
 
-private:
     /**
-     * @brief metodo di pulizia della memoria occupata
+     * @brief costruisce un filtro di Bloom su una sequenza di elementi
      *
-     * Libera la memoria occupata dal set corrente e reimposta allo stato coerente iniziale vuoto.
+     * Crea un nuovo filtro e vi aggiunge gli elementi passati.
+     * In caso di errore viene liberata la memoria occupata dal filtro.
      *
-     * @post _set == nullptr
-     * @post _size == 0
+     * @param elements puntatore al primo elemento
+     * @param count numero di elementi da aggiungere
+     * @param capacity numero di elementi per cui dimensionare il filtro, almeno 16
+     * @param fp_rate probabilità di falso positivo desiderata
+     * @param skipped posizione di un elemento da saltare, nel qual caso elements contiene count + 1 elementi
+     *
+     * @return puntatore al nuovo filtro, da liberare con delete
+     *
+     * @throws std::invalid_argument se fp_rate non è compreso tra 0 e 1
+     * @throws std::bad_alloc se l'allocazione del filtro fallisce
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
      */
-    void clear()
+    static bloom_filter<T, Hash> *build_filter(const T *elements, unsigned int count, unsigned int capacity, double fp_rate,
+                                               unsigned int skipped = NO_POSITION)
     {
-        delete[] _set;
-        _set = nullptr;
-        _size = 0;
+        bloom_filter<T, Hash> *filter = new bloom_filter<T, Hash>(capacity < 16 ? 16 : capacity, fp_rate);
+
+        try
+        {
+            const unsigned int total = skipped == NO_POSITION ? count : count + 1;
+            for (unsigned int i = 0; i < total; ++i)
+            {
+                if (i != skipped)
+                {
+                    filter->add(elements[i]);
+                }
+            }
+        }
+        catch (...)
+        {
+            delete filter;
+            throw;
+        }
+
+        return filter;
     }
 }; // set
 
@@ -610,10 +2958,10 @@ private:
  * @param os stream di output su cui stampare
  * @param s set da stampare
  */
-template <typename T, typename Eql>
-std::ostream &operator<<(std::ostream &os, const set<T, Eql> &s)
+template <typename T, typename Eql, typename Hash>
+std::ostream &operator<<(std::ostream &os, const set<T, Eql, Hash> &s)
 {
-    typename set<T, Eql>::const_iterator i, ie;
+    typename set<T, Eql, Hash>::const_iterator i, ie;
 
     i = s.begin();
     ie = s.end();
@@ -647,12 +2995,14 @@ std::ostream &operator<<(std::ostream &os, const set<T, Eql> &s)
  *
  * @return un set contenente tutti e soli gli elementi di S che rispettano pred
  */
-template <typename T, typename Eql, typename P>
-set<T, Eql> filter_out(const set<T, Eql> &S, P pred)
+template <typename T, typename Eql, typename Hash, typename P>
+set<T, Eql, Hash> filter_out(const set<T, Eql, Hash> &S, P pred)
 {
-    set<T, Eql> result;
+    SET_TRACE_SCOPE("filter_out", T, S.size());
+
+    set<T, Eql, Hash> result;
 
-    typename set<T, Eql>::const_iterator i, ie;
+    typename set<T, Eql, Hash>::const_iterator i, ie;
     i = S.begin();
     ie = S.end();
 
@@ -673,30 +3023,98 @@ set<T, Eql> filter_out(const set<T, Eql> &S, P pred)
  *
  * Ridefinizione dell'operatore somma tra due set compatibili.
  * Crea un set che contiene l'unione dei due set su cui viene chiamato l'operatore.
+ * Gli elementi di right assenti da left vengono aggiunti con una sola riallocazione,
+ * riusando gli hash memorizzati da right se ha la cache degli hash.
  *
  * @param left set di sinistra
  * @param right set di destra
  *
  * @return nuovo set contenente l'unione insiemistica dei due set precedenti
  */
-template <typename T, typename Eql>
-set<T, Eql> operator+(const set<T, Eql> &left, const set<T, Eql> &right)
+template <typename T, typename Eql, typename Hash>
+set<T, Eql, Hash> operator+(const set<T, Eql, Hash> &left, const set<T, Eql, Hash> &right)
 {
-    set<T, Eql> result = left;
+    SET_TRACE_SCOPE("operator+", T, left.size() + right.size());
 
-    typename set<T, Eql>::const_iterator i, ie;
-    i = right.begin();
-    ie = right.end();
-
-    while (i != ie)
-    {
-        result.add(*i);
-        i++;
-    }
+    set<T, Eql, Hash> result = left;
+    result.unite(right);
 
     return result;
 }
 
+/**
+ * @brief unione di una sequenza di set
+ *
+ * Crea un set che contiene l'unione di tutti i set tra i due iteratori.
+ * Equivale a concatenare gli operatori +, ma senza copiare il risultato parziale ad ogni passo.
+ * Vedi set::union_all.
+ *
+ * @param first iteratore al primo set
+ * @param last iteratore alla fine della sequenza di set
+ * @param threads numero di thread da usare
+ *
+ * @return nuovo set contenente l'unione insiemistica dei set
+ */
+template <typename SetIter>
+typename std::iterator_traits<SetIter>::value_type union_all(SetIter first, SetIter last, unsigned int threads = 1)
+{
+    return std::iterator_traits<SetIter>::value_type::union_all(first, last, threads);
+}
+
+/**
+ * @brief intersezione di una sequenza di set
+ *
+ * Crea un set che contiene gli elementi comuni a tutti i set tra i due iteratori.
+ * Vedi set::intersect_all.
+ *
+ * @param first iteratore al primo set
+ * @param last iteratore alla fine della sequenza di set
+ * @param threads numero di thread da usare
+ *
+ * @return nuovo set contenente l'intersezione insiemistica dei set
+ */
+template <typename SetIter>
+typename std::iterator_traits<SetIter>::value_type intersect_all(SetIter first, SetIter last, unsigned int threads = 1)
+{
+    return std::iterator_traits<SetIter>::value_type::intersect_all(first, last, threads);
+}
+
+/**
+ * @brief memoria occupata da una sequenza di set
+ *
+ * Somma la memoria occupata dai set tra i due iteratori, contando una sola volta quella condivisa.
+ * La memoria posseduta dagli elementi viene stimata con heap_bytes.
+ * Vedi set::memory_report.
+ *
+ * @param first iteratore al primo set
+ * @param last iteratore alla fine della sequenza di set
+ *
+ * @return il resoconto della memoria occupata dai set
+ */
+template <typename SetIter>
+memory_footprint memory_report(SetIter first, SetIter last)
+{
+    return std::iterator_traits<SetIter>::value_type::memory_report(first, last);
+}
+
+/**
+ * @brief memoria occupata da una sequenza di set con uno stimatore esplicito
+ *
+ * Come memory_report, ma la memoria posseduta dagli elementi viene stimata con il funtore heap.
+ * Vedi set::memory_report.
+ *
+ * @param first iteratore al primo set
+ * @param last iteratore alla fine della sequenza di set
+ * @param heap funtore che dato un elemento ritorna i byte che possiede fuori dall'array
+ *
+ * @return il resoconto della memoria occupata dai set
+ */
+template <typename SetIter, typename Heap>
+memory_footprint memory_report(SetIter first, SetIter last, Heap heap)
+{
+    return std::iterator_traits<SetIter>::value_type::memory_report(first, last, heap);
+}
+
 /**
  * @brief funzione per salvare un set su un file
  *
@@ -711,9 +3129,11 @@ set<T, Eql> operator+(const set<T, Eql> &left, const set<T, Eql> &right)
  *
  * @throw std::runtime_error se il file non viene aperto
  */
-template <typename T, typename Eql>
-void save(const set<T, Eql> &s, const std::string &filename)
+template <typename T, typename Eql, typename Hash>
+void save(const set<T, Eql, Hash> &s, const std::string &filename)
 {
+    SET_TRACE_SCOPE("save", T, s.size());
+
     std::ofstream ofs(filename);
     if (!ofs.is_open())
     {
@@ -722,7 +3142,7 @@ void save(const set<T, Eql> &s, const std::string &filename)
 
     ofs << s.size() << std::endl;
 
-    typename set<T, Eql>::const_iterator i, ie;
+    typename set<T, Eql, Hash>::const_iterator i, ie;
     i = s.begin();
     ie = s.end();
 
@@ -742,13 +3162,15 @@ void save(const set<T, Eql> &s, const std::string &filename)
  * - prima riga: lunghezza
  * - dalla seconda riga in poi: un elemento per riga
  * È necessario che venga implementato l'operatore di lettura da stream per il tipo templato T.
+ * Se s ha il filtro di Bloom abilitato, il set letto lo mantiene con la stessa probabilità di falso positivo;
+ * allo stesso modo mantiene la cache degli hash, se abilitata.
  *
  * @throw std::runtime_error se il file non esiste
  * @throws std::bad_alloc dal metodo add
  * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
  */
-template <typename T, typename Eql>
-void load(const std::string &filename, set<T, Eql> &s)
+template <typename T, typename Eql, typename Hash>
+void load(const std::string &filename, set<T, Eql, Hash> &s)
 {
     std::ifstream ifs(filename);
     if (!ifs.is_open())
@@ -756,10 +3178,24 @@ void load(const std::string &filename, set<T, Eql> &s)
         throw std::runtime_error("File can't be opened!");
     }
 
-    set<T, Eql> temp;
+    set<T, Eql, Hash> temp;
+    if constexpr (is_hash_enabled<Hash>::value)
+    {
+        if (s.has_filter())
+        {
+            temp.enable_filter(s.filter_fp_rate());
+        }
+        if (s.has_hash_cache())
+        {
+            temp.enable_hash_cache();
+        }
+    }
+
     unsigned int count;
     ifs >> count;
 
+    SET_TRACE_SCOPE("load", T, count);
+
     T val;
     while (count > 0)
     {
@@ -0,0 +1,338 @@
+/**
+ * @file set_reader.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe set_reader
+ *
+ * File di dichiarazione e definizione della classe templata set_reader,
+ * che legge un file prodotto da save un elemento alla volta, senza caricarlo in un set.
+ * Contiene anche la funzione globale per filtrare il contenuto del file.
+ */
+#ifndef SET_READER_HPP
+#define SET_READER_HPP
+
+#include <fstream>   // std::ifstream
+#include <iterator>  // std::input_iterator_tag
+#include <cstddef>   // std::ptrdiff_t
+#include <stdexcept> // std::runtime_error
+#include <string>    // std::string
+#include <vector>    // std::vector
+#include "set.hpp"
+
+/**
+ * @brief classe set_reader che rappresenta una lettura sequenziale di un file di set
+ *
+ * Legge un file nel formato di save (prima riga la lunghezza, poi un elemento per riga)
+ * e ne restituisce gli elementi uno alla volta tramite un input iterator.
+ * In memoria ci sono solo l'elemento corrente e un buffer di lettura anticipata di dimensione fissa,
+ * quindi il file può essere molto più grande della memoria disponibile.
+ * Come per load, è necessario che sia implementato l'operatore di lettura da stream per T.
+ *
+ * La sequenza può essere percorsa una sola volta: begin() ritorna sempre un iteratore sull'elemento corrente.
+ * Gli iteratori possono essere passati direttamente agli algoritmi della libreria standard che accettano
+ * input iterator (ad esempio std::count_if) e al costruttore da sequenza di set.
+ * Il reader non può essere copiato.
+ */
+template <typename T>
+class set_reader
+{
+public:
+    static const unsigned int BUFFER_SIZE = 1 << 16; ///< dimensione in byte del buffer di lettura anticipata
+
+private:
+    std::vector<char> _buffer; ///< buffer di lettura anticipata dello stream
+    std::ifstream _ifs;        ///< stream del file
+    unsigned int _size;        ///< numero di elementi dichiarato nel file
+    unsigned int _remaining;   ///< numero di elementi ancora da leggere
+    T _current;                ///< elemento corrente
+    bool _started;             ///< true se il primo elemento è già stato letto
+    bool _valid;               ///< true se _current contiene un elemento non ancora superato
+
+public:
+    /**
+     * @brief costruttore a partire da un file
+     *
+     * Apre il file e ne legge la lunghezza; gli elementi vengono letti solo durante l'iterazione.
+     *
+     * @param filename stringa contenente il file da leggere
+     *
+     * @throw std::runtime_error se il file non esiste o non contiene la lunghezza
+     * @throws std::bad_alloc se l'allocazione del buffer fallisce
+     */
+    explicit set_reader(const std::string &filename)
+        : _buffer(BUFFER_SIZE), _size(0), _remaining(0), _current(), _started(false), _valid(false)
+    {
+        _ifs.rdbuf()->pubsetbuf(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+        _ifs.open(filename);
+        if (!_ifs.is_open())
+        {
+            throw std::runtime_error("File can't be opened!");
+        }
+
+        if (!(_ifs >> _size))
+        {
+            throw std::runtime_error("Corrupted file!");
+        }
+        _remaining = _size;
+    }
+
+    set_reader(const set_reader &other) = delete;
+    set_reader &operator=(const set_reader &other) = delete;
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Chiude il file.
+     */
+    ~set_reader()
+    {
+        _ifs.close();
+    }
+
+    /**
+     * @brief numero di elementi del file
+     *
+     * @return numero di elementi dichiarato nella prima riga del file
+     */
+    unsigned int size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief iteratore di input della classe set_reader
+     *
+     * Ogni incremento legge l'elemento successivo dal file.
+     * Tutti gli iteratori di uno stesso reader condividono la posizione di lettura.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief elemento ritornato dal post-incremento
+         */
+        struct postfix_value
+        {
+            T value; ///< copia dell'elemento
+
+            /**
+             * @brief operatore di dereferenziamento
+             *
+             * @return l'elemento copiato
+             */
+            const T &operator*() const
+            {
+                return value;
+            }
+        };
+
+        /**
+         * @brief costruttore di default
+         *
+         * Crea un iteratore di fine sequenza.
+         */
+        const_iterator() : _reader(nullptr) {}
+
+        /**
+         * @brief operatore di dereferenziamento
+         *
+         * @pre l'iteratore non è di fine sequenza
+         *
+         * @return l'elemento corrente
+         */
+        reference operator*() const
+        {
+            return _reader->_current;
+        }
+
+        /**
+         * @brief operatore freccia
+         *
+         * @pre l'iteratore non è di fine sequenza
+         *
+         * @return il puntatore all'elemento corrente
+         */
+        pointer operator->() const
+        {
+            return &_reader->_current;
+        }
+
+        /**
+         * @brief operatore di pre-incremento
+         *
+         * Legge l'elemento successivo.
+         *
+         * @return l'iteratore aggiornato
+         *
+         * @throw std::runtime_error se il file termina prima del numero di elementi dichiarato
+         */
+        const_iterator &operator++()
+        {
+            _reader->next();
+            return *this;
+        }
+
+        /**
+         * @brief operatore di post-incremento
+         *
+         * Dato che gli iteratori condividono la posizione di lettura, non è possibile ritornare
+         * un iteratore nello stato precedente: viene ritornata una copia dell'elemento corrente,
+         * dereferenziabile come in *it++.
+         *
+         * @return un oggetto che contiene l'elemento corrente prima dell'incremento
+         *
+         * @throw std::runtime_error se il file termina prima del numero di elementi dichiarato
+         */
+        postfix_value operator++(int)
+        {
+            postfix_value tmp{_reader->_current};
+            _reader->next();
+            return tmp;
+        }
+
+        /**
+         * @brief operatore di uguaglianza
+         *
+         * Due iteratori sono uguali se sono entrambi di fine sequenza o se appartengono allo stesso reader non esaurito.
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori sono uguali
+         */
+        bool operator==(const const_iterator &other) const
+        {
+            return at_end() ? other.at_end() : (!other.at_end() && _reader == other._reader);
+        }
+
+        /**
+         * @brief operatore di disuguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori non sono uguali
+         */
+        bool operator!=(const const_iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        set_reader *_reader; ///< reader da cui leggere, nullptr per l'iteratore di fine sequenza
+
+        friend class set_reader;
+
+        /**
+         * @brief costruttore privato
+         *
+         * @param reader reader da cui leggere
+         */
+        explicit const_iterator(set_reader *reader) : _reader(reader) {}
+
+        /**
+         * @brief verifica se l'iteratore è di fine sequenza
+         *
+         * @return true se non ci sono altri elementi da restituire
+         */
+        bool at_end() const
+        {
+            return _reader == nullptr || !_reader->_valid;
+        }
+    }; // const_iterator
+
+    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * Alla prima chiamata legge il primo elemento; le chiamate successive ritornano un iteratore
+     * sull'elemento corrente, senza ripartire dall'inizio del file.
+     *
+     * @return l'iteratore sull'elemento corrente
+     *
+     * @throw std::runtime_error se il file termina prima del numero di elementi dichiarato
+     */
+    iterator begin()
+    {
+        if (!_started)
+        {
+            _started = true;
+            next();
+        }
+
+        return iterator(this);
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * @return l'iteratore di fine sequenza
+     */
+    iterator end()
+    {
+        return iterator();
+    }
+
+private:
+    /**
+     * @brief legge l'elemento successivo
+     *
+     * @post _valid == false se sono già stati letti tutti gli elementi dichiarati
+     *
+     * @throw std::runtime_error se il file termina prima del numero di elementi dichiarato
+     */
+    void next()
+    {
+        if (_remaining == 0)
+        {
+            _valid = false;
+            return;
+        }
+
+        if (!(_ifs >> _current))
+        {
+            _valid = false;
+            throw std::runtime_error("Corrupted file!");
+        }
+
+        --_remaining;
+        _valid = true;
+    }
+}; // set_reader
+
+/**
+ * @brief funzione per filtrare un file di set senza caricarlo
+ *
+ * Crea un set che contiene solo gli elementi del file che rispettano pred,
+ * leggendoli uno alla volta: in memoria ci sono solo gli elementi selezionati.
+ * I funtori del set risultante vanno indicati esplicitamente, ad esempio filter_out<std::equal_to<int>>(reader, pred).
+ *
+ * @param reader reader da cui leggere gli elementi, dalla posizione corrente
+ * @param pred predicato booleano che prende in input un oggetto di tipo T
+ *
+ * @return un set contenente tutti e soli gli elementi letti che rispettano pred
+ *
+ * @throw std::runtime_error se il file termina prima del numero di elementi dichiarato
+ * @throws std::bad_alloc dal metodo add
+ */
+template <typename Eql, typename Hash = no_hash, typename T, typename P>
+set<T, Eql, Hash> filter_out(set_reader<T> &reader, P pred)
+{
+    set<T, Eql, Hash> result;
+
+    for (typename set_reader<T>::const_iterator i = reader.begin(), ie = reader.end(); i != ie; ++i)
+    {
+        if (pred(*i))
+        {
+            result.add(*i);
+        }
+    }
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,774 @@
+/**
+ * @file shared_set.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe shared_set
+ *
+ * File di dichiarazione e definizione della classe templata shared_set,
+ * un insieme in memoria condivisa POSIX che più processi possono leggere senza farne copie.
+ * Contiene anche le funzioni globali per:
+ * - scrittura su stream
+ * - filtraggio
+ */
+#ifndef SHARED_SET_HPP
+#define SHARED_SET_HPP
+
+#include <atomic>      // std::atomic
+#include <cerrno>      // errno, ENOENT, EEXIST
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint32_t, std::uint64_t
+#include <cstring>     // std::memcpy
+#include <new>         // placement new
+#include <utility>     // std::move, std::swap
+#include <ostream>     // ostream
+#include <stdexcept>   // std::runtime_error
+#include <string>      // std::string, std::to_string
+#include <type_traits> // std::is_trivially_copyable
+#include <vector>      // std::vector
+#include <fcntl.h>     // O_CREAT, O_EXCL, O_RDONLY, O_RDWR
+#include <sys/mman.h>  // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // ftruncate, close
+#include "hashing.hpp"
+#include "set.hpp"
+
+/**
+ * @brief classe shared_set che rappresenta un insieme in memoria condivisa
+ *
+ * Un processo costruisce un set e lo pubblica con publish sotto un nome; gli altri processi si collegano
+ * allo stesso nome in sola lettura e usano contains, l'iterazione e filter_out direttamente sulla memoria condivisa:
+ * sull'host esiste una sola copia degli elementi invece di una per processo.
+ *
+ * Ogni nome corrisponde a due tipi di oggetti di memoria condivisa:
+ * - l'oggetto di controllo, con nome name, che contiene il numero della versione pubblicata
+ * - un oggetto per ogni versione, con nome name_v<versione>, che contiene un'intestazione,
+ *   l'array degli elementi e, se è disponibile un funtore di hash, una tabella hash di posizioni
+ * I riferimenti interni sono spostamenti (offset) dall'inizio dell'oggetto, quindi restano validi
+ * qualunque sia l'indirizzo a cui ogni processo mappa la memoria.
+ * Le intestazioni contengono un numero di formato e la dimensione degli elementi, verificati al collegamento.
+ *
+ * Per aggiornare l'insieme publish scrive una nuova versione completa e poi sostituisce atomicamente
+ * il numero di versione nell'oggetto di controllo; la versione precedente viene rimossa dal nome
+ * ma resta leggibile dai processi che la stanno usando finché non chiamano refresh o vengono distrutti.
+ * Un collegamento non cambia mai versione da solo: refresh passa esplicitamente alla versione più recente.
+ *
+ * È templata su tre tipi:
+ * - T: tipo degli elementi, banalmente copiabile e senza puntatori, perché viene copiato byte per byte
+ * - Eql: funtore di confronto tra due elementi
+ * - Hash: funtore di hash coerente con Eql, facoltativo; deve dare lo stesso risultato in tutti i processi.
+ *   Se non è disponibile la ricerca è lineare
+ *
+ * Ci può essere un solo processo che pubblica per ogni nome. La pubblicazione richiede accesso in scrittura,
+ * i lettori solo in lettura. Gli oggetti restano nel sistema finché non viene chiamato destroy.
+ */
+template <typename T, typename Eql, typename Hash = no_hash>
+class shared_set
+{
+    static_assert(std::is_trivially_copyable<T>::value, "shared_set requires a trivially copyable element type");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared_set requires lock-free 64-bit atomics");
+
+public:
+    static const std::uint32_t LAYOUT = 1; ///< numero di formato della memoria condivisa
+
+private:
+    static const std::uint64_t MAGIC = 0x5445535F44524853ULL; ///< "SHRD_SET" in little endian
+    static const std::uint32_t EMPTY = 0xFFFFFFFFu;           ///< indice delle celle vuote della tabella
+    static const unsigned int ATTEMPTS = 100;                 ///< tentativi di collegamento durante una pubblicazione
+
+    /**
+     * @brief intestazione dell'oggetto di controllo
+     */
+    struct control
+    {
+        std::uint64_t magic;                ///< MAGIC
+        std::uint32_t layout;               ///< LAYOUT
+        std::uint32_t element_size;         ///< sizeof(T)
+        std::atomic<std::uint64_t> version; ///< versione pubblicata, 0 se non ancora pubblicata
+    };
+
+    /**
+     * @brief intestazione dell'oggetto di una versione
+     */
+    struct header
+    {
+        std::uint64_t magic;           ///< MAGIC
+        std::uint32_t layout;          ///< LAYOUT
+        std::uint32_t element_size;    ///< sizeof(T)
+        std::uint64_t version;         ///< versione contenuta
+        std::uint64_t size;            ///< numero di elementi
+        std::uint64_t elements_offset; ///< spostamento dell'array degli elementi
+        std::uint64_t slots;           ///< numero di celle della tabella hash, potenza di 2 oppure 0
+        std::uint64_t slots_offset;    ///< spostamento della tabella hash
+        std::uint64_t bytes;           ///< dimensione totale dell'oggetto
+    };
+
+    /**
+     * @brief cella della tabella hash
+     */
+    struct slot
+    {
+        std::uint32_t hash;  ///< 32 bit bassi dell'hash rimescolato
+        std::uint32_t index; ///< posizione dell'elemento, EMPTY se la cella è vuota
+    };
+
+    std::string _name;            ///< nome dell'insieme
+    const control *_control;      ///< oggetto di controllo mappato
+    const unsigned char *_base;   ///< oggetto della versione mappato
+    std::size_t _bytes;           ///< dimensione della mappatura della versione
+    const header *_header;        ///< intestazione della versione
+    const T *_elements;           ///< array degli elementi
+    const slot *_slots;           ///< tabella hash, nullptr senza funtore di hash
+
+    Eql _eql;   ///< istanza del funtore di confronto
+    Hash _hash; ///< istanza del funtore di hash
+
+public:
+    typedef const T *const_iterator; ///< iteratore costante, è un puntatore alla memoria condivisa
+
+    typedef const_iterator iterator; ///< dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief costruttore
+     *
+     * Si collega in sola lettura alla versione pubblicata dell'insieme name.
+     *
+     * @param name nome dell'insieme, con le regole di shm_open: inizia con '/' e non contiene altri '/'
+     *
+     * @throw std::runtime_error se l'insieme non esiste o non è ancora stato pubblicato,
+     *        o se la memoria ha un formato o un tipo di elemento diverso
+     */
+    explicit shared_set(const std::string &name)
+        : _name(name), _control(nullptr), _base(nullptr), _bytes(0), _header(nullptr), _elements(nullptr), _slots(nullptr)
+    {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Shared memory can't be opened!");
+        }
+
+        void *map = map_object(fd, sizeof(control), PROT_READ);
+        close(fd);
+        if (map == nullptr)
+        {
+            throw std::runtime_error("Corrupted shared memory!");
+        }
+        _control = static_cast<const control *>(map);
+
+        try
+        {
+            attach();
+        }
+        catch (...)
+        {
+            munmap(const_cast<control *>(_control), sizeof(control));
+            throw;
+        }
+    }
+
+    shared_set(const shared_set &other) = delete;
+    shared_set &operator=(const shared_set &other) = delete;
+
+    /**
+     * @brief costruttore di spostamento
+     *
+     * @param other collegamento da spostare, che rimane scollegato e può solo essere distrutto
+     */
+    shared_set(shared_set &&other)
+        : _name(std::move(other._name)), _control(other._control), _base(other._base), _bytes(other._bytes),
+          _header(other._header), _elements(other._elements), _slots(other._slots)
+    {
+        other._control = nullptr;
+        other._base = nullptr;
+    }
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Rimuove le mappature; gli oggetti di memoria condivisa restano.
+     */
+    ~shared_set()
+    {
+        detach();
+        if (_control != nullptr)
+        {
+            munmap(const_cast<control *>(_control), sizeof(control));
+            _control = nullptr;
+        }
+    }
+
+    /**
+     * @brief pubblica un set
+     *
+     * Scrive gli elementi di s in una nuova versione dell'insieme name e la rende quella corrente,
+     * creando l'insieme se non esiste. La versione precedente viene rimossa dal nome,
+     * ma i processi collegati continuano a leggerla finché non chiamano refresh.
+     * In caso di errore la versione corrente rimane invariata.
+     *
+     * @param name nome dell'insieme, con le regole di shm_open
+     * @param s set da pubblicare
+     *
+     * @return il numero della versione pubblicata
+     *
+     * @throw std::runtime_error se la memoria condivisa non può essere creata o ha un formato diverso
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    static std::uint64_t publish(const std::string &name, const set<T, Eql, Hash> &s)
+    {
+        control *ctl = open_control(name);
+        const std::uint64_t previous = ctl->version.load(std::memory_order_acquire);
+        const std::uint64_t version = previous + 1;
+
+        try
+        {
+            write_version(name, version, s);
+        }
+        catch (...)
+        {
+            munmap(ctl, sizeof(control));
+            throw;
+        }
+
+        ctl->version.store(version, std::memory_order_release);
+        munmap(ctl, sizeof(control));
+
+        if (previous > 0)
+        {
+            shm_unlink(version_name(name, previous).c_str());
+        }
+
+        return version;
+    }
+
+    /**
+     * @brief rimuove un insieme
+     *
+     * Rimuove dal sistema i nomi dell'oggetto di controllo e della versione corrente.
+     * I processi collegati continuano a leggere le proprie versioni.
+     *
+     * @param name nome dell'insieme
+     */
+    static void destroy(const std::string &name)
+    {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd >= 0)
+        {
+            void *map = map_object(fd, sizeof(control), PROT_READ);
+            close(fd);
+            if (map != nullptr)
+            {
+                const std::uint64_t version = static_cast<control *>(map)->version.load(std::memory_order_acquire);
+                munmap(map, sizeof(control));
+                if (version > 0)
+                {
+                    shm_unlink(version_name(name, version).c_str());
+                }
+            }
+        }
+
+        shm_unlink(name.c_str());
+    }
+
+    /**
+     * @brief passa alla versione più recente
+     *
+     * Se è stata pubblicata una versione successiva a quella letta, vi si collega e rilascia la precedente.
+     * Gli iteratori e i riferimenti agli elementi della versione precedente non sono più validi.
+     * In caso di errore il collegamento rimane sulla versione precedente.
+     *
+     * @return true se la versione è cambiata, false altrimenti
+     *
+     * @throw std::runtime_error se la nuova versione ha un formato o un tipo di elemento diverso
+     */
+    bool refresh()
+    {
+        if (_control->version.load(std::memory_order_acquire) == _header->version)
+        {
+            return false;
+        }
+
+        shared_set next(_name);
+        swap(next);
+        return true;
+    }
+
+    /**
+     * @brief versione letta
+     *
+     * @return il numero della versione a cui si è collegati
+     */
+    std::uint64_t version() const
+    {
+        return _header->version;
+    }
+
+    /**
+     * @brief numero di elementi
+     *
+     * @return numero di elementi della versione letta
+     */
+    unsigned int size() const
+    {
+        return static_cast<unsigned int>(_header->size);
+    }
+
+    /**
+     * @brief operatore [] di accesso agli elementi
+     *
+     * @param i indice dell'elemento
+     *
+     * @pre i < size()
+     *
+     * @return reference costante all'elemento in memoria condivisa
+     */
+    const T &operator[](unsigned int i) const
+    {
+        return _elements[i];
+    }
+
+    /**
+     * @brief verifica se un elemento è presente
+     *
+     * Con un funtore di hash cerca nella tabella hash condivisa, altrimenti scorre l'array.
+     *
+     * @param element elemento da cercare
+     *
+     * @return true se l'elemento è presente, false altrimenti
+     *
+     * @throws ... eventuali eccezioni lanciate dai funtori Eql e Hash
+     */
+    bool contains(const T &element) const
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (_header->slots > 0)
+            {
+                const std::uint32_t h = static_cast<std::uint32_t>(hash_mix(static_cast<std::uint64_t>(_hash(element))));
+                const std::uint64_t mask = _header->slots - 1;
+                for (std::uint64_t pos = h & mask;; pos = (pos + 1) & mask)
+                {
+                    const slot &s = _slots[pos];
+                    if (s.index == EMPTY)
+                    {
+                        return false;
+                    }
+
+                    if (s.hash == h && _eql(_elements[s.index], element))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        for (std::uint64_t i = 0; i < _header->size; ++i)
+        {
+            if (_eql(_elements[i], element))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * @return puntatore al primo elemento in memoria condivisa
+     */
+    const_iterator begin() const
+    {
+        return _elements;
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * @return puntatore dopo l'ultimo elemento in memoria condivisa
+     */
+    const_iterator end() const
+    {
+        return _elements + _header->size;
+    }
+
+    /**
+     * @brief scambia due collegamenti
+     *
+     * @param other collegamento con cui scambiare il contenuto
+     */
+    void swap(shared_set &other)
+    {
+        std::swap(_name, other._name);
+        std::swap(_control, other._control);
+        std::swap(_base, other._base);
+        std::swap(_bytes, other._bytes);
+        std::swap(_header, other._header);
+        std::swap(_elements, other._elements);
+        std::swap(_slots, other._slots);
+    }
+
+private:
+    /**
+     * @brief nome dell'oggetto di una versione
+     *
+     * @param name nome dell'insieme
+     * @param version numero della versione
+     *
+     * @return il nome dell'oggetto di memoria condivisa
+     */
+    static std::string version_name(const std::string &name, std::uint64_t version)
+    {
+        return name + "_v" + std::to_string(version);
+    }
+
+    /**
+     * @brief mappa un oggetto di memoria condivisa
+     *
+     * @param fd descrittore dell'oggetto
+     * @param bytes numero minimo di byte che l'oggetto deve avere, tutti mappati
+     * @param protection protezione della mappatura
+     *
+     * @return l'indirizzo della mappatura, nullptr se l'oggetto è più piccolo o la mappatura fallisce
+     */
+    static void *map_object(int fd, std::size_t bytes, int protection)
+    {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < bytes)
+        {
+            return nullptr;
+        }
+
+        void *map = mmap(nullptr, bytes, protection, MAP_SHARED, fd, 0);
+        return map == MAP_FAILED ? nullptr : map;
+    }
+
+    /**
+     * @brief apre o crea l'oggetto di controllo
+     *
+     * @param name nome dell'insieme
+     *
+     * @return l'oggetto di controllo mappato in scrittura
+     *
+     * @throw std::runtime_error se l'oggetto non può essere creato o ha un formato diverso
+     */
+    static control *open_control(const std::string &name)
+    {
+        const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Shared memory can't be created!");
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (info.st_size == 0 && ftruncate(fd, sizeof(control)) != 0))
+        {
+            close(fd);
+            throw std::runtime_error("Shared memory can't be created!");
+        }
+        const bool created = info.st_size == 0;
+
+        void *map = map_object(fd, sizeof(control), PROT_READ | PROT_WRITE);
+        close(fd);
+        if (map == nullptr)
+        {
+            throw std::runtime_error("Corrupted shared memory!");
+        }
+
+        control *ctl;
+        if (created)
+        {
+            ctl = new (map) control;
+            ctl->magic = MAGIC;
+            ctl->layout = LAYOUT;
+            ctl->element_size = sizeof(T);
+            ctl->version.store(0, std::memory_order_release);
+        }
+        else
+        {
+            ctl = static_cast<control *>(map);
+        }
+
+        if (ctl->magic != MAGIC || ctl->layout != LAYOUT || ctl->element_size != sizeof(T))
+        {
+            munmap(map, sizeof(control));
+            throw std::runtime_error("Corrupted shared memory!");
+        }
+
+        return ctl;
+    }
+
+    /**
+     * @brief scrive una versione
+     *
+     * Crea l'oggetto della versione, vi copia gli elementi e costruisce la tabella hash.
+     * In caso di errore l'oggetto viene rimosso.
+     *
+     * @param name nome dell'insieme
+     * @param version numero della versione
+     * @param s set da scrivere
+     *
+     * @throw std::runtime_error se l'oggetto non può essere creato
+     * @throws ... eventuali eccezioni lanciate dal funtore Hash
+     */
+    static void write_version(const std::string &name, std::uint64_t version, const set<T, Eql, Hash> &s)
+    {
+        const std::uint64_t size = s.size();
+        std::uint64_t slots = 0;
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            // tabella piena al più al 50%, così le ricerche di elementi assenti terminano presto
+            slots = 16;
+            while (slots < 2 * size)
+            {
+                slots *= 2;
+            }
+        }
+
+        const std::uint64_t elements_offset = align(sizeof(header), alignof(T));
+        const std::uint64_t slots_offset = align(elements_offset + size * sizeof(T), alignof(slot));
+        const std::uint64_t bytes = slots_offset + slots * sizeof(slot);
+
+        // una versione rimasta da una pubblicazione interrotta viene sovrascritta
+        const std::string object = version_name(name, version);
+        shm_unlink(object.c_str());
+        const int fd = shm_open(object.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Shared memory can't be created!");
+        }
+
+        void *map = nullptr;
+        if (ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+        {
+            map = map_object(fd, bytes, PROT_READ | PROT_WRITE);
+        }
+        close(fd);
+        if (map == nullptr)
+        {
+            shm_unlink(object.c_str());
+            throw std::runtime_error("Shared memory can't be created!");
+        }
+
+        unsigned char *base = static_cast<unsigned char *>(map);
+        try
+        {
+            T *elements = reinterpret_cast<T *>(base + elements_offset);
+            for (std::uint64_t i = 0; i < size; ++i)
+            {
+                std::memcpy(static_cast<void *>(elements + i), &s[static_cast<unsigned int>(i)], sizeof(T));
+            }
+
+            if constexpr (is_hash_enabled<Hash>::value)
+            {
+                const Hash hash;
+                slot *table = reinterpret_cast<slot *>(base + slots_offset);
+                for (std::uint64_t i = 0; i < slots; ++i)
+                {
+                    table[i] = slot{0, EMPTY};
+                }
+
+                const std::uint64_t mask = slots - 1;
+                for (std::uint64_t i = 0; i < size; ++i)
+                {
+                    const std::uint32_t h = static_cast<std::uint32_t>(hash_mix(static_cast<std::uint64_t>(hash(elements[i]))));
+                    std::uint64_t pos = h & mask;
+                    while (table[pos].index != EMPTY)
+                    {
+                        pos = (pos + 1) & mask;
+                    }
+                    table[pos] = slot{h, static_cast<std::uint32_t>(i)};
+                }
+            }
+        }
+        catch (...)
+        {
+            munmap(map, bytes);
+            shm_unlink(object.c_str());
+            throw;
+        }
+
+        header *head = reinterpret_cast<header *>(base);
+        head->magic = MAGIC;
+        head->layout = LAYOUT;
+        head->element_size = sizeof(T);
+        head->version = version;
+        head->size = size;
+        head->elements_offset = elements_offset;
+        head->slots = slots;
+        head->slots_offset = slots_offset;
+        head->bytes = bytes;
+
+        munmap(map, bytes);
+    }
+
+    /**
+     * @brief arrotonda uno spostamento a un allineamento
+     *
+     * @param offset spostamento
+     * @param alignment allineamento, potenza di 2
+     *
+     * @return il minimo multiplo di alignment non minore di offset
+     */
+    static std::uint64_t align(std::uint64_t offset, std::uint64_t alignment)
+    {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    /**
+     * @brief si collega alla versione corrente
+     *
+     * Se la versione letta viene sostituita prima di essere aperta, riprova con quella nuova.
+     *
+     * @throw std::runtime_error se l'insieme non è stato pubblicato o la versione ha un formato diverso
+     */
+    void attach()
+    {
+        if (_control->magic != MAGIC || _control->layout != LAYOUT || _control->element_size != sizeof(T))
+        {
+            throw std::runtime_error("Corrupted shared memory!");
+        }
+
+        for (unsigned int attempt = 0; attempt < ATTEMPTS; ++attempt)
+        {
+            const std::uint64_t version = _control->version.load(std::memory_order_acquire);
+            if (version == 0)
+            {
+                throw std::runtime_error("Shared memory can't be opened!");
+            }
+
+            const int fd = shm_open(version_name(_name, version).c_str(), O_RDONLY, 0);
+            if (fd < 0)
+            {
+                if (errno == ENOENT)
+                {
+                    continue;
+                }
+                throw std::runtime_error("Shared memory can't be opened!");
+            }
+
+            struct stat info;
+            const bool sized = fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(header);
+            void *map = sized ? map_object(fd, static_cast<std::size_t>(info.st_size), PROT_READ) : nullptr;
+            close(fd);
+            if (map == nullptr)
+            {
+                throw std::runtime_error("Corrupted shared memory!");
+            }
+
+            _base = static_cast<const unsigned char *>(map);
+            _bytes = static_cast<std::size_t>(info.st_size);
+            _header = reinterpret_cast<const header *>(_base);
+
+            const header &h = *_header;
+            const bool valid = h.magic == MAGIC && h.layout == LAYOUT && h.element_size == sizeof(T) && h.version == version &&
+                               h.bytes <= _bytes && h.elements_offset + h.size * sizeof(T) <= h.slots_offset &&
+                               h.slots_offset + h.slots * sizeof(slot) <= h.bytes && (h.slots & (h.slots - 1)) == 0 &&
+                               h.slots >= (is_hash_enabled<Hash>::value ? h.size + 1 : 0);
+            if (!valid)
+            {
+                detach();
+                throw std::runtime_error("Corrupted shared memory!");
+            }
+
+            _elements = reinterpret_cast<const T *>(_base + h.elements_offset);
+            _slots = h.slots > 0 ? reinterpret_cast<const slot *>(_base + h.slots_offset) : nullptr;
+            return;
+        }
+
+        throw std::runtime_error("Shared memory can't be opened!");
+    }
+
+    /**
+     * @brief rimuove la mappatura della versione
+     */
+    void detach()
+    {
+        if (_base != nullptr)
+        {
+            munmap(const_cast<unsigned char *>(_base), _bytes);
+            _base = nullptr;
+            _header = nullptr;
+            _elements = nullptr;
+            _slots = nullptr;
+        }
+    }
+}; // shared_set
+
+/**
+ * @brief funzione globale per stampare uno shared_set su stream
+ *
+ * Stampa uno shared_set su stream nello stesso formato di set:
+ * - {e1, e2, ..., en}
+ *
+ * @param os stream di output su cui stampare
+ * @param s insieme da stampare
+ */
+template <typename T, typename Eql, typename Hash>
+std::ostream &operator<<(std::ostream &os, const shared_set<T, Eql, Hash> &s)
+{
+    typename shared_set<T, Eql, Hash>::const_iterator i, ie;
+
+    i = s.begin();
+    ie = s.end();
+
+    os << "{";
+
+    while (i != ie)
+    {
+        os << *i;
+        i++;
+
+        if (i != ie)
+        {
+            os << ", ";
+        }
+    }
+
+    os << "}";
+
+    return os;
+}
+
+/**
+ * @brief funzione per filtrare uno shared_set
+ *
+ * Crea un set locale che contiene solo gli elementi che rispettano pred,
+ * leggendo gli elementi direttamente dalla memoria condivisa: viene copiato solo il risultato.
+ * Gli elementi scelti vengono raccolti prima di essere aggiunti, così il set viene allocato una sola volta.
+ *
+ * @param S insieme da filtrare
+ * @param pred predicato booleano che prende in input un oggetto di tipo T
+ *
+ * @return un set contenente tutti e soli gli elementi di S che rispettano pred
+ *
+ * @throws std::bad_alloc se l'allocazione del set fallisce
+ */
+template <typename T, typename Eql, typename Hash, typename P>
+set<T, Eql, Hash> filter_out(const shared_set<T, Eql, Hash> &S, P pred)
+{
+    std::vector<T> selected;
+
+    typename shared_set<T, Eql, Hash>::const_iterator i, ie;
+    i = S.begin();
+    ie = S.end();
+
+    while (i != ie)
+    {
+        if (pred(*i))
+        {
+            selected.push_back(*i);
+        }
+
+        i++;
+    }
+
+    set<T, Eql, Hash> result;
+    result.reserve(static_cast<unsigned int>(selected.size()));
+    for (const T &element : selected)
+    {
+        result.add(element);
+    }
+
+    return result;
+}
+
+#endif
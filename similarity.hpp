@@ -0,0 +1,355 @@
+/**
+ * @file similarity.hpp
+ *
+ * @brief file di dichiarazione e definizione delle misure di somiglianza tra set
+ *
+ * File di dichiarazione e definizione delle funzioni che misurano la sovrapposizione tra due set
+ * senza costruire l'intersezione:
+ * - cardinalità di intersezione e unione
+ * - inclusione e disgiunzione
+ * - indice di Jaccard
+ * Contiene anche la classe templata minhash, una firma di dimensione costante
+ * che stima l'indice di Jaccard tra due set.
+ */
+#ifndef SIMILARITY_HPP
+#define SIMILARITY_HPP
+
+#include <cstdint>   // std::uint32_t, std::uint64_t
+#include <algorithm> // std::fill
+#include "hashing.hpp"
+#include "hash_index.hpp"
+#include "set.hpp"
+
+namespace similarity_detail
+{
+    static const unsigned int LINEAR_PROBES = 8; ///< sotto questa dimensione non conviene costruire un indice
+
+    /**
+     * @brief cerca gli elementi di un set in un altro
+     *
+     * Per ogni elemento di source, nell'ordine, chiama visit(true) se è presente in target e visit(false) altrimenti,
+     * fermandosi appena visit ritorna false.
+     * Se target ha già un indice hash o la cache degli hash, viene usato contains, che li sfrutta.
+     * Altrimenti, se è disponibile un funtore di hash e source non è piccolo, viene costruito un hash_index temporaneo
+     * su target e ogni ricerca costa O(1); negli altri casi contains sfrutta il filtro di Bloom di target se presente.
+     *
+     * @param source set di cui cercare gli elementi
+     * @param target set in cui cercare
+     * @param visit funzione chiamata con l'esito di ogni ricerca
+     *
+     * @throws std::bad_alloc se l'allocazione dell'indice fallisce
+     */
+    template <typename T, typename Eql, typename Hash, typename F>
+    void probe(const set<T, Eql, Hash> &source, const set<T, Eql, Hash> &target, F visit)
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            if (source.size() > LINEAR_PROBES && !target.has_index() && !target.has_hash_cache())
+            {
+                hash_index<T, Eql, Hash> index(target.size());
+                for (unsigned int i = 0; i < target.size(); ++i)
+                {
+                    index.insert(i, index.hash_of(target[i]));
+                }
+
+                auto get = [&target](unsigned int j) -> const T & { return target[j]; };
+                for (unsigned int i = 0; i < source.size(); ++i)
+                {
+                    if (!visit(index.find(source[i], index.hash_of(source[i]), get) != index.NOT_FOUND))
+                    {
+                        return;
+                    }
+                }
+                return;
+            }
+        }
+
+        for (unsigned int i = 0; i < source.size(); ++i)
+        {
+            if (!visit(target.contains(source[i])))
+            {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief cardinalità dell'intersezione tra due set
+ *
+ * Conta gli elementi comuni scorrendo il set più piccolo e cercando i suoi elementi nell'altro,
+ * senza allocare l'intersezione.
+ * Con un funtore di hash il costo è O(N + M), altrimenti O(N·M) come operator-.
+ *
+ * @param a primo set
+ * @param b secondo set
+ *
+ * @return numero di elementi presenti in entrambi i set
+ *
+ * @throws std::bad_alloc se l'allocazione dell'indice temporaneo fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+unsigned int intersection_size(const set<T, Eql, Hash> &a, const set<T, Eql, Hash> &b)
+{
+    const set<T, Eql, Hash> &small = a.size() <= b.size() ? a : b;
+    const set<T, Eql, Hash> &large = a.size() <= b.size() ? b : a;
+
+    unsigned int count = 0;
+    similarity_detail::probe(small, large, [&count](bool found) {
+        count += found ? 1 : 0;
+        return true;
+    });
+
+    return count;
+}
+
+/**
+ * @brief cardinalità dell'unione tra due set
+ *
+ * Calcolata come |a| + |b| - |a ∩ b|, senza allocare l'unione.
+ *
+ * @param a primo set
+ * @param b secondo set
+ *
+ * @return numero di elementi presenti in almeno uno dei due set
+ *
+ * @throws std::bad_alloc se l'allocazione dell'indice temporaneo fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+unsigned long long union_size(const set<T, Eql, Hash> &a, const set<T, Eql, Hash> &b)
+{
+    return static_cast<unsigned long long>(a.size()) + b.size() - intersection_size(a, b);
+}
+
+/**
+ * @brief verifica se un set è contenuto in un altro
+ *
+ * Si ferma al primo elemento di a non presente in b.
+ * Se a ha più elementi di b il risultato è immediato.
+ *
+ * @param a set di cui verificare l'inclusione
+ * @param b set che dovrebbe contenere a
+ *
+ * @return true se ogni elemento di a è presente in b, false altrimenti
+ *
+ * @throws std::bad_alloc se l'allocazione dell'indice temporaneo fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+bool is_subset(const set<T, Eql, Hash> &a, const set<T, Eql, Hash> &b)
+{
+    if (a.size() > b.size())
+    {
+        return false;
+    }
+
+    bool subset = true;
+    similarity_detail::probe(a, b, [&subset](bool found) {
+        subset = found;
+        return found;
+    });
+
+    return subset;
+}
+
+/**
+ * @brief verifica se due set non hanno elementi in comune
+ *
+ * Scorre il set più piccolo e si ferma al primo elemento presente nell'altro.
+ *
+ * @param a primo set
+ * @param b secondo set
+ *
+ * @return true se l'intersezione è vuota, false altrimenti
+ *
+ * @throws std::bad_alloc se l'allocazione dell'indice temporaneo fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+bool is_disjoint(const set<T, Eql, Hash> &a, const set<T, Eql, Hash> &b)
+{
+    const set<T, Eql, Hash> &small = a.size() <= b.size() ? a : b;
+    const set<T, Eql, Hash> &large = a.size() <= b.size() ? b : a;
+
+    bool disjoint = true;
+    similarity_detail::probe(small, large, [&disjoint](bool found) {
+        disjoint = !found;
+        return !found;
+    });
+
+    return disjoint;
+}
+
+/**
+ * @brief indice di Jaccard tra due set
+ *
+ * Calcola |a ∩ b| / |a ∪ b| con una sola passata sul set più piccolo.
+ *
+ * @param a primo set
+ * @param b secondo set
+ *
+ * @return valore in [0, 1]; 1 se i due set sono uguali, compreso il caso in cui sono entrambi vuoti
+ *
+ * @throws std::bad_alloc se l'allocazione dell'indice temporaneo fallisce
+ */
+template <typename T, typename Eql, typename Hash>
+double jaccard(const set<T, Eql, Hash> &a, const set<T, Eql, Hash> &b)
+{
+    const unsigned int common = intersection_size(a, b);
+    const unsigned long long all = static_cast<unsigned long long>(a.size()) + b.size() - common;
+
+    if (all == 0)
+    {
+        return 1.0;
+    }
+
+    return static_cast<double>(common) / static_cast<double>(all);
+}
+
+/**
+ * @brief classe minhash che rappresenta una firma MinHash di un set
+ *
+ * La firma contiene, per K funzioni di hash indipendenti, il minimo valore assunto sugli elementi del set.
+ * La probabilità che due set abbiano lo stesso minimo per una funzione è pari al loro indice di Jaccard,
+ * quindi la frazione di minimi uguali ne è una stima con errore standard di circa 1/sqrt(K).
+ * La firma si calcola una volta per set in O(N·K) e il confronto costa O(K), indipendentemente dalla dimensione dei set:
+ * è adatta a confrontare tra loro migliaia di set.
+ *
+ * È templata su tre parametri:
+ * - T: tipo degli elementi
+ * - Hash: funtore di hash, lo stesso usato dai set confrontati
+ * - K: numero di funzioni di hash, cioè di valori nella firma
+ *
+ * Le K funzioni si ottengono rimescolando l'hash dell'elemento con K semi diversi.
+ * La firma non alloca memoria e può essere copiata liberamente.
+ */
+template <typename T, typename Hash, unsigned int K = 128>
+class minhash
+{
+    static_assert(K > 0, "minhash needs at least one hash function");
+
+private:
+    std::uint64_t _mins[K]; ///< minimo di ciascuna funzione di hash
+    bool _empty;            ///< true se la firma è di un set vuoto
+
+    Hash _hash; ///< istanza del funtore di hash
+
+public:
+    /**
+     * @brief costruttore di default
+     *
+     * Crea la firma di un set vuoto.
+     *
+     * @post _empty == true
+     */
+    minhash() : _empty(true)
+    {
+        std::fill(_mins, _mins + K, ~std::uint64_t(0));
+    }
+
+    /**
+     * @brief costruttore a partire da un set
+     *
+     * Calcola la firma degli elementi di s.
+     *
+     * @param s set di cui calcolare la firma
+     */
+    template <typename Eql>
+    explicit minhash(const set<T, Eql, Hash> &s) : minhash()
+    {
+        for (unsigned int i = 0; i < s.size(); ++i)
+        {
+            add(s[i]);
+        }
+    }
+
+    /**
+     * @brief aggiorna la firma con un elemento
+     *
+     * Permette di calcolare la firma in modo incrementale, ad esempio durante la lettura di un file.
+     *
+     * @param element elemento da aggiungere
+     */
+    void add(const T &element)
+    {
+        const std::uint64_t h = hash_mix(static_cast<std::uint64_t>(_hash(element)));
+        for (unsigned int k = 0; k < K; ++k)
+        {
+            const std::uint64_t v = hash_mix(h ^ seed(k));
+            if (v < _mins[k])
+            {
+                _mins[k] = v;
+            }
+        }
+        _empty = false;
+    }
+
+    /**
+     * @brief stima dell'indice di Jaccard
+     *
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param other firma da confrontare
+     *
+     * @return frazione di minimi uguali tra le due firme; 1 se entrambe sono di set vuoti, 0 se lo è una sola
+     */
+    double similarity(const minhash &other) const
+    {
+        if (_empty || other._empty)
+        {
+            return _empty && other._empty ? 1.0 : 0.0;
+        }
+
+        unsigned int equal = 0;
+        for (unsigned int k = 0; k < K; ++k)
+        {
+            equal += _mins[k] == other._mins[k] ? 1 : 0;
+        }
+
+        return static_cast<double>(equal) / K;
+    }
+
+    /**
+     * @brief unione di due firme
+     *
+     * La firma dell'unione di due set è il minimo componente per componente delle loro firme.
+     *
+     * @param other firma da unire a questa
+     */
+    void merge(const minhash &other)
+    {
+        for (unsigned int k = 0; k < K; ++k)
+        {
+            if (other._mins[k] < _mins[k])
+            {
+                _mins[k] = other._mins[k];
+            }
+        }
+        _empty = _empty && other._empty;
+    }
+
+    /**
+     * @brief operatore di uguaglianza
+     *
+     * @param other firma da confrontare
+     *
+     * @return true se le due firme sono identiche
+     */
+    bool operator==(const minhash &other) const
+    {
+        return _empty == other._empty && std::equal(_mins, _mins + K, other._mins);
+    }
+
+private:
+    /**
+     * @brief seme della k-esima funzione di hash
+     *
+     * @param k indice della funzione
+     *
+     * @return seme della funzione
+     */
+    static std::uint64_t seed(unsigned int k)
+    {
+        return hash_mix(0x9e3779b97f4a7c15ULL * (k + 1));
+    }
+}; // minhash
+
+#endif
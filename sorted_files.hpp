@@ -0,0 +1,401 @@
+/**
+ * @file sorted_files.hpp
+ *
+ * @brief file di dichiarazione e definizione delle funzioni su file di set ordinati
+ *
+ * File di dichiarazione e definizione delle funzioni che confrontano e uniscono file nel formato di save
+ * leggendoli in streaming, con memoria limitata:
+ * - is_sorted_file, che verifica se un file è già ordinato
+ * - sort_file, che ordina un file con un ordinamento esterno
+ * - diff_files, che scrive gli elementi aggiunti e rimossi tra due file
+ * - merge_files, che scrive l'unione di più file
+ */
+#ifndef SORTED_FILES_HPP
+#define SORTED_FILES_HPP
+
+#include <algorithm>  // std::find, std::sort, std::unique
+#include <atomic>     // std::atomic
+#include <cstddef>    // std::size_t
+#include <cstdio>     // std::remove
+#include <filesystem> // std::filesystem::path
+#include <functional> // std::less
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string, std::to_string
+#include <utility>    // std::move
+#include <vector>     // std::vector
+#include <unistd.h>   // getpid
+#include "footprint.hpp"
+#include "set_reader.hpp"
+#include "sorted_run.hpp"
+
+/**
+ * @brief verifica se un file è ordinato
+ *
+ * Legge in streaming un file nel formato di save.
+ *
+ * @param filename file da verificare
+ *
+ * @return true se gli elementi sono in ordine strettamente crescente secondo Less, quindi anche senza duplicati
+ *
+ * @throw std::runtime_error se il file non esiste o è troncato
+ */
+template <typename T, typename Less = std::less<T>>
+bool is_sorted_file(const std::string &filename)
+{
+    const Less less;
+    set_reader<T> reader(filename);
+
+    auto it = reader.begin();
+    if (it == reader.end())
+    {
+        return true;
+    }
+
+    T previous = *it;
+    for (++it; it != reader.end(); ++it)
+    {
+        if (!less(previous, *it))
+        {
+            return false;
+        }
+        previous = *it;
+    }
+
+    return true;
+}
+
+namespace sorted_files_detail
+{
+    static const unsigned int FANOUT = 16; ///< file letti contemporaneamente da ogni fusione
+
+    inline std::atomic<unsigned long long> temp_counter{0}; ///< numero del prossimo file temporaneo del processo
+
+    /**
+     * @brief file temporanei
+     *
+     * Raccoglie i nomi dei file temporanei e li cancella alla distruzione, anche in caso di errore.
+     */
+    class temp_files
+    {
+    private:
+        std::string _directory;          ///< directory dei file
+        std::vector<std::string> _paths; ///< file creati
+
+    public:
+        /**
+         * @brief costruttore
+         *
+         * @param directory directory in cui creare i file
+         */
+        explicit temp_files(const std::string &directory) : _directory(directory) {}
+
+        temp_files(const temp_files &other) = delete;
+        temp_files &operator=(const temp_files &other) = delete;
+
+        /**
+         * @brief metodo distruttore
+         *
+         * Cancella i file ancora presenti.
+         */
+        ~temp_files()
+        {
+            for (const std::string &path : _paths)
+            {
+                std::remove(path.c_str());
+            }
+        }
+
+        /**
+         * @brief nome di un nuovo file temporaneo
+         *
+         * @return un nome unico nel sistema, registrato per la cancellazione
+         */
+        std::string create()
+        {
+            const std::string name = "sorted_" + std::to_string(getpid()) + "_" + std::to_string(temp_counter.fetch_add(1)) + ".tmp";
+            _paths.push_back((std::filesystem::path(_directory) / name).string());
+            return _paths.back();
+        }
+
+        /**
+         * @brief cancella subito un file non più necessario
+         *
+         * I file che non sono stati creati da create, come quelli del chiamante, non vengono toccati.
+         *
+         * @param path file da cancellare
+         */
+        void release(const std::string &path)
+        {
+            if (std::find(_paths.begin(), _paths.end(), path) != _paths.end())
+            {
+                std::remove(path.c_str());
+            }
+        }
+    };
+
+    /**
+     * @brief fonde file ordinati in uno solo
+     *
+     * Se i file sono più di FANOUT li fonde a gruppi in file temporanei, fino a ridurli a FANOUT.
+     *
+     * @param paths file ordinati da fondere
+     * @param output file da scrivere
+     * @param temps file temporanei
+     *
+     * @return numero di elementi scritti
+     *
+     * @throw std::runtime_error se un file non può essere letto o scritto
+     */
+    template <typename T, typename Less>
+    unsigned int merge_sorted(std::vector<std::string> paths, const std::string &output, temp_files &temps)
+    {
+        while (paths.size() > FANOUT)
+        {
+            std::vector<std::string> next;
+            for (std::size_t first = 0; first < paths.size(); first += FANOUT)
+            {
+                const std::size_t last = first + FANOUT < paths.size() ? first + FANOUT : paths.size();
+                const std::vector<std::string> group(paths.begin() + first, paths.begin() + last);
+
+                next.push_back(temps.create());
+                merge_sorted<T, Less>(group, next.back(), temps);
+                for (const std::string &path : group)
+                {
+                    temps.release(path);
+                }
+            }
+            paths.swap(next);
+        }
+
+        std::vector<sorted_run_detail::file_cursor<T>> cursors;
+        for (const std::string &path : paths)
+        {
+            cursors.emplace_back(path);
+        }
+
+        sorted_run_detail::sorted_merge<T, Less> merge(std::move(cursors));
+        sorted_run_detail::sorted_writer<T> writer(output);
+        for (; merge.valid(); merge.advance())
+        {
+            writer.push(merge.current());
+        }
+
+        return writer.finish();
+    }
+
+    /**
+     * @brief ordina un file in file temporanei
+     *
+     * Legge il file a blocchi che occupano al più budget byte, stimati come sizeof(T) più heap_bytes,
+     * e scrive ogni blocco ordinato e senza duplicati in un file temporaneo.
+     *
+     * @param input file da ordinare
+     * @param budget byte di memoria per blocco
+     * @param temps file temporanei
+     *
+     * @return i file temporanei ordinati
+     *
+     * @throw std::runtime_error se un file non può essere letto o scritto
+     * @throws std::bad_alloc se l'allocazione di un blocco fallisce
+     */
+    template <typename T, typename Less>
+    std::vector<std::string> sort_runs(const std::string &input, std::size_t budget, temp_files &temps)
+    {
+        const Less less;
+        auto equivalent = [&less](const T &a, const T &b) { return !less(a, b) && !less(b, a); };
+
+        std::vector<std::string> runs;
+        std::vector<T> block;
+        block.reserve(budget / sizeof(T) + 1);
+
+        set_reader<T> reader(input);
+        auto it = reader.begin();
+        while (it != reader.end())
+        {
+            block.clear();
+            std::size_t bytes = 0;
+            for (; it != reader.end() && bytes < budget; ++it)
+            {
+                block.push_back(*it);
+                bytes += sizeof(T) + heap_bytes<T>()(*it);
+            }
+
+            std::sort(block.begin(), block.end(), less);
+            block.erase(std::unique(block.begin(), block.end(), equivalent), block.end());
+
+            runs.push_back(temps.create());
+            sorted_run_detail::sorted_writer<T> writer(runs.back());
+            for (const T &element : block)
+            {
+                writer.push(element);
+            }
+            writer.finish();
+        }
+
+        return runs;
+    }
+
+    /**
+     * @brief versione ordinata di un file
+     *
+     * @param input file da ordinare
+     * @param budget byte di memoria per l'ordinamento
+     * @param temps file temporanei
+     *
+     * @return input se è già ordinato senza duplicati, altrimenti un file temporaneo ordinato
+     *
+     * @throw std::runtime_error se un file non può essere letto o scritto
+     */
+    template <typename T, typename Less>
+    std::string prepare(const std::string &input, std::size_t budget, temp_files &temps)
+    {
+        if (is_sorted_file<T, Less>(input))
+        {
+            return input;
+        }
+
+        const std::string sorted = temps.create();
+        merge_sorted<T, Less>(sort_runs<T, Less>(input, budget, temps), sorted, temps);
+        return sorted;
+    }
+}
+
+/**
+ * @brief ordina un file con un ordinamento esterno
+ *
+ * Scrive in output gli elementi di input in ordine crescente e senza duplicati, nel formato di save.
+ * Il file viene letto a blocchi di al più budget byte, ordinati in memoria e scritti in file temporanei
+ * in temp_directory, che vengono poi fusi a gruppi di sorted_files_detail::FANOUT.
+ * La memoria usata è quindi limitata da budget indipendentemente dalla dimensione del file.
+ * I file temporanei vengono cancellati anche in caso di errore.
+ *
+ * @param input file da ordinare, nel formato di save
+ * @param output file da scrivere, diverso da input
+ * @param budget byte di memoria per blocco, stimati come sizeof(T) più la memoria posseduta secondo heap_bytes
+ * @param temp_directory directory esistente per i file temporanei
+ *
+ * @return numero di elementi scritti
+ *
+ * @throw std::runtime_error se un file non può essere letto o scritto
+ * @throws std::bad_alloc se l'allocazione di un blocco fallisce
+ */
+template <typename T, typename Less = std::less<T>>
+unsigned int sort_file(const std::string &input, const std::string &output, std::size_t budget = 1 << 24,
+                       const std::string &temp_directory = ".")
+{
+    sorted_files_detail::temp_files temps(temp_directory);
+    return sorted_files_detail::merge_sorted<T, Less>(sorted_files_detail::sort_runs<T, Less>(input, budget, temps), output, temps);
+}
+
+/**
+ * @brief risultato di diff_files
+ */
+struct file_diff
+{
+    unsigned int added = 0;   ///< elementi presenti solo nel secondo file
+    unsigned int removed = 0; ///< elementi presenti solo nel primo file
+};
+
+/**
+ * @brief differenza tra due file di set
+ *
+ * Confronta due file nel formato di save, ad esempio la versione di ieri e quella di oggi dello stesso set,
+ * e scrive in added gli elementi presenti solo in after e in removed quelli presenti solo in before,
+ * entrambi in ordine crescente nel formato di save.
+ * I file già ordinati senza duplicati, come quelli scritti da queste funzioni, vengono letti direttamente;
+ * gli altri vengono prima ordinati con sort_file. Il confronto è una sola scansione in parallelo dei due file:
+ * il costo è O(N + M) letture, più l'eventuale ordinamento, e la memoria è limitata da budget.
+ *
+ * @param before primo file
+ * @param after secondo file
+ * @param added file in cui scrivere gli elementi aggiunti
+ * @param removed file in cui scrivere gli elementi rimossi
+ * @param budget byte di memoria per l'ordinamento, vedi sort_file
+ * @param temp_directory directory esistente per i file temporanei
+ *
+ * @return numero di elementi aggiunti e rimossi
+ *
+ * @throw std::runtime_error se un file non può essere letto o scritto
+ * @throws std::bad_alloc se l'allocazione di un blocco di ordinamento fallisce
+ */
+template <typename T, typename Less = std::less<T>>
+file_diff diff_files(const std::string &before, const std::string &after, const std::string &added,
+                     const std::string &removed, std::size_t budget = 1 << 24, const std::string &temp_directory = ".")
+{
+    const Less less;
+    sorted_files_detail::temp_files temps(temp_directory);
+
+    set_reader<T> old_reader(sorted_files_detail::prepare<T, Less>(before, budget, temps));
+    set_reader<T> new_reader(sorted_files_detail::prepare<T, Less>(after, budget, temps));
+    sorted_run_detail::sorted_writer<T> added_writer(added);
+    sorted_run_detail::sorted_writer<T> removed_writer(removed);
+
+    auto old_it = old_reader.begin();
+    auto new_it = new_reader.begin();
+    while (old_it != old_reader.end() && new_it != new_reader.end())
+    {
+        if (less(*old_it, *new_it))
+        {
+            removed_writer.push(*old_it);
+            ++old_it;
+        }
+        else if (less(*new_it, *old_it))
+        {
+            added_writer.push(*new_it);
+            ++new_it;
+        }
+        else
+        {
+            ++old_it;
+            ++new_it;
+        }
+    }
+    for (; old_it != old_reader.end(); ++old_it)
+    {
+        removed_writer.push(*old_it);
+    }
+    for (; new_it != new_reader.end(); ++new_it)
+    {
+        added_writer.push(*new_it);
+    }
+
+    file_diff result;
+    result.added = added_writer.finish();
+    result.removed = removed_writer.finish();
+    return result;
+}
+
+/**
+ * @brief unione di più file di set
+ *
+ * Scrive in output l'unione degli elementi dei file in input, in ordine crescente e senza duplicati,
+ * nel formato di save. I file non ordinati vengono prima ordinati con sort_file;
+ * la fusione legge al più sorted_files_detail::FANOUT file alla volta, quindi la memoria è limitata da budget
+ * qualunque sia il numero di file.
+ *
+ * @param inputs file da unire
+ * @param output file da scrivere, diverso da tutti gli input
+ * @param budget byte di memoria per l'ordinamento, vedi sort_file
+ * @param temp_directory directory esistente per i file temporanei
+ *
+ * @return numero di elementi scritti
+ *
+ * @throw std::runtime_error se un file non può essere letto o scritto
+ * @throws std::bad_alloc se l'allocazione di un blocco di ordinamento fallisce
+ */
+template <typename T, typename Less = std::less<T>>
+unsigned int merge_files(const std::vector<std::string> &inputs, const std::string &output, std::size_t budget = 1 << 24,
+                         const std::string &temp_directory = ".")
+{
+    sorted_files_detail::temp_files temps(temp_directory);
+
+    std::vector<std::string> sorted;
+    for (const std::string &input : inputs)
+    {
+        sorted.push_back(sorted_files_detail::prepare<T, Less>(input, budget, temps));
+    }
+
+    return sorted_files_detail::merge_sorted<T, Less>(sorted, output, temps);
+}
+
+#endif
@@ -0,0 +1,274 @@
+/**
+ * @file sorted_run.hpp
+ *
+ * @brief file di dichiarazione e definizione degli strumenti per i file ordinati
+ *
+ * File di dichiarazione e definizione delle classi con cui sorted_files.hpp ed external_set.hpp
+ * scrivono e fondono file nel formato di save con gli elementi in ordine crescente e senza duplicati:
+ * - sorted_writer, che scrive un file di cui la lunghezza non è nota all'inizio
+ * - file_cursor, che legge in streaming un file ordinato
+ * - sorted_merge, la fusione a k vie di sorgenti ordinate
+ */
+#ifndef SORTED_RUN_HPP
+#define SORTED_RUN_HPP
+
+#include <algorithm>  // std::make_heap, std::push_heap, std::pop_heap
+#include <fstream>    // ofstream
+#include <functional> // std::less
+#include <iomanip>    // std::setw
+#include <memory>     // std::unique_ptr
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <vector>     // std::vector
+#include "set_reader.hpp"
+
+namespace sorted_run_detail
+{
+    static const unsigned int HEADER_WIDTH = 10; ///< caratteri della lunghezza nella prima riga dei file scritti
+
+    /**
+     * @brief scrittura di un file nel formato di save
+     *
+     * Scrive la lunghezza, non nota all'inizio, allineata a destra nella prima riga,
+     * che viene riempita da finish: il file resta leggibile da load e set_reader.
+     */
+    template <typename T>
+    class sorted_writer
+    {
+    private:
+        std::ofstream _ofs;  ///< stream del file
+        unsigned int _count; ///< elementi scritti
+
+    public:
+        /**
+         * @brief costruttore
+         *
+         * Crea il file e scrive una prima riga vuota.
+         *
+         * @param path file da scrivere
+         *
+         * @throw std::runtime_error se il file non viene aperto
+         */
+        explicit sorted_writer(const std::string &path) : _ofs(path), _count(0)
+        {
+            if (!_ofs.is_open())
+            {
+                throw std::runtime_error("File can't be opened!");
+            }
+            _ofs << std::setw(HEADER_WIDTH) << "" << '\n';
+        }
+
+        /**
+         * @brief posizione nel file del prossimo elemento
+         *
+         * @return la posizione da cui verrà scritto il prossimo elemento
+         */
+        std::streamoff position()
+        {
+            return static_cast<std::streamoff>(_ofs.tellp());
+        }
+
+        /**
+         * @brief scrive un elemento
+         *
+         * @param element elemento da scrivere, maggiore di tutti quelli già scritti
+         */
+        void push(const T &element)
+        {
+            _ofs << element << '\n';
+            ++_count;
+        }
+
+        /**
+         * @brief completa il file
+         *
+         * Scrive la lunghezza nella prima riga e chiude il file.
+         *
+         * @return numero di elementi scritti
+         *
+         * @throw std::runtime_error se il file non viene scritto
+         */
+        unsigned int finish()
+        {
+            _ofs.seekp(0);
+            _ofs << std::setw(HEADER_WIDTH) << _count;
+            _ofs.close();
+            if (!_ofs)
+            {
+                throw std::runtime_error("File can't be written!");
+            }
+
+            return _count;
+        }
+    };
+
+    /**
+     * @brief lettura sequenziale di un file ordinato
+     *
+     * Sorgente per sorted_merge che legge un file con set_reader.
+     */
+    template <typename T>
+    class file_cursor
+    {
+    private:
+        std::unique_ptr<set_reader<T>> _reader;     ///< lettore del file
+        typename set_reader<T>::const_iterator _it; ///< posizione nel file
+
+    public:
+        /**
+         * @brief costruttore
+         *
+         * Apre il file e si posiziona sul primo elemento.
+         *
+         * @param path file da leggere
+         *
+         * @throw std::runtime_error se il file non può essere letto
+         */
+        explicit file_cursor(const std::string &path) : _reader(new set_reader<T>(path))
+        {
+            _it = _reader->begin();
+        }
+
+        /**
+         * @brief verifica se ci sono altri elementi
+         *
+         * @return true se current() è valido
+         */
+        bool valid() const
+        {
+            return _it != _reader->end();
+        }
+
+        /**
+         * @brief elemento corrente
+         *
+         * @pre valid() == true
+         *
+         * @return l'elemento corrente
+         */
+        const T &current() const
+        {
+            return *_it;
+        }
+
+        /**
+         * @brief passa all'elemento successivo
+         *
+         * @throw std::runtime_error se il file è troncato
+         */
+        void next()
+        {
+            ++_it;
+        }
+    };
+
+    /**
+     * @brief fusione a k vie di sorgenti ordinate
+     *
+     * Mantiene uno heap delle sorgenti ordinato per elemento corrente
+     * e restituisce gli elementi in ordine crescente, una sola volta anche se presenti in più sorgenti.
+     * Source deve avere i metodi valid, current e next come file_cursor.
+     */
+    template <typename T, typename Less = std::less<T>, typename Source = file_cursor<T>>
+    class sorted_merge
+    {
+    private:
+        std::vector<Source> _sources;    ///< sorgenti
+        std::vector<unsigned int> _heap; ///< indici delle sorgenti non esaurite, con la minore in testa
+        T _current;                      ///< elemento corrente
+        bool _valid;                     ///< true se _current è valido
+        Less _less;                      ///< istanza del funtore di ordinamento
+
+    public:
+        /**
+         * @brief costruttore
+         *
+         * Si posiziona sul primo elemento.
+         *
+         * @param sources sorgenti ordinate da fondere
+         *
+         * @throw std::runtime_error se una sorgente è troncata
+         */
+        explicit sorted_merge(std::vector<Source> &&sources) : _sources(std::move(sources)), _current(), _valid(false)
+        {
+            for (unsigned int i = 0; i < _sources.size(); ++i)
+            {
+                if (_sources[i].valid())
+                {
+                    _heap.push_back(i);
+                }
+            }
+            std::make_heap(_heap.begin(), _heap.end(), later());
+
+            advance();
+        }
+
+        /**
+         * @brief verifica se ci sono altri elementi
+         *
+         * @return true se current() è valido
+         */
+        bool valid() const
+        {
+            return _valid;
+        }
+
+        /**
+         * @brief elemento corrente
+         *
+         * @pre valid() == true
+         *
+         * @return il minore tra gli elementi non ancora restituiti
+         */
+        const T &current() const
+        {
+            return _current;
+        }
+
+        /**
+         * @brief passa all'elemento successivo
+         *
+         * Prende il minore degli elementi correnti delle sorgenti e fa avanzare tutte le sorgenti che lo contengono.
+         *
+         * @throw std::runtime_error se una sorgente è troncata
+         */
+        void advance()
+        {
+            if (_heap.empty())
+            {
+                _valid = false;
+                return;
+            }
+
+            _current = _sources[_heap.front()].current();
+            _valid = true;
+
+            while (!_heap.empty() && !_less(_current, _sources[_heap.front()].current()))
+            {
+                std::pop_heap(_heap.begin(), _heap.end(), later());
+                const unsigned int i = _heap.back();
+                _heap.pop_back();
+
+                _sources[i].next();
+                if (_sources[i].valid())
+                {
+                    _heap.push_back(i);
+                    std::push_heap(_heap.begin(), _heap.end(), later());
+                }
+            }
+        }
+
+    private:
+        /**
+         * @brief ordinamento dello heap
+         *
+         * @return una funzione che ritorna true se l'elemento corrente della sorgente a è maggiore di quello di b
+         */
+        auto later() const
+        {
+            return [this](unsigned int a, unsigned int b) { return _less(_sources[b].current(), _sources[a].current()); };
+        }
+    };
+}
+
+#endif
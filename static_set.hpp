@@ -0,0 +1,409 @@
+/**
+ * @file static_set.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe static_set
+ *
+ * File di dichiarazione e definizione della classe templata static_set,
+ * un insieme di dimensione fissa costruibile a tempo di compilazione.
+ * Contiene anche le funzioni globali per:
+ * - scrittura su stream
+ * - unione e intersezione con un set costruito a runtime
+ */
+#ifndef STATIC_SET_HPP
+#define STATIC_SET_HPP
+
+#include <initializer_list> // std::initializer_list
+#include <ostream>          // ostream
+#include <stdexcept>        // std::logic_error
+#include <cassert>          // assert
+#include "hashing.hpp"
+#include "set.hpp"
+
+/**
+ * @brief classe static_set che rappresenta un insieme costante
+ *
+ * La classe static_set rappresenta un insieme di N elementi senza duplicati, fissato alla creazione.
+ * È templata su quattro parametri:
+ * - T: tipo contenuto nel set. Deve essere un tipo letterale per poter costruire il set a tempo di compilazione
+ * - Eql: funtore di confronto. Il suo operatore () deve essere constexpr per poter costruire il set a tempo di compilazione
+ * - N: numero di elementi del set
+ * - Hash: funtore di hash opzionale, di default no_hash. Se indicato, il suo operatore () deve essere constexpr
+ *   per poter costruire il set a tempo di compilazione
+ *
+ * Gli elementi sono memorizzati in un array di dimensione N contenuto nell'oggetto stesso:
+ * non viene fatta alcuna allocazione dinamica e, se l'oggetto è dichiarato constexpr,
+ * non c'è alcun costo di inizializzazione all'avvio del programma.
+ * Senza funtore di hash la ricerca è lineare; essendo N noto a tempo di compilazione il ciclo viene
+ * srotolato dal compilatore nei casi in cui il set è piccolo.
+ * Con un funtore di hash, accanto agli elementi viene costruita (anche a tempo di compilazione)
+ * una tabella a indirizzamento aperto con almeno il doppio delle celle degli elementi, e la ricerca costa O(1).
+ */
+template <typename T, typename Eql, unsigned int N, typename Hash = no_hash>
+class static_set
+{
+private:
+    /**
+     * @brief numero di celle della tabella hash
+     *
+     * @return la più piccola potenza di 2 non minore di 2N, oppure 1 se Hash è no_hash
+     */
+    static constexpr unsigned int table_size()
+    {
+        unsigned int slots = 1;
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            while (slots < 2 * N)
+            {
+                slots *= 2;
+            }
+        }
+        return slots;
+    }
+
+    static constexpr unsigned int SLOTS = table_size(); ///< numero di celle della tabella hash
+    static constexpr unsigned int EMPTY = N;            ///< valore di una cella vuota della tabella hash
+
+    T _set[N]; ///< array di N oggetti di tipo T
+
+    Eql _eql; ///< istanza del funtore di confronto
+
+    unsigned int _slots[SLOTS]; ///< tabella hash con le posizioni degli elementi in _set, EMPTY se la cella è vuota
+
+    /**
+     * @brief prima cella della tabella hash in cui cercare un elemento
+     *
+     * @param element elemento di cui calcolare la cella
+     *
+     * @return posizione della cella in _slots
+     */
+    static constexpr unsigned int home(const T &element)
+    {
+        return static_cast<unsigned int>(hash_mix(static_cast<std::uint64_t>(Hash()(element))) & (SLOTS - 1));
+    }
+
+public:
+    typedef const T *const_iterator; ///< iteratore costante, è un puntatore all'array
+
+    typedef const_iterator iterator; ///< dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief costruttore da lista di inizializzazione
+     *
+     * Crea il set a partire dagli elementi della lista.
+     * A differenza di set, i duplicati non vengono ignorati ma sono considerati un errore:
+     * se il set è dichiarato constexpr l'errore viene segnalato a tempo di compilazione.
+     * Con un funtore di hash, la tabella viene riempita durante la costruzione e i duplicati
+     * vengono cercati solo tra gli elementi con la stessa sequenza di celle.
+     *
+     * @param list lista degli elementi del set
+     *
+     * @pre list.size() == N
+     * @pre la lista non contiene elementi equivalenti secondo Eql
+     *
+     * @post _set[i] == i-esimo elemento di list i=0,...,N-1
+     *
+     * @throws std::logic_error se la lista non contiene esattamente N elementi o contiene duplicati
+     */
+    constexpr static_set(std::initializer_list<T> list) : _set{}, _eql(), _slots{}
+    {
+        if (list.size() != N)
+        {
+            throw std::logic_error("Wrong number of elements!");
+        }
+
+        for (unsigned int s = 0; s < SLOTS; ++s)
+        {
+            _slots[s] = EMPTY;
+        }
+
+        unsigned int i = 0;
+        for (const T &element : list)
+        {
+            if constexpr (is_hash_enabled<Hash>::value)
+            {
+                unsigned int s = home(element);
+                while (_slots[s] != EMPTY)
+                {
+                    if (_eql(_set[_slots[s]], element))
+                    {
+                        throw std::logic_error("Duplicate element!");
+                    }
+                    s = (s + 1) & (SLOTS - 1);
+                }
+                _slots[s] = i;
+            }
+            else
+            {
+                for (unsigned int j = 0; j < i; ++j)
+                {
+                    if (_eql(_set[j], element))
+                    {
+                        throw std::logic_error("Duplicate element!");
+                    }
+                }
+            }
+
+            _set[i] = element;
+            ++i;
+        }
+    }
+
+    /**
+     * @brief metodo per la cardinalità del set
+     *
+     * Metodo per ottenere la cardinalità del set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return cardinalità del set
+     */
+    constexpr unsigned int size() const
+    {
+        return N;
+    }
+
+    /**
+     * @brief ricerca un elemento nel set
+     *
+     * Cerca se l'elemento è presente o meno nel set.
+     * Per confrontare gli elementi viene usato il funtore Eql.
+     * Con un funtore di hash vengono confrontati solo gli elementi nelle celle a partire da quella dell'hash,
+     * fino alla prima cella vuota; altrimenti la ricerca è lineare.
+     * Può essere valutato a tempo di compilazione.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param element elemento da cercare
+     *
+     * @return true se l'elemento è presente, false altrimenti
+     */
+    constexpr bool contains(const T &element) const
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            // la tabella ha almeno N celle vuote, quindi il ciclo termina
+            for (unsigned int s = home(element); _slots[s] != EMPTY; s = (s + 1) & (SLOTS - 1))
+            {
+                if (_eql(_set[_slots[s]], element))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        for (unsigned int i = 0; i < N; ++i)
+        {
+            if (_eql(_set[i], element))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief operatore di accesso diretto all'i-esimo elemento
+     *
+     * Ridefinizione dell'operatore di accesso diretto all'i-esimo elemento.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @param i indice dell'elemento da ottenere
+     *
+     * @pre i < N
+     *
+     * @return elemento in posizione i
+     */
+    constexpr const T &operator[](unsigned int i) const
+    {
+        assert(i < N);
+        return _set[i];
+    }
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * Ritorna l'iteratore di inizio sequenza del set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return l'iteratore di inizio sequenza del set
+     */
+    constexpr iterator begin() const
+    {
+        return _set;
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * Ritorna l'iteratore di fine sequenza del set.
+     * Questo metodo non altera lo stato della classe.
+     *
+     * @return l'iteratore di fine sequenza del set
+     */
+    constexpr iterator end() const
+    {
+        return _set + N;
+    }
+
+    /**
+     * @brief conversione a set
+     *
+     * Crea un set dinamico con gli stessi elementi.
+     * Il funtore di hash del set da creare può essere scelto con il parametro SetHash.
+     *
+     * @return un set contenente tutti e soli gli elementi di questo static_set
+     *
+     * @throws std::bad_alloc se lanciata dal costruttore da sequenza di iteratori di set
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     */
+    template <typename SetHash = no_hash>
+    set<T, Eql, SetHash> to_set() const
+    {
+        return set<T, Eql, SetHash>(begin(), end());
+    }
+
+    /**
+     * @brief operatore di conversione a set
+     *
+     * Permette di usare uno static_set dove è richiesto un set.
+     *
+     * @return un set contenente tutti e soli gli elementi di questo static_set
+     *
+     * @throws std::bad_alloc se lanciata da to_set
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia o assegnamento di T
+     */
+    template <typename SetHash>
+    operator set<T, Eql, SetHash>() const
+    {
+        return to_set<SetHash>();
+    }
+}; // static_set
+
+/**
+ * @brief funzione globale per stampare uno static_set su stream
+ *
+ * Stampa uno static_set su stream nello stesso formato di set:
+ * - {e1, e2, ..., en}
+ *
+ * @param os stream di output su cui stampare
+ * @param s static_set da stampare
+ */
+template <typename T, typename Eql, unsigned int N, typename StaticHash>
+std::ostream &operator<<(std::ostream &os, const static_set<T, Eql, N, StaticHash> &s)
+{
+    os << "{";
+
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        os << s[i];
+
+        if (i + 1 < N)
+        {
+            os << ", ";
+        }
+    }
+
+    os << "}";
+
+    return os;
+}
+
+/**
+ * @brief operatore di unione insiemistica tra set e static_set
+ *
+ * Crea un set che contiene l'unione dei due set.
+ *
+ * @param left set di sinistra
+ * @param right static_set di destra
+ *
+ * @return nuovo set contenente l'unione insiemistica dei due set
+ */
+template <typename T, typename Eql, typename Hash, unsigned int N, typename StaticHash>
+set<T, Eql, Hash> operator+(const set<T, Eql, Hash> &left, const static_set<T, Eql, N, StaticHash> &right)
+{
+    set<T, Eql, Hash> result = left;
+
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        result.add(right[i]);
+    }
+
+    return result;
+}
+
+/**
+ * @brief operatore di unione insiemistica tra static_set e set
+ *
+ * Crea un set che contiene l'unione dei due set.
+ *
+ * @param left static_set di sinistra
+ * @param right set di destra
+ *
+ * @return nuovo set contenente l'unione insiemistica dei due set
+ */
+template <typename T, typename Eql, typename Hash, unsigned int N, typename StaticHash>
+set<T, Eql, Hash> operator+(const static_set<T, Eql, N, StaticHash> &left, const set<T, Eql, Hash> &right)
+{
+    return left.template to_set<Hash>() + right;
+}
+
+/**
+ * @brief operatore di intersezione tra set e static_set
+ *
+ * Crea un set che contiene gli elementi di left presenti anche in right.
+ * La ricerca in right non richiede allocazioni.
+ *
+ * @param left set di sinistra
+ * @param right static_set di destra
+ *
+ * @return nuovo set contenente l'intersezione insiemistica dei due set
+ */
+template <typename T, typename Eql, typename Hash, unsigned int N, typename StaticHash>
+set<T, Eql, Hash> operator-(const set<T, Eql, Hash> &left, const static_set<T, Eql, N, StaticHash> &right)
+{
+    set<T, Eql, Hash> result;
+
+    typename set<T, Eql, Hash>::const_iterator i, ie;
+    i = left.begin();
+    ie = left.end();
+
+    while (i != ie)
+    {
+        if (right.contains(*i))
+        {
+            result.add(*i);
+        }
+
+        i++;
+    }
+
+    return result;
+}
+
+/**
+ * @brief operatore di intersezione tra static_set e set
+ *
+ * Crea un set che contiene gli elementi di left presenti anche in right.
+ *
+ * @param left static_set di sinistra
+ * @param right set di destra
+ *
+ * @return nuovo set contenente l'intersezione insiemistica dei due set
+ */
+template <typename T, typename Eql, typename Hash, unsigned int N, typename StaticHash>
+set<T, Eql, Hash> operator-(const static_set<T, Eql, N, StaticHash> &left, const set<T, Eql, Hash> &right)
+{
+    set<T, Eql, Hash> result;
+
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        if (right.contains(left[i]))
+        {
+            result.add(left[i]);
+        }
+    }
+
+    return result;
+}
+#endif
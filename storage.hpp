@@ -0,0 +1,314 @@
+/**
+ * @file storage.hpp
+ *
+ * @brief file di dichiarazione e definizione delle funzioni di gestione della memoria degli elementi
+ *
+ * File di dichiarazione e definizione delle funzioni che allocano, copiano, spostano e liberano
+ * gli array di elementi usati da set.
+ * Gli array sono memoria non inizializzata: solo le prime posizioni contengono oggetti costruiti,
+ * quindi le celle libere non vengono costruite di default come farebbe new T[n].
+ */
+#ifndef STORAGE_HPP
+#define STORAGE_HPP
+
+#include <cstddef>     // std::size_t, std::max_align_t
+#include <cstdlib>     // std::malloc, std::realloc, std::free
+#include <cstring>     // std::memcpy, std::memmove
+#include <memory>      // std::uninitialized_copy_n, std::uninitialized_move_n, std::destroy_n
+#include <new>         // std::bad_alloc, std::align_val_t
+#include <type_traits> // std::is_trivially_copyable, std::is_nothrow_move_constructible
+
+/**
+ * @brief verifica se un tipo può essere spostato in memoria copiandone i byte
+ *
+ * Vale true se T è banalmente copiabile e non richiede un allineamento maggiore di quello garantito da malloc:
+ * in questo caso gli array di T vengono gestiti con malloc, realloc, memcpy e memmove.
+ */
+template <typename T>
+struct is_trivially_relocatable
+{
+    static constexpr bool value = std::is_trivially_copyable<T>::value && alignof(T) <= alignof(std::max_align_t); ///< true se T può essere spostato con memcpy
+};
+
+namespace storage_detail
+{
+    /**
+     * @brief alloca un array non inizializzato
+     *
+     * @param n numero di elementi
+     *
+     * @return puntatore alla memoria allocata, nullptr se n == 0
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     */
+    template <typename T>
+    T *allocate(unsigned int n)
+    {
+        if (n == 0)
+        {
+            return nullptr;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            void *p = std::malloc(static_cast<std::size_t>(n) * sizeof(T));
+            if (p == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(p);
+        }
+        else
+        {
+            return static_cast<T *>(::operator new(static_cast<std::size_t>(n) * sizeof(T), std::align_val_t(alignof(T))));
+        }
+    }
+
+    /**
+     * @brief libera un array allocato con allocate
+     *
+     * Non distrugge gli elementi.
+     *
+     * @param p puntatore all'array, può essere nullptr
+     */
+    template <typename T>
+    void deallocate(T *p)
+    {
+        if (p == nullptr)
+        {
+            return;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            std::free(p);
+        }
+        else
+        {
+            ::operator delete(static_cast<void *>(p), std::align_val_t(alignof(T)));
+        }
+    }
+
+    /**
+     * @brief distrugge gli elementi e libera un array
+     *
+     * @param p puntatore all'array, può essere nullptr
+     * @param count numero di elementi costruiti all'inizio dell'array
+     */
+    template <typename T>
+    void release(T *p, unsigned int count)
+    {
+        if (p != nullptr)
+        {
+            std::destroy_n(p, count);
+        }
+        deallocate(p);
+    }
+
+    /**
+     * @brief crea una copia di un array
+     *
+     * Alloca un array di capacity elementi e vi costruisce le copie dei primi count elementi di source,
+     * con memcpy se T è banalmente spostabile.
+     * In caso di errore le copie già costruite vengono distrutte e la memoria liberata.
+     *
+     * @param source array da copiare
+     * @param count numero di elementi da copiare
+     * @param capacity dimensione del nuovo array
+     *
+     * @pre count <= capacity
+     *
+     * @return il nuovo array, nullptr se capacity == 0
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
+     */
+    template <typename T>
+    T *copy(const T *source, unsigned int count, unsigned int capacity)
+    {
+        T *data = allocate<T>(capacity);
+
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            if (count > 0)
+            {
+                std::memcpy(static_cast<void *>(data), source, static_cast<std::size_t>(count) * sizeof(T));
+            }
+        }
+        else
+        {
+            try
+            {
+                std::uninitialized_copy_n(source, count, data);
+            }
+            catch (...)
+            {
+                deallocate(data);
+                throw;
+            }
+        }
+
+        return data;
+    }
+
+    /**
+     * @brief verifica se un array può essere spostato senza copiare gli elementi
+     *
+     * Vale true se T è banalmente spostabile oppure ha un costruttore di spostamento che non lancia eccezioni.
+     */
+    template <typename T>
+    struct movable
+    {
+        static constexpr bool value = is_trivially_relocatable<T>::value || std::is_nothrow_move_constructible<T>::value; ///< true se relocate non copia gli elementi
+    };
+
+    /**
+     * @brief sposta un array posseduto esclusivamente in uno di dimensione diversa
+     *
+     * I primi count elementi di data vengono portati in un array di capacity elementi:
+     * - se T è banalmente spostabile con realloc, che spesso estende o riduce l'array senza spostarlo
+     * - se T ha un costruttore di spostamento noexcept, allocando un nuovo array e spostandovi gli elementi
+     * - altrimenti copiando gli elementi e distruggendo gli originali solo al termine
+     * In caso di errore data rimane valido e invariato.
+     *
+     * @param data array da spostare, allocato con allocate
+     * @param count numero di elementi costruiti all'inizio di data
+     * @param capacity dimensione del nuovo array
+     *
+     * @pre count <= capacity
+     * @pre data non è condiviso con altri set
+     *
+     * @return il nuovo array; data non va più usato
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T, se T non è spostabile senza eccezioni
+     */
+    template <typename T>
+    T *relocate(T *data, unsigned int count, unsigned int capacity)
+    {
+        if (capacity == 0)
+        {
+            release(data, count);
+            return nullptr;
+        }
+
+        if constexpr (is_trivially_relocatable<T>::value)
+        {
+            void *p = std::realloc(data, static_cast<std::size_t>(capacity) * sizeof(T));
+            if (p == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(p);
+        }
+        else if constexpr (std::is_nothrow_move_constructible<T>::value)
+        {
+            T *moved = allocate<T>(capacity);
+            if (data != nullptr)
+            {
+                std::uninitialized_move_n(data, count, moved);
+            }
+            release(data, count);
+            return moved;
+        }
+        else
+        {
+            T *copied = copy(data, count, capacity);
+            release(data, count);
+            return copied;
+        }
+    }
+
+    /**
+     * @brief crea una copia di un array senza un elemento
+     *
+     * Costruisce in dest le copie degli elementi di source tranne quello in posizione position.
+     * In caso di errore le copie già costruite vengono distrutte; dest non viene liberato.
+     *
+     * @param source array da copiare
+     * @param count numero di elementi di source
+     * @param position posizione dell'elemento da escludere
+     * @param dest array non inizializzato di almeno count - 1 elementi
+     *
+     * @pre position < count
+     *
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T
+     */
+    template <typename T>
+    void copy_without(const T *source, unsigned int count, unsigned int position, T *dest)
+    {
+        std::uninitialized_copy_n(source, position, dest);
+        try
+        {
+            std::uninitialized_copy_n(source + position + 1, count - position - 1, dest + position);
+        }
+        catch (...)
+        {
+            std::destroy_n(dest, position);
+            throw;
+        }
+    }
+
+    /**
+     * @brief sposta un array in un altro senza un elemento
+     *
+     * Costruisce in dest, spostandoli, gli elementi di source tranne quello in posizione position.
+     * Gli elementi di source restano costruiti e vanno distrutti dal chiamante.
+     *
+     * @param source array da spostare
+     * @param count numero di elementi di source
+     * @param position posizione dell'elemento da escludere
+     * @param dest array non inizializzato di almeno count - 1 elementi
+     *
+     * @pre position < count
+     * @pre movable<T>::value == true
+     */
+    template <typename T>
+    void move_without(T *source, unsigned int count, unsigned int position, T *dest) noexcept
+    {
+        static_assert(movable<T>::value, "move_without requires a nothrow move");
+
+        std::uninitialized_move_n(source, position, dest);
+        std::uninitialized_move_n(source + position + 1, count - position - 1, dest + position);
+    }
+
+    /**
+     * @brief toglie un elemento da un array banalmente spostabile
+     *
+     * Sposta con memmove di una posizione indietro gli elementi successivi a position.
+     *
+     * @param data array da modificare
+     * @param count numero di elementi di data
+     * @param position posizione dell'elemento da togliere
+     *
+     * @pre position < count
+     */
+    template <typename T>
+    void erase(T *data, unsigned int count, unsigned int position) noexcept
+    {
+        static_assert(is_trivially_relocatable<T>::value, "erase requires a trivially relocatable type");
+
+        std::memmove(static_cast<void *>(data + position), data + position + 1,
+                     static_cast<std::size_t>(count - position - 1) * sizeof(T));
+    }
+
+    /**
+     * @brief riduce la memoria di un array banalmente spostabile
+     *
+     * Prova a ridurre l'array a capacity elementi con realloc, senza lanciare eccezioni.
+     *
+     * @param data array da ridurre
+     * @param capacity nuova dimensione, maggiore di 0
+     *
+     * @return l'array ridotto, nullptr se la riduzione non è riuscita e data è ancora valido
+     */
+    template <typename T>
+    T *shrink(T *data, unsigned int capacity) noexcept
+    {
+        static_assert(is_trivially_relocatable<T>::value, "shrink requires a trivially relocatable type");
+
+        return static_cast<T *>(std::realloc(data, static_cast<std::size_t>(capacity) * sizeof(T)));
+    }
+}
+
+#endif
@@ -0,0 +1,374 @@
+/**
+ * @file string_set.cpp
+ *
+ * @brief file di implementazione della classe string_set
+ *
+ * File di implementazione dei metodi della classe string_set e delle relative funzioni globali.
+ */
+#include <algorithm> // std::max, std::min, std::swap
+#include <cstring>   // std::memcpy, std::memmove, std::memchr
+#include <fstream>   // std::ifstream, std::ofstream
+#include <stdexcept> // std::runtime_error, std::length_error, std::invalid_argument
+#include <string>    // std::to_string
+#include "string_set.h"
+
+string_set::string_set() : _arena(nullptr), _arena_size(0), _arena_capacity(0),
+                           _entries(nullptr), _size(0), _capacity(0) {}
+
+string_set::string_set(const string_set &other) : _arena(nullptr), _arena_size(0), _arena_capacity(0),
+                                                  _entries(nullptr), _size(0), _capacity(0), _index(other._index)
+{
+    try
+    {
+        if (other._arena_size > 0)
+        {
+            _arena = new char[other._arena_size];
+            std::memcpy(_arena, other._arena, other._arena_size);
+        }
+        if (other._size > 0)
+        {
+            _entries = new entry[other._size];
+            std::copy(other._entries, other._entries + other._size, _entries);
+        }
+    }
+    catch (...)
+    {
+        delete[] _arena;
+        throw;
+    }
+
+    _arena_size = _arena_capacity = other._arena_size;
+    _size = _capacity = other._size;
+}
+
+string_set &string_set::operator=(const string_set &rhs)
+{
+    if (this != &rhs)
+    {
+        string_set tmp(rhs);
+        swap(tmp);
+    }
+
+    return *this;
+}
+
+string_set::~string_set()
+{
+    clear();
+}
+
+unsigned int string_set::size() const
+{
+    return _size;
+}
+
+std::size_t string_set::arena_size() const
+{
+    return _arena_size;
+}
+
+void string_set::reserve(unsigned int count, std::size_t chars)
+{
+    char *arena = nullptr;
+    entry *entries = nullptr;
+
+    try
+    {
+        if (chars > _arena_capacity)
+        {
+            arena = new char[chars];
+        }
+        if (count > _capacity)
+        {
+            entries = new entry[count];
+        }
+        _index.reserve(count);
+    }
+    catch (...)
+    {
+        delete[] arena;
+        delete[] entries;
+        throw;
+    }
+
+    if (arena != nullptr)
+    {
+        if (_arena_size > 0)
+        {
+            std::memcpy(arena, _arena, _arena_size);
+        }
+        delete[] _arena;
+        _arena = arena;
+        _arena_capacity = chars;
+    }
+
+    if (entries != nullptr)
+    {
+        std::copy(_entries, _entries + _size, entries);
+        delete[] _entries;
+        _entries = entries;
+        _capacity = count;
+    }
+}
+
+void string_set::add(std::string_view element)
+{
+    if (element.size() >= 0xFFFFFFFFu)
+    {
+        throw std::length_error("String too long!");
+    }
+
+    if (element.find('\n') != std::string_view::npos || (!element.empty() && element.back() == '\r'))
+    {
+        throw std::invalid_argument("String can't be saved!");
+    }
+
+    const std::uint32_t h = _index.hash_of(element);
+    if (find(element, h) != index_type::NOT_FOUND)
+    {
+        return;
+    }
+
+    const std::size_t needed = _arena_size + element.size() + 1;
+    if (_size == _capacity || needed > _arena_capacity)
+    {
+        reserve(_size == _capacity ? std::max(16u, 2 * _capacity) : _capacity,
+                needed > _arena_capacity ? std::max(needed, 2 * _arena_capacity) : _arena_capacity);
+    }
+
+    // dopo remove l'indice può essere dimensionato per meno elementi dei descrittori:
+    // lo si prepara per _size + 1 elementi prima di ogni modifica, così che insert non allochi
+    _index.reserve(_size + 1);
+    _index.insert(_size, h);
+
+    if (!element.empty())
+    {
+        std::memcpy(_arena + _arena_size, element.data(), element.size());
+    }
+    _arena[_arena_size + element.size()] = '\n';
+
+    _entries[_size].offset = _arena_size;
+    _entries[_size].length = static_cast<std::uint32_t>(element.size());
+    _entries[_size].hash = h;
+
+    _arena_size = needed;
+    ++_size;
+}
+
+void string_set::remove(std::string_view element)
+{
+    const unsigned int pos = find(element, _index.hash_of(element));
+    if (pos == index_type::NOT_FOUND)
+    {
+        return;
+    }
+
+    index_type index(_size - 1);
+    for (unsigned int i = 0; i < _size; ++i)
+    {
+        if (i != pos)
+        {
+            index.insert(i < pos ? i : i - 1, _entries[i].hash);
+        }
+    }
+
+    const std::size_t start = _entries[pos].offset;
+    const std::size_t removed = _entries[pos].length + 1;
+    std::memmove(_arena + start, _arena + start + removed, _arena_size - start - removed);
+    _arena_size -= removed;
+
+    for (unsigned int i = pos + 1; i < _size; ++i)
+    {
+        _entries[i - 1] = _entries[i];
+        _entries[i - 1].offset -= removed;
+    }
+    --_size;
+
+    _index.swap(index);
+}
+
+bool string_set::contains(std::string_view element) const
+{
+    return find(element, _index.hash_of(element)) != index_type::NOT_FOUND;
+}
+
+std::string_view string_set::operator[](unsigned int index) const
+{
+    return view(_entries[index]);
+}
+
+bool string_set::operator==(const string_set &other) const
+{
+    if (_size != other._size)
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < _size; ++i)
+    {
+        if (other.find(view(_entries[i]), _entries[i].hash) == index_type::NOT_FOUND)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void string_set::clear()
+{
+    delete[] _arena;
+    delete[] _entries;
+    _arena = nullptr;
+    _entries = nullptr;
+    _arena_size = _arena_capacity = 0;
+    _size = _capacity = 0;
+    _index.clear();
+}
+
+string_set::iterator string_set::begin() const
+{
+    return iterator(this, 0);
+}
+
+string_set::iterator string_set::end() const
+{
+    return iterator(this, _size);
+}
+
+std::string_view string_set::view(const entry &e) const
+{
+    return std::string_view(_arena + e.offset, e.length);
+}
+
+unsigned int string_set::find(std::string_view element, std::uint32_t h) const
+{
+    return _index.find(element, h, [this](unsigned int i) { return view(_entries[i]); });
+}
+
+void string_set::swap(string_set &other)
+{
+    std::swap(_arena, other._arena);
+    std::swap(_arena_size, other._arena_size);
+    std::swap(_arena_capacity, other._arena_capacity);
+    std::swap(_entries, other._entries);
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+    _index.swap(other._index);
+}
+
+std::ostream &operator<<(std::ostream &os, const string_set &s)
+{
+    os << "{";
+
+    for (string_set::const_iterator i = s.begin(); i != s.end();)
+    {
+        os << *i;
+        ++i;
+
+        if (i != s.end())
+        {
+            os << ", ";
+        }
+    }
+
+    os << "}";
+
+    return os;
+}
+
+void save(const string_set &s, const std::string &filename)
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    ofs << s._size << '\n';
+    if (s._arena_size > 0)
+    {
+        ofs.write(s._arena, static_cast<std::streamsize>(s._arena_size));
+    }
+
+    if (!ofs)
+    {
+        throw std::runtime_error("File can't be written!");
+    }
+    ofs.close();
+}
+
+void load(const std::string &filename, string_set &s)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs.is_open())
+    {
+        throw std::runtime_error("File can't be opened!");
+    }
+
+    unsigned int count = 0;
+    ifs >> count;
+    ifs.ignore(1); // '\n' dopo la lunghezza
+
+    const std::streamoff start = ifs.tellg();
+    ifs.seekg(0, std::ios::end);
+    const std::size_t bytes = static_cast<std::size_t>(ifs.tellg() - start);
+    ifs.seekg(start);
+
+    // un byte in più per il '\n' finale, se manca nel file; ogni riga occupa almeno un byte,
+    // quindi un conteggio maggiore viene da un file corrotto e non deve guidare l'allocazione
+    string_set temp;
+    temp.reserve(static_cast<unsigned int>(std::min<std::size_t>(count, bytes + 1)), bytes + 1);
+    if (bytes > 0)
+    {
+        ifs.read(temp._arena, static_cast<std::streamsize>(bytes));
+    }
+    if (bytes > 0 && temp._arena[bytes - 1] != '\n')
+    {
+        temp._arena[bytes] = '\n';
+    }
+
+    const char *end = temp._arena + bytes + 1;
+    std::size_t read = 0;
+    for (unsigned int n = 0; n < count; ++n)
+    {
+        if (read >= bytes)
+        {
+            throw std::runtime_error("Corrupted file!");
+        }
+
+        const char *line = temp._arena + read;
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        std::size_t length = static_cast<std::size_t>(newline - line);
+        read += length + 1;
+        if (length > 0 && line[length - 1] == '\r')
+        {
+            --length;
+        }
+
+        const std::string_view element(line, length);
+        const std::uint32_t h = temp._index.hash_of(element);
+        if (temp.find(element, h) != string_set::index_type::NOT_FOUND)
+        {
+            continue;
+        }
+
+        // gli elementi vengono compattati solo se prima ci sono stati duplicati o '\r'
+        if (temp._arena + temp._arena_size != line)
+        {
+            std::memmove(temp._arena + temp._arena_size, line, length);
+        }
+        temp._arena[temp._arena_size + length] = '\n';
+
+        temp._index.insert(temp._size, h);
+        temp._entries[temp._size].offset = temp._arena_size;
+        temp._entries[temp._size].length = static_cast<std::uint32_t>(length);
+        temp._entries[temp._size].hash = h;
+
+        temp._arena_size += length + 1;
+        ++temp._size;
+    }
+
+    s.swap(temp);
+    ifs.close();
+}
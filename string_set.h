@@ -0,0 +1,442 @@
+/**
+ * @file string_set.h
+ *
+ * @brief file di dichiarazione della classe string_set
+ *
+ * File di dichiarazione della classe string_set, un insieme di stringhe
+ * che memorizza i caratteri in un unico buffer contiguo.
+ * Contiene anche la dichiarazione delle funzioni globali per:
+ * - scrittura su stream
+ * - filtraggio
+ * - scrittura e lettura su file
+ */
+#ifndef STRING_SET_H
+#define STRING_SET_H
+
+#include <cstddef>     // std::size_t, std::ptrdiff_t
+#include <cstdint>     // std::uint32_t
+#include <functional>  // std::equal_to, std::hash
+#include <iterator>    // std::forward_iterator_tag
+#include <ostream>     // ostream
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include "hash_index.hpp"
+
+/**
+ * @brief classe string_set che rappresenta un insieme di stringhe
+ *
+ * La classe string_set rappresenta un insieme di stringhe senza duplicati, con la stessa semantica di
+ * set<std::string, std::equal_to<std::string>> ma senza un'allocazione per ogni stringa:
+ * i caratteri di tutte le stringhe sono memorizzati uno dopo l'altro in un unico buffer (arena),
+ * ciascuno seguito da '\n', e ogni elemento è descritto da posizione e lunghezza nell'arena.
+ * Per ogni elemento viene memorizzato anche il suo hash, usato dall'indice hash interno
+ * e nei confronti, così che nessuna stringa venga letta o rielaborata più del necessario.
+ *
+ * La ricerca accetta std::string_view: contains("World") non crea alcuna std::string temporanea.
+ * Gli elementi sono restituiti come std::string_view che puntano nell'arena
+ * e restano validi fino alla successiva modifica del set.
+ * L'ordine degli elementi è quello di inserimento, come in set.
+ */
+class string_set
+{
+private:
+    /**
+     * @brief descrittore di un elemento
+     */
+    struct entry
+    {
+        std::size_t offset;   ///< posizione del primo carattere nell'arena
+        std::uint32_t length; ///< numero di caratteri
+        std::uint32_t hash;   ///< hash rimescolato della stringa, come calcolato dall'indice
+    };
+
+    typedef hash_index<std::string_view, std::equal_to<std::string_view>, std::hash<std::string_view>> index_type;
+
+    char *_arena;                ///< puntatore all'arena dei caratteri
+    std::size_t _arena_size;     ///< numero di byte usati dell'arena
+    std::size_t _arena_capacity; ///< numero di byte allocati per l'arena
+
+    entry *_entries;        ///< puntatore all'array dei descrittori
+    unsigned int _size;     ///< numero di elementi
+    unsigned int _capacity; ///< numero di descrittori allocati
+
+    index_type _index; ///< indice hash delle posizioni degli elementi
+
+public:
+    /**
+     * @brief costruttore di default
+     *
+     * Crea un insieme vuoto che non occupa memoria.
+     *
+     * @post _size == 0
+     * @post _arena_size == 0
+     */
+    string_set();
+
+    /**
+     * @brief costruttore di copia
+     *
+     * Copia arena, descrittori e indice senza ricalcolare alcun hash.
+     *
+     * @param other insieme da copiare
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     */
+    string_set(const string_set &other);
+
+    /**
+     * @brief costruttore che riempie il set a partire da una sequenza
+     *
+     * Aggiunge uno ad uno gli elementi della sequenza, ignorando i duplicati.
+     * Gli elementi devono essere convertibili in std::string_view.
+     * In caso di errore il set non viene creato.
+     *
+     * @param begin iteratore di inizio sequenza
+     * @param end iteratore di fine sequenza
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     */
+    template <typename IterT>
+    string_set(IterT begin, IterT end) : string_set()
+    {
+        while (begin != end)
+        {
+            add(std::string_view(*begin));
+            ++begin;
+        }
+    }
+
+    /**
+     * @brief operatore di assegnamento
+     *
+     * In caso di errore l'operazione viene annullata.
+     *
+     * @param rhs insieme da copiare
+     *
+     * @return reference all'insieme modificato
+     *
+     * @throws std::bad_alloc se lanciata dal costruttore di copia
+     */
+    string_set &operator=(const string_set &rhs);
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Libera la memoria occupata da arena, descrittori e indice.
+     */
+    ~string_set();
+
+    /**
+     * @brief metodo per la cardinalità del set
+     *
+     * @return cardinalità del set
+     */
+    unsigned int size() const;
+
+    /**
+     * @brief numero di caratteri memorizzati
+     *
+     * @return numero di byte usati dall'arena, separatori compresi
+     */
+    std::size_t arena_size() const;
+
+    /**
+     * @brief prepara il set per un numero di elementi e di caratteri
+     *
+     * Alloca spazio per count elementi con in totale chars caratteri,
+     * in modo che i successivi add non debbano riallocare.
+     * In caso di errore il set rimane invariato.
+     *
+     * @param count numero di elementi previsto
+     * @param chars numero totale di caratteri previsto
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     */
+    void reserve(unsigned int count, std::size_t chars);
+
+    /**
+     * @brief aggiunge un elemento al set
+     *
+     * Se l'elemento è già presente, l'operazione non ha effetto.
+     * Arena e descrittori crescono raddoppiando, quindi il costo ammortizzato è costante.
+     * In caso di errore il set rimane invariato.
+     *
+     * @param element stringa da aggiungere
+     *
+     * @post contains(element) == true
+     *
+     * @throws std::bad_alloc se l'allocazione fallisce
+     * @throws std::length_error se element è più lunga di 2^32 - 2 caratteri
+     * @throws std::invalid_argument se element contiene '\n' o termina con '\r',
+     *         caratteri che il formato di save non può rappresentare
+     */
+    void add(std::string_view element);
+
+    /**
+     * @brief rimuove un elemento dal set
+     *
+     * Se l'elemento non è presente, l'operazione non ha effetto.
+     * I caratteri successivi vengono spostati per chiudere il buco nell'arena,
+     * così che l'ordine degli elementi resti quello di inserimento.
+     * L'indice viene ricostruito dagli hash memorizzati, senza rileggere le stringhe.
+     * In caso di errore il set rimane invariato.
+     *
+     * @param element stringa da rimuovere
+     *
+     * @post contains(element) == false
+     *
+     * @throws std::bad_alloc se l'allocazione del nuovo indice fallisce
+     */
+    void remove(std::string_view element);
+
+    /**
+     * @brief ricerca un elemento nel set
+     *
+     * Accetta std::string, std::string_view e stringhe C senza creare copie.
+     *
+     * @param element stringa da cercare
+     *
+     * @return true se l'elemento è presente, false altrimenti
+     */
+    bool contains(std::string_view element) const;
+
+    /**
+     * @brief operatore di accesso in lettura
+     *
+     * @param index posizione dell'elemento
+     *
+     * @pre index < size()
+     *
+     * @return vista sull'elemento in posizione index, valida fino alla successiva modifica
+     */
+    std::string_view operator[](unsigned int index) const;
+
+    /**
+     * @brief operatore di confronto tra due set
+     *
+     * Gli hash memorizzati vengono riusati per cercare gli elementi nell'altro set.
+     *
+     * @param other secondo set da confrontare
+     *
+     * @return true se i due set contengono gli stessi elementi, false altrimenti
+     */
+    bool operator==(const string_set &other) const;
+
+    /**
+     * @brief svuota il set
+     *
+     * Libera tutta la memoria occupata.
+     *
+     * @post size() == 0
+     */
+    void clear();
+
+    /**
+     * @brief iteratore costante della classe string_set
+     *
+     * Rappresenta un forward const_iterator che restituisce gli elementi come std::string_view.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::string_view *pointer;
+        typedef std::string_view reference;
+
+        /**
+         * @brief costruttore di default
+         */
+        const_iterator() : _owner(nullptr), _pos(0) {}
+
+        /**
+         * @brief operatore di dereferenziamento
+         *
+         * @return vista sull'elemento puntato dall'iteratore
+         */
+        reference operator*() const
+        {
+            return (*_owner)[_pos];
+        }
+
+        /**
+         * @brief operatore di pre-incremento
+         *
+         * @return l'iteratore aggiornato
+         */
+        const_iterator &operator++()
+        {
+            ++_pos;
+            return *this;
+        }
+
+        /**
+         * @brief operatore di post-incremento
+         *
+         * @return un iteratore nello stato precedente alla chiamata
+         */
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++_pos;
+            return tmp;
+        }
+
+        /**
+         * @brief operatore di uguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori puntano alla stessa posizione
+         */
+        bool operator==(const const_iterator &other) const
+        {
+            return _pos == other._pos;
+        }
+
+        /**
+         * @brief operatore di disuguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori puntano a posizioni diverse
+         */
+        bool operator!=(const const_iterator &other) const
+        {
+            return _pos != other._pos;
+        }
+
+    private:
+        const string_set *_owner; ///< set su cui si itera
+        unsigned int _pos;        ///< posizione dell'elemento puntato
+
+        friend class string_set;
+
+        /**
+         * @brief costruttore privato
+         *
+         * @param owner set su cui iterare
+         * @param pos posizione iniziale
+         */
+        const_iterator(const string_set *owner, unsigned int pos) : _owner(owner), _pos(pos) {}
+    }; // const_iterator
+
+    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * @return l'iteratore di inizio sequenza del set
+     */
+    iterator begin() const;
+
+    /**
+     * @brief iteratore di fine
+     *
+     * @return l'iteratore di fine sequenza del set
+     */
+    iterator end() const;
+
+    friend void save(const string_set &s, const std::string &filename);
+    friend void load(const std::string &filename, string_set &s);
+
+private:
+    /**
+     * @brief vista su un elemento a partire dal descrittore
+     *
+     * @param e descrittore dell'elemento
+     *
+     * @return vista sui caratteri dell'elemento
+     */
+    std::string_view view(const entry &e) const;
+
+    /**
+     * @brief cerca un elemento con hash già calcolato
+     *
+     * @param element stringa da cercare
+     * @param h hash dell'elemento, come calcolato dall'indice
+     *
+     * @return posizione dell'elemento, index_type::NOT_FOUND se non è presente
+     */
+    unsigned int find(std::string_view element, std::uint32_t h) const;
+
+    /**
+     * @brief scambia il contenuto di due set
+     *
+     * @param other set con cui scambiare il contenuto
+     */
+    void swap(string_set &other);
+}; // string_set
+
+/**
+ * @brief funzione globale per stampare uno string_set su stream
+ *
+ * Stampa uno string_set su stream nello stesso formato di set:
+ * - {e1, e2, ..., en}
+ *
+ * @param os stream di output su cui stampare
+ * @param s set da stampare
+ */
+std::ostream &operator<<(std::ostream &os, const string_set &s);
+
+/**
+ * @brief funzione per filtrare uno string_set
+ *
+ * Crea un nuovo set che contiene solo gli elementi che rispettano pred.
+ *
+ * @param S set da filtrare
+ * @param pred predicato booleano che prende in input una std::string_view
+ *
+ * @return un set contenente tutti e soli gli elementi di S che rispettano pred
+ *
+ * @throws std::bad_alloc se l'allocazione fallisce
+ */
+template <typename P>
+string_set filter_out(const string_set &S, P pred)
+{
+    string_set result;
+
+    for (string_set::const_iterator i = S.begin(); i != S.end(); ++i)
+    {
+        if (pred(*i))
+        {
+            result.add(*i);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief funzione per salvare uno string_set su un file di testo
+ *
+ * Il formato è lo stesso di save per set:
+ * - prima riga: lunghezza
+ * - dalla seconda riga in poi: un elemento per riga
+ * Dato che l'arena contiene già gli elementi separati da '\n', viene scritta con una sola operazione.
+ *
+ * @param s set da salvare
+ * @param filename stringa contenente il file da salvare
+ *
+ * @throw std::runtime_error se il file non viene aperto o la scrittura fallisce
+ */
+void save(const string_set &s, const std::string &filename);
+
+/**
+ * @brief funzione per leggere uno string_set da un file di testo
+ *
+ * Il formato è lo stesso di load per set. Il file viene letto con una sola operazione
+ * direttamente nella nuova arena; gli elementi vengono poi individuati in place,
+ * compattando l'arena solo se il file contiene duplicati.
+ * In caso di errore s rimane invariato.
+ *
+ * @param filename stringa contenente il file da leggere
+ * @param s set in cui leggere il contenuto del file
+ *
+ * @throw std::runtime_error se il file non esiste o ha meno elementi di quelli dichiarati
+ * @throws std::bad_alloc se l'allocazione fallisce
+ */
+void load(const std::string &filename, string_set &s);
+
+#endif
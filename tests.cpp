@@ -8,8 +8,42 @@
  */
 #include <iostream>
 #include <cassert>    // assert
+#include <stdexcept>  // std::runtime_error
 #include <functional> // std::equal_to
+#include <cstdio>     // std::remove
+#include <vector>     // std::vector
+#include <thread>     // std::thread
+#include <sstream>    // std::ostringstream, std::istringstream
+#include <iterator>   // std::back_inserter, std::istream_iterator
+#include <cstdint>    // std::uint64_t
+#include <atomic>     // std::atomic
+#include <algorithm>  // std::for_each, std::count_if, std::sort
+#include <numeric>    // std::reduce
+#if __has_include(<tbb/tbb.h>) && !defined(SET_NO_TBB)
+#include <execution>  // std::execution
+#define SET_PARALLEL_ALGORITHMS // gli algoritmi paralleli usano Intel TBB, collegata con -ltbb
+#endif
+#include <span>       // std::span
+#include <list>       // std::list
+#include <filesystem> // std::filesystem::remove_all, std::filesystem::directory_iterator
+#include <sys/wait.h> // waitpid
+#include <unistd.h>   // fork, getpid, _exit
 #include "set.hpp"
+#include "static_set.hpp"
+#include "journal.hpp"
+#include "packed_io.hpp"
+#include "async_io.hpp"
+#include "immutable_set.hpp"
+#include "string_set.h"
+#include "similarity.hpp"
+#include "hyperloglog.hpp"
+#include "set_reader.hpp"
+#include "parallel_io.hpp"
+#include "external_set.hpp"
+#include "shared_set.hpp"
+#include "view_set.hpp"
+#include "sorted_files.hpp"
+#include "trace.hpp"
 #include "point.h"
 #include "tests.h"
 
@@ -29,6 +63,31 @@ void run_all_tests()
     test_filter_out();
     test_stress_reallocation();
     test_files();
+    test_static_set();
+    test_bloom_filter();
+    test_journal();
+    test_packed_format();
+    test_async_io();
+    test_union_intersect_all();
+    test_copy_on_write();
+    test_immutable_set();
+    test_string_set();
+    test_similarity();
+    test_hyperloglog();
+    test_random_access();
+    test_parallel_construction();
+    test_set_reader();
+    test_adaptive_layout();
+    test_relocation();
+    test_batch_membership();
+    test_hash_cache();
+    test_parallel_io();
+    test_memory_usage();
+    test_external_set();
+    test_shared_set();
+    test_view_set();
+    test_sorted_files();
+    test_trace();
 
     std::cout << std::endl;
     std::cout << "========================================" << std::endl;
@@ -371,6 +430,2163 @@ void test_files()
     std::cout << "OK" << std::endl;
 }
 
+void test_static_set()
+{
+    std::cout << "[11] Test static_set... ";
+
+    constexpr static_set<int, std::equal_to<int>, 4> codes = {200, 201, 204, 304};
+    static_assert(codes.size() == 4, "size errata");
+    static_assert(codes.contains(204), "204 deve essere presente");
+    static_assert(!codes.contains(404), "404 non deve essere presente");
+
+    constexpr static_set<point, ArePointEqual, 2> reserved = {{0, 0}, {1, 1}};
+    static_assert(reserved.contains({1, 1}), "(1,1) deve essere presente");
+    static_assert(!reserved.contains({1, 0}), "(1,0) non deve essere presente");
+
+    // constexpr static_set<int, std::equal_to<int>, 2> dup = {1, 1}; // ERRORE DI COMPILAZIONE SE SCOMMENTATO
+
+    // Con un funtore di hash constexpr la tabella viene costruita a tempo di compilazione
+    struct StatusHash
+    {
+        constexpr std::size_t operator()(int n) const { return static_cast<std::size_t>(n); }
+    };
+    constexpr static_set<int, std::equal_to<int>, 4, StatusHash> hashed = {200, 201, 204, 304};
+    static_assert(hashed.contains(200) && hashed.contains(304), "200 e 304 devono essere presenti");
+    static_assert(!hashed.contains(404) && !hashed.contains(0), "404 e 0 non devono essere presenti");
+
+    // Con std::hash la tabella viene costruita a runtime
+    const static_set<int, std::equal_to<int>, 3, std::hash<int>> runtime_hashed = {7, -7, 70};
+    assert(runtime_hashed.contains(-7) && !runtime_hashed.contains(8));
+
+    // Duplicati a runtime
+    bool exception_thrown = false;
+    try
+    {
+        static_set<int, std::equal_to<int>, 2> dup = {1, 1};
+        assert(dup.size() == 2); // non raggiunto
+    }
+    catch (const std::logic_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    exception_thrown = false;
+    try
+    {
+        static_set<int, std::equal_to<int>, 3, std::hash<int>> dup = {1, 2, 1};
+        assert(dup.size() == 3); // non raggiunto
+    }
+    catch (const std::logic_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    // Conversione a set
+    set<int, std::equal_to<int>> s = codes;
+    assert(s.size() == 4);
+    assert(s.contains(304));
+
+    set<int, std::equal_to<int>> other;
+    other.add(404);
+    other.add(200);
+
+    // Unione e intersezione
+    assert((other + codes).size() == 5);
+    assert((codes + other).size() == 5);
+    assert((other - codes).size() == 1);
+    assert((codes - other).contains(200));
+    assert((other - hashed).size() == 1 && (hashed + other).size() == 5);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_bloom_filter()
+{
+    std::cout << "[12] Test Bloom Filter... ";
+
+    // Filtro da solo: nessun falso negativo, falsi positivi vicini a quelli richiesti
+    bloom_filter<int, std::hash<int>> filter(1000, 0.01);
+    for (int i = 0; i < 1000; ++i)
+    {
+        filter.add(i);
+    }
+
+    int false_positives = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        assert(filter.possibly_contains(i));
+    }
+    for (int i = 1000; i < 11000; ++i)
+    {
+        if (filter.possibly_contains(i))
+        {
+            ++false_positives;
+        }
+    }
+    assert(false_positives < 300); // < 3%
+
+    // Filtro integrato nel set
+    set<int, std::equal_to<int>, std::hash<int>> s;
+    s.enable_filter(0.01);
+    assert(s.has_filter());
+
+    for (int i = 0; i < 200; ++i) // supera la capacità iniziale, il filtro viene ricostruito
+    {
+        s.add(i);
+    }
+    assert(s.size() == 200);
+    for (int i = 0; i < 200; ++i)
+    {
+        assert(s.contains(i));
+    }
+    assert(!s.contains(-1));
+    assert(!s.contains(1000));
+
+    s.remove(10);
+    assert(!s.contains(10));
+    assert(s.contains(11));
+    assert(s.size() == 199);
+
+    // Copia, confronto e intersezione
+    set<int, std::equal_to<int>, std::hash<int>> copy(s);
+    assert(copy.has_filter());
+    assert(copy == s);
+
+    copy.remove(20);
+    copy.add(10);
+    assert(!(copy == s));
+
+    set<int, std::equal_to<int>, std::hash<int>> inter = s - copy;
+    assert(inter.size() == 198);
+    assert(!inter.contains(10));
+    assert(!inter.contains(20));
+
+    // Svuotamento: il filtro rimane abilitato
+    set<point, ArePointEqual, PointHash> p;
+    p.enable_filter();
+    p.add({1, 2});
+    p.remove({1, 2});
+    assert(p.size() == 0);
+    assert(p.has_filter());
+    assert(!p.contains({1, 2}));
+
+    p.add({3, 4});
+    save(p, "test_bloom_set.txt");
+
+    set<point, ArePointEqual, PointHash> loaded;
+    loaded.enable_filter(0.05);
+    load("test_bloom_set.txt", loaded);
+    assert(loaded.has_filter());
+    assert(loaded.contains({3, 4}));
+
+    p.disable_filter();
+    assert(!p.has_filter());
+    assert(p.contains({3, 4}));
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_journal()
+{
+    std::cout << "[13] Test Journal... ";
+
+    std::string snapshot = "test_journal_snapshot.txt";
+    std::string log = "test_journal_log.txt";
+    std::remove(snapshot.c_str());
+    std::remove(log.c_str());
+
+    {
+        journaled_set<point, ArePointEqual> js(snapshot, log);
+        assert(js.size() == 0);
+
+        js.add({1, 1});
+        js.add({2, 2});
+        js.add({1, 1}); // Duplicato: non registrato
+        js.remove({2, 2});
+        js.remove({5, 5}); // Assente: non registrato
+        js.add({3, 3});
+        assert(js.journal_records() == 4);
+        js.sync();
+    }
+
+    // Rilettura da journal senza snapshot
+    {
+        journaled_set<point, ArePointEqual> js(snapshot, log);
+        assert(js.size() == 2);
+        assert(js.contains({1, 1}));
+        assert(js.contains({3, 3}));
+        assert(!js.contains({2, 2}));
+        assert(js.journal_records() == 4);
+
+        js.checkpoint();
+        assert(js.journal_records() == 0);
+        js.add({4, 4});
+    }
+
+    // Snapshot + journal, con un'ultima operazione scritta a metà
+    {
+        std::ofstream ofs(log, std::ios::app);
+        ofs << "+ (9,";
+    }
+
+    set<point, ArePointEqual> s;
+    assert(load_journal(snapshot, log, s) == 1);
+    assert(s.size() == 3);
+    assert(s.contains({4, 4}));
+    assert(!s.contains({9, 9}));
+
+    // La riga incompleta viene tagliata alla riapertura: l'operazione successiva non vi si accoda
+    {
+        journaled_set<point, ArePointEqual> js(snapshot, log);
+        js.add({5, 5});
+        js.sync();
+    }
+    {
+        journaled_set<point, ArePointEqual> js(snapshot, log);
+        assert(js.size() == 4);
+        assert(js.contains({5, 5}));
+        assert(!js.contains({9, 9}));
+    }
+
+    // Caratteri dopo l'elemento
+    {
+        std::ofstream ofs(log, std::ios::app);
+        ofs << "+ (6,6)+ (7,7)\n";
+    }
+    bool exception_thrown = false;
+    try
+    {
+        load_journal(snapshot, log, s);
+    }
+    catch (const std::runtime_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    // Compattazione automatica
+    std::remove(snapshot.c_str());
+    std::remove(log.c_str());
+    {
+        journaled_set<int, std::equal_to<int>> js(snapshot, log, 0.5);
+        for (int i = 0; i < 200; ++i)
+        {
+            js.add(i);
+        }
+        assert(js.journal_records() < 200);
+    }
+
+    set<int, std::equal_to<int>> ints;
+    load_journal(snapshot, log, ints);
+    assert(ints.size() == 200);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_packed_format()
+{
+    std::cout << "[14] Test Formato Compresso... ";
+
+    // Interi, anche negativi e agli estremi
+    set<int, std::equal_to<int>> ints;
+    ints.add(0);
+    ints.add(-7);
+    ints.add(2147483647);
+    ints.add(-2147483647 - 1);
+    ints.add(42);
+
+    save(ints, "test_packed_int.bin", set_format::packed);
+
+    set<int, std::equal_to<int>> ints_in;
+    load("test_packed_int.bin", ints_in, set_format::packed);
+    assert(ints_in == ints);
+
+    // Punti su più blocchi
+    set<point, ArePointEqual, PointHash> points;
+    points.enable_filter();
+    for (int i = 0; i < 2500; ++i)
+    {
+        points.add({i % 50, (i / 50) * 3 - 40});
+    }
+
+    save(points, "test_packed_point.bin", set_format::packed);
+    save(points, "test_packed_point.txt", set_format::text);
+
+    set<point, ArePointEqual, PointHash> points_in;
+    load("test_packed_point.bin", points_in, set_format::packed);
+    assert(points_in.size() == 2500);
+    assert(points_in == points);
+
+    // La cache degli hash del set di destinazione viene mantenuta
+    set<point, ArePointEqual, PointHash> cached;
+    cached.enable_hash_cache();
+    load("test_packed_point.bin", cached, set_format::packed);
+    assert(cached.has_hash_cache() && cached == points);
+
+    std::ifstream packed_file("test_packed_point.bin", std::ios::binary | std::ios::ate);
+    std::ifstream text_file("test_packed_point.txt", std::ios::binary | std::ios::ate);
+    assert(packed_file.tellg() * 3 < text_file.tellg());
+
+    // Set vuoto
+    set<point, ArePointEqual, PointHash> empty;
+    save(empty, "test_packed_empty.bin", set_format::packed);
+    load("test_packed_empty.bin", points_in, set_format::packed);
+    assert(points_in.size() == 0);
+
+    // Un file testuale non è nel formato compresso
+    bool exception_thrown = false;
+    try
+    {
+        load("test_packed_point.txt", points_in, set_format::packed);
+    }
+    catch (const std::runtime_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    // Un conteggio nell'intestazione maggiore dei dati non viene usato per allocare
+    {
+        std::fstream fs("test_packed_empty.bin", std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekp(6);
+        fs.write("\xff\xff\xff\xff", 4);
+    }
+    exception_thrown = false;
+    try
+    {
+        load("test_packed_empty.bin", points_in, set_format::packed);
+    }
+    catch (const std::runtime_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    // Righe non crescenti (duplicati) e coordinate fuori dall'intervallo di int
+    const std::string duplicates("SETP\x01\x01\x02\0\0\0\x01\0\0\0\x02\0\0\0\x02\0\0\0\x0a\x00", 24);
+    const std::string overflow("SETP\x01\x01\x01\0\0\0\x01\0\0\0\x01\0\0\0\x06\0\0\0\x80\x80\x80\x80\x80\x40", 28);
+    for (const std::string &content : {duplicates, overflow})
+    {
+        {
+            std::ofstream ofs("test_packed_int.bin", std::ios::binary);
+            ofs << content;
+        }
+        exception_thrown = false;
+        try
+        {
+            load("test_packed_int.bin", ints_in, set_format::packed);
+        }
+        catch (const std::runtime_error &)
+        {
+            exception_thrown = true;
+        }
+        assert(exception_thrown);
+    }
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_async_io()
+{
+    std::cout << "[15] Test I/O Asincrono... ";
+
+    set<point, ArePointEqual> s;
+    for (int i = 0; i < 500; ++i)
+    {
+        s.add({i, -i});
+    }
+    set<point, ArePointEqual> expected(s);
+
+    // Il set può essere modificato mentre viene salvato
+    std::future<void> saved = save_async(s, "test_async_set.txt");
+    s.add({1000, 1000});
+    s.remove({0, 0});
+    saved.get();
+
+    // Il file è identico a quello scritto da save
+    save(expected, "test_async_expected.txt");
+    std::ifstream a("test_async_set.txt");
+    std::ifstream b("test_async_expected.txt");
+    std::string content_a((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+    std::string content_b((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+    assert(content_a == content_b);
+
+    std::future<set<point, ArePointEqual>> loaded = load_async<point, ArePointEqual>("test_async_set.txt");
+    set<point, ArePointEqual> s_in = loaded.get();
+    assert(s_in == expected);
+    assert(!s_in.contains({1000, 1000}));
+
+    // Errori
+    bool exception_thrown = false;
+    try
+    {
+        load_async<point, ArePointEqual>("file_fantasma_12345.txt").get();
+    }
+    catch (const std::runtime_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    // Annullamento: il file precedente rimane intatto
+    io_token token;
+    token.cancel();
+
+    exception_thrown = false;
+    try
+    {
+        save_async(s, "test_async_set.txt", token).get();
+    }
+    catch (const io_cancelled &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    set<point, ArePointEqual> unchanged;
+    load("test_async_set.txt", unchanged);
+    assert(unchanged == expected);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_union_intersect_all()
+{
+    std::cout << "[16] Test union_all e intersect_all... ";
+
+    // reserve
+    set<int, std::equal_to<int>> r;
+    r.reserve(10);
+    assert(r.capacity() == 10);
+    r.add(1);
+    r.add(2);
+    r.add(1);
+    assert(r.size() == 2);
+    assert(r.capacity() == 10);
+    r.remove(1);
+    assert(r.capacity() == 1);
+
+    // Set con funtore di hash: {k, k+1, ..., k+99} per k = 0, 10, ..., 90
+    typedef set<int, std::equal_to<int>, std::hash<int>> hashed_set;
+    std::vector<hashed_set> shards(10);
+    for (int k = 0; k < 10; ++k)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            shards[k].add(k * 10 + i);
+        }
+    }
+
+    hashed_set chained;
+    for (const hashed_set &shard : shards)
+    {
+        chained = chained + shard;
+    }
+
+    hashed_set u1 = union_all(shards.begin(), shards.end());
+    hashed_set u4 = union_all(shards.begin(), shards.end(), 4);
+    assert(u1.size() == 190);
+    assert(u1 == chained);
+    assert(u4 == chained);
+    for (unsigned int i = 0; i < u1.size(); ++i) // stesso ordine di +
+    {
+        assert(u1[i] == chained[i]);
+    }
+
+    hashed_set i1 = intersect_all(shards.begin(), shards.end());
+    hashed_set i4 = intersect_all(shards.begin(), shards.end(), 4);
+    assert(i1.size() == 10); // {90, ..., 99}
+    assert(i1.contains(90));
+    assert(i1.contains(99));
+    assert(i4 == i1);
+    assert(i1 == (shards[0] - shards[9]));
+
+    // Set senza funtore di hash
+    std::vector<set<point, ArePointEqual>> points(3);
+    points[0].add({0, 0});
+    points[0].add({1, 1});
+    points[1].add({1, 1});
+    points[1].add({2, 2});
+    points[2].add({1, 1});
+
+    set<point, ArePointEqual> pu = union_all(points.begin(), points.end());
+    assert(pu.size() == 3);
+    assert(pu == (points[0] + points[1] + points[2]));
+
+    set<point, ArePointEqual> pi = intersect_all(points.begin(), points.end());
+    assert(pi.size() == 1);
+    assert(pi.contains({1, 1}));
+
+    // Sequenza vuota
+    assert(union_all(points.begin(), points.begin()).size() == 0);
+    assert(intersect_all(points.begin(), points.begin()).size() == 0);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_copy_on_write()
+{
+    std::cout << "[17] Test Copy-on-Write... ";
+
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> s1;
+    s1.enable_filter();
+    s1.add("a");
+    s1.add("b");
+    s1.add("c");
+
+    // La copia condivide gli elementi
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> s2(s1);
+    assert(&s2[0] == &s1[0]);
+    assert(s2 == s1);
+
+    // La prima modifica crea una versione privata
+    s2.add("d");
+    assert(&s2[0] != &s1[0]);
+    assert(s1.size() == 3);
+    assert(!s1.contains("d"));
+    assert(s2.contains("d"));
+
+    // Anche l'assegnamento condivide
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> s3;
+    s3 = s1;
+    assert(&s3[0] == &s1[0]);
+    s1.remove("a");
+    assert(s3.contains("a"));
+    assert(!s1.contains("a"));
+    assert(s3.has_filter());
+
+    // Spazio libero condiviso: la scrittura non deve sporcare l'altra copia
+    set<int, std::equal_to<int>> r1;
+    r1.reserve(4);
+    r1.add(1);
+    set<int, std::equal_to<int>> r2(r1);
+    r2.add(2);
+    r1.add(3);
+    assert(r1.size() == 2 && r1.contains(3) && !r1.contains(2));
+    assert(r2.size() == 2 && r2.contains(2) && !r2.contains(3));
+
+    // Più thread copiano e modificano copie dello stesso set
+    set<int, std::equal_to<int>, std::hash<int>> base;
+    for (int i = 0; i < 100; ++i)
+    {
+        base.add(i);
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> ok(4, 0);
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&base, &ok, t]() {
+            for (int k = 0; k < 50; ++k)
+            {
+                set<int, std::equal_to<int>, std::hash<int>> copy(base);
+                copy.add(1000 + t);
+                copy.remove(t);
+                if (copy.size() != 100 || copy.contains(t) || !base.contains(t))
+                {
+                    return;
+                }
+            }
+            ok[t] = 1;
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    assert(ok[0] && ok[1] && ok[2] && ok[3]);
+    assert(base.size() == 100);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_immutable_set()
+{
+    std::cout << "[18] Test Immutable Set... ";
+
+    typedef immutable_set<int, std::hash<int>, std::equal_to<int>> iset;
+
+    // Ogni versione rimane invariata
+    std::vector<iset> versions;
+    versions.push_back(iset());
+    for (int i = 0; i < 2000; ++i)
+    {
+        versions.push_back(versions.back().add(i));
+    }
+    for (int v = 0; v <= 2000; v += 97)
+    {
+        assert(versions[v].size() == static_cast<unsigned int>(v));
+        assert(v == 0 || versions[v].contains(v - 1));
+        assert(!versions[v].contains(v));
+    }
+
+    // Aggiungere un elemento presente o rimuoverne uno assente non cambia nulla
+    iset full = versions.back();
+    assert(full.add(5).size() == 2000);
+    assert(full.remove(-1).size() == 2000);
+
+    // Rimozione di tutti gli elementi, verificando l'iterazione a ogni passo
+    iset shrinking = full;
+    for (int i = 0; i < 2000; i += 2)
+    {
+        shrinking = shrinking.remove(i);
+    }
+    assert(shrinking.size() == 1000);
+    assert(!shrinking.contains(0) && shrinking.contains(1));
+    assert(full.size() == 2000 && full.contains(0));
+
+    unsigned int count = 0;
+    for (iset::const_iterator i = shrinking.begin(); i != shrinking.end(); ++i)
+    {
+        assert(*i % 2 == 1);
+        ++count;
+    }
+    assert(count == 1000);
+
+    for (int i = 1; i < 2000; i += 2)
+    {
+        shrinking = shrinking.remove(i);
+    }
+    assert(shrinking.size() == 0);
+    assert(shrinking.begin() == shrinking.end());
+
+    // Stampa nello stesso formato di set
+    iset small = iset().add(7);
+    std::ostringstream out;
+    out << small << " " << iset();
+    assert(out.str() == "{7} {}");
+
+    // Filtraggio
+    iset evens = filter_out(versions[100], IsEven());
+    assert(evens.size() == 50);
+    assert(evens.contains(42) && !evens.contains(43));
+    assert(versions[100].size() == 100);
+
+    // Conversioni da e verso set
+    set<int, std::equal_to<int>> s;
+    s.add(3);
+    s.add(1);
+    s.add(2);
+    iset from(s);
+    assert(from.size() == 3 && from.contains(1) && from.contains(2) && from.contains(3));
+
+    set<int, std::equal_to<int>> back = evens.to_set();
+    assert(back.size() == 50);
+    assert(back.contains(0) && back.contains(98));
+
+    // Hash costante: tutti gli elementi finiscono in un nodo di collisione
+    typedef immutable_set<std::string, ConstantHash, std::equal_to<std::string>> cset;
+    cset c;
+    c = c.add("a").add("b").add("c");
+    cset c2 = c.remove("b");
+    assert(c.size() == 3 && c.contains("b"));
+    assert(c2.size() == 2 && !c2.contains("b") && c2.contains("a") && c2.contains("c"));
+    assert(c2.remove("a").remove("c").size() == 0);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_string_set()
+{
+    std::cout << "[19] Test String Set... ";
+
+    string_set s;
+    s.add("Hello");
+    s.add("World");
+    s.add("");
+    s.add(std::string("Hello"));
+    assert(s.size() == 3);
+    assert(s.arena_size() == 13);
+
+    // Ricerca senza stringhe temporanee
+    const char *literal = "World";
+    assert(s.contains(literal));
+    assert(s.contains(std::string_view("Worldwide", 5)));
+    assert(s.contains(""));
+    assert(!s.contains("world"));
+    assert(s[1] == "World");
+
+    std::ostringstream out;
+    out << s;
+    assert(out.str() == "{Hello, World, }");
+
+    // Rimozione: l'ordine di inserimento viene mantenuto
+    string_set copy(s);
+    s.remove("Hello");
+    s.remove("missing");
+    assert(s.size() == 2 && s[0] == "World" && s[1] == "");
+    assert(copy.size() == 3 && copy.contains("Hello"));
+    s.add("again");
+    assert(s.contains("again") && s[2] == "again");
+
+    // Molti elementi: l'arena e l'indice crescono
+    string_set big;
+    for (int i = 0; i < 5000; ++i)
+    {
+        big.add("key" + std::to_string(i));
+    }
+    for (int i = 0; i < 5000; i += 2)
+    {
+        big.remove("key" + std::to_string(i));
+    }
+    assert(big.size() == 2500);
+    assert(big.contains("key4999") && !big.contains("key4998"));
+    assert(big[0] == "key1");
+
+    // Dopo le rimozioni l'indice, ricostruito più piccolo, torna a crescere con le aggiunte
+    string_set regrown(big);
+    for (int i = 1; i < 5000; i += 2)
+    {
+        regrown.remove("key" + std::to_string(i));
+    }
+    for (int i = 0; i < 3000; ++i)
+    {
+        regrown.add("new" + std::to_string(i));
+    }
+    assert(regrown.size() == 3000 && regrown.contains("new0") && regrown.contains("new2999"));
+
+    // Costruzione da sequenza e filtraggio
+    std::vector<std::string> words = {"a", "abcd", "abcd", "xyzzy", "b"};
+    string_set from(words.begin(), words.end());
+    assert(from.size() == 4);
+    string_set longs = filter_out(from, [](std::string_view w) { return w.size() > 3; });
+    assert(longs.size() == 2 && longs.contains("abcd") && longs.contains("xyzzy"));
+
+    // Salvataggio e lettura, compatibili con il formato di set
+    save(big, "test_string_set.txt");
+    string_set loaded;
+    load("test_string_set.txt", loaded);
+    assert(loaded == big);
+    assert(loaded[0] == "key1");
+
+    set<std::string, std::equal_to<std::string>> plain;
+    load("test_string_set.txt", plain);
+    assert(plain.size() == 2500 && plain.contains("key1"));
+
+    save(plain, "test_string_set.txt");
+    load("test_string_set.txt", loaded);
+    assert(loaded == big);
+
+    // I duplicati nel file vengono scartati
+    {
+        std::ofstream dup("test_string_set.txt");
+        dup << "4\nx\ny\nx\nz";
+    }
+    load("test_string_set.txt", loaded);
+    assert(loaded.size() == 3 && loaded[2] == "z");
+    assert(loaded.arena_size() == 6);
+
+    // Un conteggio esagerato nell'intestazione non guida l'allocazione
+    {
+        std::ofstream huge("test_string_set.txt");
+        huge << "4000000000\nx\n";
+    }
+    bool exception_thrown = false;
+    try
+    {
+        load("test_string_set.txt", loaded);
+    }
+    catch (const std::runtime_error &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    // Stringhe che il formato a righe non può rappresentare
+    exception_thrown = false;
+    try
+    {
+        loaded.add("a\nb");
+    }
+    catch (const std::invalid_argument &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown);
+
+    exception_thrown = false;
+    try
+    {
+        loaded.add("a\r");
+    }
+    catch (const std::invalid_argument &)
+    {
+        exception_thrown = true;
+    }
+    assert(exception_thrown && !loaded.contains("a"));
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_similarity()
+{
+    std::cout << "[20] Test Similarity... ";
+
+    typedef set<int, std::equal_to<int>, std::hash<int>> hset;
+    typedef set<int, std::equal_to<int>> plain;
+
+    hset a, b, empty;
+    plain pa, pb;
+    for (int i = 0; i < 100; ++i)
+    {
+        a.add(i);
+        pa.add(i);
+    }
+    for (int i = 50; i < 200; ++i)
+    {
+        b.add(i);
+        pb.add(i);
+    }
+
+    // Risultati coerenti con operator- e operator+, con e senza funtore di hash
+    assert(intersection_size(a, b) == (a - b).size());
+    assert(intersection_size(pa, pb) == 50);
+    assert(union_size(a, b) == (a + b).size());
+    assert(union_size(pa, pb) == 200);
+    assert(jaccard(a, b) == 0.25);
+    assert(jaccard(pa, pb) == 0.25);
+    assert(jaccard(empty, empty) == 1.0);
+    assert(jaccard(a, empty) == 0.0);
+
+    // Inclusione e disgiunzione
+    hset sub = a - b;
+    assert(is_subset(sub, a) && is_subset(sub, b));
+    assert(!is_subset(a, b));
+    assert(is_subset(empty, a));
+    assert(!is_disjoint(a, b));
+    assert(is_disjoint(a, filter_out(b, [](int n) { return n >= 100; })));
+    assert(is_disjoint(empty, a));
+
+    plain small;
+    small.add(1);
+    small.add(150);
+    assert(!is_subset(small, pa) && !is_disjoint(small, pa));
+
+    // Firma MinHash: stima di Jaccard con errore ~ 1/sqrt(256)
+    minhash<int, std::hash<int>, 256> ma(a), mb(b), mempty;
+    assert(ma.similarity(ma) == 1.0);
+    assert(ma.similarity(mb) > 0.15 && ma.similarity(mb) < 0.35);
+    assert(mempty.similarity(mempty) == 1.0);
+    assert(ma.similarity(mempty) == 0.0);
+
+    minhash<int, std::hash<int>, 256> mu(ma);
+    mu.merge(mb);
+    assert((mu == minhash<int, std::hash<int>, 256>(a + b)));
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_hyperloglog()
+{
+    std::cout << "[21] Test HyperLogLog... ";
+
+    typedef hyperloglog<int, std::hash<int>> sketch;
+
+    sketch empty;
+    assert(empty.count() == 0);
+    assert(empty.bytes() == 8192);
+
+    // Cardinalità piccole: la stima è praticamente esatta
+    sketch small;
+    for (int i = 0; i < 10; ++i)
+    {
+        small.add(i);
+        small.add(i);
+    }
+    assert(small.count() == 10);
+
+    // Cardinalità grandi: errore entro 3 volte l'errore standard
+    sketch big;
+    for (int i = 0; i < 200000; ++i)
+    {
+        big.add(i % 100000);
+    }
+    const double relative = big.estimate() / 100000.0 - 1.0;
+    assert(relative < 3 * big.error() && relative > -3 * big.error());
+
+    // Unione di sketch costruiti in thread diversi
+    sketch part1, part2;
+    std::thread t1([&part1]() {
+        for (int i = 0; i < 60000; ++i)
+        {
+            part1.add(i);
+        }
+    });
+    std::thread t2([&part2]() {
+        for (int i = 40000; i < 100000; ++i)
+        {
+            part2.add(i);
+        }
+    });
+    t1.join();
+    t2.join();
+    part1.merge(part2);
+    assert(part1 == big);
+
+    bool thrown = false;
+    try
+    {
+        part1.merge(sketch(10));
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // Costruzione da set e da sequenza
+    set<int, std::equal_to<int>, std::hash<int>> s;
+    for (int i = 0; i < 500; ++i)
+    {
+        s.add(i * 7);
+    }
+    sketch from_set(s);
+    sketch from_range(s.begin(), s.end());
+    assert(from_set == from_range);
+    assert(from_set.count() > 480 && from_set.count() < 520);
+
+    // Salvataggio e lettura
+    save(big, "test_hyperloglog.bin");
+    sketch loaded(4);
+    load("test_hyperloglog.bin", loaded);
+    assert(loaded == big);
+    assert(loaded.precision() == sketch::DEFAULT_PRECISION);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_random_access()
+{
+    std::cout << "[22] Test Random Access... ";
+
+    set<int, std::equal_to<int>> s;
+    for (int i = 0; i < 10000; ++i)
+    {
+        s.add(i);
+    }
+
+    static_assert(std::contiguous_iterator<set<int, std::equal_to<int>>::const_iterator>);
+
+    // Aritmetica degli iteratori
+    set<int, std::equal_to<int>>::const_iterator b = s.begin(), e = s.end();
+    assert(e - b == 10000);
+    assert(*(b + 5) == 5 && b[7] == 7 && *(e - 1) == 9999);
+    assert(*(3 + b) == 3);
+    assert(b < e && e > b && b <= b && e >= b);
+    set<int, std::equal_to<int>>::const_iterator it = e;
+    --it;
+    it -= 9;
+    assert(*it == 9990);
+    it += 2;
+    assert(*it-- == 9992 && *it == 9991);
+    assert(std::distance(s.begin(), s.end()) == 10000);
+
+    // Accesso contiguo
+    assert(s.data() == &s[0]);
+    std::span<const int> view = s.as_span();
+    assert(view.size() == 10000 && view[42] == 42);
+    assert(&*s.begin() == s.data());
+
+    // Algoritmi della libreria standard
+    long long sum = 0;
+    std::for_each(s.begin(), s.end(), [&sum](int n) { sum += n; });
+    assert(sum == 49995000LL);
+
+    assert(std::count_if(s.begin(), s.end(), IsEven()) == 5000);
+    assert(std::count_if(s.begin(), s.end(), [](int n) { return n % 3 == 0; }) == 3334);
+    assert(std::reduce(s.begin(), s.end(), 0LL) == 49995000LL);
+
+    std::vector<int> sorted(s.begin(), s.end());
+    std::sort(sorted.begin(), sorted.end(), [](int x, int y) { return x > y; });
+    assert(sorted.front() == 9999 && sorted.back() == 0);
+
+#ifdef SET_PARALLEL_ALGORITHMS
+    // Algoritmi paralleli della libreria standard
+    std::atomic<long long> parallel_sum(0);
+    std::for_each(std::execution::par, s.begin(), s.end(), [&parallel_sum](int n) { parallel_sum += n; });
+    assert(parallel_sum == 49995000LL);
+
+    assert(std::count_if(std::execution::par, s.begin(), s.end(), IsEven()) == 5000);
+    assert(std::count_if(std::execution::par_unseq, s.begin(), s.end(), [](int n) { return n % 3 == 0; }) == 3334);
+    assert(std::reduce(std::execution::par, s.begin(), s.end(), 0LL) == 49995000LL);
+
+    std::vector<int> parallel_sorted(s.begin(), s.end());
+    std::sort(std::execution::par, parallel_sorted.begin(), parallel_sorted.end(), [](int x, int y) { return x > y; });
+    assert(parallel_sorted == sorted);
+#endif
+
+    set<int, std::equal_to<int>> empty;
+    assert(empty.begin() == empty.end() && empty.as_span().empty());
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_parallel_construction()
+{
+    std::cout << "[23] Test Parallel Construction... ";
+
+    typedef set<point, ArePointEqual, PointHash> pset;
+
+    // Molti duplicati: vince la prima occorrenza, nello stesso ordine del costruttore seriale
+    std::vector<point> points;
+    for (int i = 0; i < 20000; ++i)
+    {
+        points.push_back({(i * 7919) % 3001, i % 5});
+    }
+
+    pset serial(points.begin(), points.begin() + 2000);
+    pset parallel(points.begin(), points.begin() + 2000, 4);
+    assert(serial.size() == parallel.size());
+    for (unsigned int i = 0; i < serial.size(); ++i)
+    {
+        assert(ArePointEqual()(serial[i], parallel[i]));
+    }
+
+    pset all(points.begin(), points.end(), 3);
+    pset single(points.begin(), points.end(), 1);
+    assert(all.size() == single.size());
+    for (unsigned int i = 0; i < all.size(); ++i)
+    {
+        assert(ArePointEqual()(all[i], single[i]));
+    }
+    for (const point &p : points)
+    {
+        assert(all.contains(p));
+    }
+
+    // Conversione con cast statico, anche da iteratori non ad accesso casuale
+    std::vector<double> doubles = {1.5, 2.2, 1.9, 3.0, 2.7, 1.1};
+    set<int, std::equal_to<int>, std::hash<int>> converted(doubles.begin(), doubles.end(), 2);
+    assert(converted.size() == 3);
+    assert(converted[0] == 1 && converted[1] == 2 && converted[2] == 3);
+
+    std::list<double> list(doubles.begin(), doubles.end());
+    set<int, std::equal_to<int>, std::hash<int>> from_list(list.begin(), list.end(), 2);
+    assert(from_list == converted);
+
+    // Sequenza vuota e più thread che elementi
+    set<int, std::equal_to<int>, std::hash<int>> empty(doubles.begin(), doubles.begin(), 4);
+    assert(empty.size() == 0);
+    set<int, std::equal_to<int>, std::hash<int>> tiny(doubles.begin(), doubles.begin() + 1, 8);
+    assert(tiny.size() == 1 && tiny.contains(1));
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_set_reader()
+{
+    std::cout << "[24] Test Set Reader... ";
+
+    set<int, std::equal_to<int>> s;
+    for (int i = 0; i < 1000; ++i)
+    {
+        s.add(i * 3);
+    }
+    save(s, "test_reader_set.txt");
+
+    // Scansione con un algoritmo della libreria standard
+    {
+        set_reader<int> reader("test_reader_set.txt");
+        assert(reader.size() == 1000);
+        assert(std::count_if(reader.begin(), reader.end(), IsEven()) == 500);
+        assert(reader.begin() == reader.end());
+    }
+
+    // Costruzione di un set direttamente dal file
+    {
+        set_reader<int> reader("test_reader_set.txt");
+        set<int, std::equal_to<int>> loaded(reader.begin(), reader.end());
+        assert(loaded == s);
+        assert(loaded[0] == 0 && loaded[999] == 2997);
+    }
+
+    // Filtraggio senza caricare il file, anche a partire da metà
+    {
+        set_reader<int> reader("test_reader_set.txt");
+        set_reader<int>::iterator it = reader.begin();
+        assert(*it++ == 0);
+        assert(*it == 3);
+        set<int, std::equal_to<int>> evens = filter_out<std::equal_to<int>>(reader, IsEven());
+        assert(evens.size() == 499);
+        assert(!evens.contains(0) && evens.contains(6) && !evens.contains(3));
+    }
+
+    // Stringhe, con il formato di save per set di stringhe
+    set<std::string, std::equal_to<std::string>> words;
+    words.add("alpha");
+    words.add("be");
+    words.add("gamma");
+    save(words, "test_reader_set.txt");
+    {
+        set_reader<std::string> reader("test_reader_set.txt");
+        set<std::string, std::equal_to<std::string>> longs = filter_out<std::equal_to<std::string>>(reader, IsLongString());
+        assert(longs.size() == 2 && longs.contains("gamma"));
+    }
+
+    // File troncato
+    {
+        std::ofstream ofs("test_reader_set.txt");
+        ofs << "5\n1\n2\n";
+    }
+    bool thrown = false;
+    try
+    {
+        set_reader<int> reader("test_reader_set.txt");
+        set<int, std::equal_to<int>> partial(reader.begin(), reader.end());
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_adaptive_layout()
+{
+    std::cout << "[25] Test Adaptive Layout... ";
+
+    typedef set<int, std::equal_to<int>, std::hash<int>> hset;
+    assert(hset::index_threshold() == 8);
+
+    // Promozione oltre la soglia, senza cambiare ordine e accesso
+    hset s;
+    for (int i = 0; i < 8; ++i)
+    {
+        s.add(i * 10);
+    }
+    assert(!s.has_index());
+    s.add(80);
+    assert(s.has_index());
+    for (int i = 0; i < 100; ++i)
+    {
+        s.add(i * 10);
+    }
+    assert(s.size() == 100);
+    assert(s[0] == 0 && s[99] == 990);
+    assert(s.contains(500) && !s.contains(505));
+
+    // Le copie condividono l'indice, le modifiche no
+    hset copy(s);
+    copy.add(-1);
+    copy.remove(0);
+    assert(copy.contains(-1) && !copy.contains(0));
+    assert(!s.contains(-1) && s.contains(0));
+    assert(copy.has_index() && s.has_index());
+
+    // Dopo una rimozione le posizioni cambiano: l'indice viene ricostruito
+    for (int i = 0; i < 50; ++i)
+    {
+        s.remove(i * 10);
+    }
+    assert(s[0] == 500);
+    for (int i = 50; i < 100; ++i)
+    {
+        assert(s.contains(i * 10));
+    }
+
+    // Retrocessione sotto metà soglia
+    for (int i = 50; i < 96; ++i)
+    {
+        s.remove(i * 10);
+    }
+    assert(s.size() == 4 && !s.has_index());
+    assert(s.contains(990) && !s.contains(950));
+
+    // Spazio riservato e unione passano da append
+    hset r;
+    r.reserve(50);
+    for (int i = 0; i < 50; ++i)
+    {
+        r.add(i);
+    }
+    assert(r.has_index() && r.contains(49) && !r.contains(50));
+    assert((r + copy).contains(-1) && (r + copy).has_index());
+
+    // Salvataggio, lettura e costruzione parallela
+    save(r, "test_adaptive_set.txt");
+    hset loaded;
+    load("test_adaptive_set.txt", loaded);
+    assert(loaded == r && loaded.has_index());
+    std::vector<int> values(200, 7);
+    values.push_back(8);
+    for (int i = 0; i < 40; ++i)
+    {
+        values.push_back(i);
+    }
+    hset parallel(values.begin(), values.end(), 3);
+    assert(parallel.size() == 40 && parallel[0] == 7 && parallel.has_index() && parallel.contains(39));
+
+    // Soglia regolabile
+    hset::set_index_threshold(0xFFFFFFFFu);
+    hset flat;
+    for (int i = 0; i < 100; ++i)
+    {
+        flat.add(i);
+    }
+    assert(!flat.has_index() && flat.contains(99));
+    hset::set_index_threshold(8);
+
+    // Senza funtore di hash la rappresentazione resta l'array
+    set<int, std::equal_to<int>> plain;
+    for (int i = 0; i < 100; ++i)
+    {
+        plain.add(i);
+    }
+    assert(!plain.has_index() && plain.contains(99));
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_relocation()
+{
+    std::cout << "[26] Test Relocation... ";
+
+    typedef set<Tracked, std::equal_to<Tracked>> tset;
+    static_assert(is_trivially_relocatable<int>::value, "int is trivially relocatable");
+    static_assert(!is_trivially_relocatable<Tracked>::value, "Tracked is not trivially relocatable");
+
+    {
+        // Le celle riservate non vengono costruite
+        tset s;
+        s.reserve(100);
+        assert(s.capacity() == 100 && Tracked::alive == 0 && Tracked::defaults == 0);
+        for (int i = 0; i < 50; ++i)
+        {
+            s.add(Tracked(i));
+        }
+        assert(Tracked::alive == 50 && Tracked::defaults == 0);
+
+        // Crescita e rimozione su un array privato spostano gli elementi mantenendo l'ordine
+        for (int i = 50; i < 60; ++i)
+        {
+            s.add(Tracked(i));
+        }
+        s.remove(Tracked(10));
+        assert(s.size() == 59 && s.capacity() == 59 && Tracked::alive == 59);
+        assert(s[9].value == 9 && s[10].value == 11 && s[58].value == 59);
+
+        // Una copia fallita lascia entrambi i set invariati e non perde istanze
+        tset copy(s);
+        Tracked::copies_left = 10;
+        bool thrown = false;
+        try
+        {
+            copy.add(Tracked(1000));
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        Tracked::copies_left = -1;
+        assert(thrown && copy == s && &copy[0] == &s[0] && Tracked::alive == 59);
+
+        copy.remove(Tracked(0));
+        assert(copy.size() == 58 && s.size() == 59 && s[0].value == 0 && Tracked::alive == 59 + 58);
+
+        // Un errore nella costruzione dell'ultimo elemento non cambia gli elementi
+        tset small;
+        small.add(Tracked(1));
+        Tracked::copies_left = 0;
+        thrown = false;
+        try
+        {
+            small.add(Tracked(2));
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        Tracked::copies_left = -1;
+        assert(thrown && small.size() == 1 && small[0].value == 1 && Tracked::alive == 59 + 58 + 1);
+
+        small.remove(Tracked(1));
+        assert(small.size() == 0 && Tracked::alive == 59 + 58);
+    }
+    assert(Tracked::alive == 0 && Tracked::defaults == 0);
+
+    // Tipi banalmente copiabili: realloc e memmove
+    set<int, std::equal_to<int>> n;
+    n.reserve(10);
+    const int *before = n.data();
+    for (int i = 0; i < 10; ++i)
+    {
+        n.add(i);
+    }
+    assert(n.data() == before);
+    n.remove(3);
+    assert(n.size() == 9 && n.capacity() == 9);
+    assert(n[2] == 2 && n[3] == 4 && n[8] == 9);
+    for (int i = 10; i < 1000; ++i)
+    {
+        n.add(i);
+    }
+    assert(n.size() == 999 && n[998] == 999);
+    while (n.size() > 0)
+    {
+        n.remove(n[n.size() / 2]);
+    }
+    assert(n.capacity() == 0);
+
+    // Costruzione parallela con elementi non banali
+    std::vector<Tracked> values;
+    for (int i = 0; i < 300; ++i)
+    {
+        values.push_back(Tracked(i % 100));
+    }
+    {
+        set<Tracked, std::equal_to<Tracked>, TrackedHash> parallel(values.begin(), values.end(), 3);
+        assert(parallel.size() == 100 && parallel[99].value == 99);
+    }
+    values.clear();
+    assert(Tracked::alive == 0);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_batch_membership()
+{
+    std::cout << "[27] Test Batch Membership... ";
+
+    // Array senza hash: più blocchi, risultati uguali a contains
+    set<int, std::equal_to<int>> plain;
+    for (int i = 0; i < 10000; i += 2)
+    {
+        plain.add(i);
+    }
+    std::vector<int> queries;
+    for (int i = -50; i < 10050; i += 7)
+    {
+        queries.push_back(i);
+    }
+    std::vector<bool> found;
+    plain.contains_many(queries.begin(), queries.end(), std::back_inserter(found));
+    assert(found.size() == queries.size());
+    for (std::size_t i = 0; i < queries.size(); ++i)
+    {
+        assert(found[i] == plain.contains(queries[i]));
+    }
+
+    // Maschera di bit
+    std::vector<std::uint64_t> mask((queries.size() + 63) / 64, ~std::uint64_t(0));
+    unsigned int hits = plain.contains_many(queries.begin(), queries.end(), mask.data());
+    unsigned int expected = 0;
+    for (std::size_t i = 0; i < queries.size(); ++i)
+    {
+        assert(((mask[i / 64] >> (i % 64)) & 1) == (plain.contains(queries[i]) ? 1u : 0u));
+        expected += plain.contains(queries[i]) ? 1 : 0;
+    }
+    assert(hits == expected);
+    assert((mask.back() >> (queries.size() % 64)) == 0);
+
+    // Sequenze di input e tipi convertibili
+    std::istringstream iss("4 5 6");
+    bool in[3];
+    plain.contains_many(std::istream_iterator<int>(iss), std::istream_iterator<int>(), in);
+    assert(in[0] && !in[1] && in[2]);
+    std::vector<long> wide = {8, 9};
+    bool conv[2];
+    plain.contains_many(wide.begin(), wide.end(), conv);
+    assert(conv[0] && !conv[1]);
+
+    // Stringhe con filtro di Bloom e con indice hash
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> words;
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>>::set_index_threshold(0xFFFFFFFFu);
+    words.enable_filter();
+    for (int i = 0; i < 500; ++i)
+    {
+        words.add("w" + std::to_string(i));
+    }
+    std::vector<std::string> probes = {"w0", "w499", "w500", "x", "w250"};
+    bool filtered[5];
+    words.contains_many(probes.begin(), probes.end(), filtered);
+    assert(filtered[0] && filtered[1] && !filtered[2] && !filtered[3] && filtered[4]);
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>>::set_index_threshold(8);
+
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> indexed(words);
+    indexed.add("extra");
+    assert(indexed.has_index());
+    bool direct[5];
+    indexed.contains_many(probes.begin(), probes.end(), direct);
+    assert(std::equal(direct, direct + 5, filtered));
+
+    // add_many: presenti, nuovi e ripetuti nel lotto
+    std::vector<std::string> batch = {"w1", "new1", "new2", "new1", "extra", "new3"};
+    std::vector<bool> added;
+    indexed.add_many(batch.begin(), batch.end(), std::back_inserter(added));
+    assert((added == std::vector<bool>{false, true, true, false, false, true}));
+    assert(indexed.size() == 504 && indexed.contains("new2") && indexed.contains("new3"));
+    assert(words.size() == 500 && !words.contains("new1"));
+
+    // add_many senza hash e su un set condiviso
+    set<int, std::equal_to<int>> small;
+    small.add(1);
+    set<int, std::equal_to<int>> shared(small);
+    std::vector<int> values = {1, 2, 3, 2, 4};
+    std::uint64_t bits = 0;
+    assert(shared.add_many(values.begin(), values.end(), &bits) == 3);
+    assert(bits == 0x16);
+    assert(shared.size() == 4 && shared.capacity() == 4 && small.size() == 1);
+    assert(shared[1] == 2 && shared[3] == 4);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_hash_cache()
+{
+    std::cout << "[28] Test Hash Cache... ";
+
+    typedef set<std::string, CountingEql, CountingHash> counted;
+    counted::set_index_threshold(0xFFFFFFFFu);
+
+    counted plain, cached;
+    cached.enable_hash_cache();
+    assert(cached.has_hash_cache() && !plain.has_hash_cache());
+    for (int i = 0; i < 200; ++i)
+    {
+        plain.add("key_" + std::to_string(i));
+        cached.add("key_" + std::to_string(i));
+    }
+
+    // Ricerca senza indice: con la cache Eql viene chiamato solo sull'elemento con lo stesso hash
+    CountingEql::calls = 0;
+    assert(!plain.contains("missing"));
+    assert(CountingEql::calls == 200);
+    CountingEql::calls = 0;
+    CountingHash::calls = 0;
+    assert(!cached.contains("missing") && cached.contains("key_150"));
+    assert(CountingEql::calls == 1 && CountingHash::calls == 2);
+
+    // Aggiunta: un solo hash per la ricerca e la memorizzazione
+    CountingHash::calls = 0;
+    cached.add("key_200");
+    cached.add("key_0");
+    assert(CountingHash::calls == 2 && cached.size() == 201);
+
+    // Ricerche a lotti
+    std::vector<std::string> probes = {"key_3", "nope", "key_200"};
+    bool found[3];
+    CountingEql::calls = 0;
+    cached.contains_many(probes.begin(), probes.end(), found);
+    assert(found[0] && !found[1] && found[2] && CountingEql::calls == 2);
+
+    // Copy-on-write e rimozione: la copia condivide la cache, poi la duplica
+    counted copy(cached);
+    assert(copy.has_hash_cache());
+    copy.remove("key_10");
+    copy.remove("key_200");
+    assert(copy.size() == 199 && !copy.contains("key_10") && copy.contains("key_11") && copy.contains("key_199"));
+    assert(cached.size() == 201 && cached.contains("key_10") && cached.contains("key_200"));
+    for (unsigned int i = 0; i < copy.size(); ++i)
+    {
+        assert(copy.contains(copy[i]));
+    }
+
+    // Creazione dell'indice e rimozioni con indice: gli hash memorizzati non vengono ricalcolati
+    counted::set_index_threshold(8);
+    CountingHash::calls = 0;
+    cached.add("key_201");
+    assert(cached.has_index() && CountingHash::calls == 1);
+    CountingHash::calls = 0;
+    cached.remove("key_5");
+    assert(CountingHash::calls == 1 && !cached.contains("key_5") && cached.contains("key_201"));
+    counted::set_index_threshold(0xFFFFFFFFu);
+
+    // Uguaglianza: set con hash diversi vengono scartati senza confronti
+    counted a, b;
+    a.enable_hash_cache();
+    b.enable_hash_cache();
+    for (int i = 0; i < 50; ++i)
+    {
+        a.add("v" + std::to_string(i));
+        b.add("v" + std::to_string(49 - i));
+    }
+    CountingEql::calls = 0;
+    CountingHash::calls = 0;
+    assert(a == b);
+    assert(CountingEql::calls == 50 && CountingHash::calls == 0);
+    b.remove("v7");
+    b.add("w7");
+    CountingEql::calls = 0;
+    assert(!(a == b));
+    assert(CountingEql::calls == 0);
+
+    // Intersezione e unione riusano gli hash memorizzati
+    counted c;
+    c.enable_hash_cache();
+    for (int i = 40; i < 60; ++i)
+    {
+        c.add("v" + std::to_string(i));
+    }
+    CountingHash::calls = 0;
+    counted common = a - c;
+    counted all = a + c;
+    assert(CountingHash::calls == 0);
+    assert(common.size() == 10 && common.has_hash_cache() && common.contains("v45") && !common.contains("v39"));
+    assert(all.size() == 60 && all.has_hash_cache() && all.contains("v0") && all.contains("v59"));
+    assert(all - c == c && (a + c) == all);
+
+    // Disabilitazione: le ricerche continuano a funzionare
+    counted before(all);
+    all.disable_hash_cache();
+    assert(!all.has_hash_cache() && before.has_hash_cache());
+    assert(all.contains("v30") && !all.contains("v60") && all == before);
+
+    counted::set_index_threshold(8);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_parallel_io()
+{
+    std::cout << "[29] Test Parallel IO... ";
+
+    // Punti: stesso file di save con qualsiasi numero di thread
+    set<point, ArePointEqual, PointHash> points;
+    for (int i = 0; i < 40000; ++i)
+    {
+        points.add(point{i, -3 * i});
+    }
+    save(points, "test_parallel_expected.txt");
+    std::ifstream expected("test_parallel_expected.txt");
+    std::stringstream reference;
+    reference << expected.rdbuf();
+    expected.close();
+
+    for (unsigned int threads : {1u, 3u})
+    {
+        save_parallel(points, "test_parallel_set.txt", threads);
+        std::ifstream written("test_parallel_set.txt");
+        std::stringstream content;
+        content << written.rdbuf();
+        written.close();
+        assert(content.str() == reference.str());
+
+        set<point, ArePointEqual, PointHash> loaded;
+        loaded.enable_filter();
+        load_parallel("test_parallel_set.txt", loaded, threads + 1);
+        assert(loaded.size() == points.size() && loaded.has_filter());
+        for (unsigned int i = 0; i < loaded.size(); ++i)
+        {
+            assert(ArePointEqual()(loaded[i], points[i]));
+        }
+    }
+
+    // Interi: file più grande di un blocco di lettura per thread
+    set<int, std::equal_to<int>, std::hash<int>> numbers;
+    for (int i = 0; i < 200000; ++i)
+    {
+        numbers.add(i * 7 - 300000);
+    }
+    save_parallel(numbers, "test_parallel_set.txt", 2);
+    set<int, std::equal_to<int>, std::hash<int>> single, multi;
+    load_parallel("test_parallel_set.txt", single, 1);
+    load_parallel("test_parallel_set.txt", multi, 4);
+    assert(single.size() == numbers.size() && multi.size() == numbers.size());
+    for (unsigned int i = 0; i < numbers.size(); i += 997)
+    {
+        assert(single[i] == numbers[i] && multi[i] == numbers[i]);
+    }
+
+    // Elementi ripetuti in porzioni diverse e righe oltre la lunghezza dichiarata
+    std::ofstream repeated("test_parallel_set.txt");
+    repeated << "7\n3\n1\n3\n2\n1\n5\n3\n9\n";
+    repeated.close();
+    set<int, std::equal_to<int>> small;
+    load_parallel("test_parallel_set.txt", small, 3);
+    set<int, std::equal_to<int>> sequential;
+    load("test_parallel_set.txt", sequential);
+    assert(small.size() == 4 && small == sequential);
+    assert(small[0] == 3 && small[1] == 1 && small[2] == 2 && small[3] == 5);
+
+    // File troncato o non valido: il set rimane invariato
+    std::ofstream truncated("test_parallel_set.txt");
+    truncated << "5\n1\n2\n";
+    truncated.close();
+    bool thrown = false;
+    try
+    {
+        load_parallel("test_parallel_set.txt", small, 2);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown && small.size() == 4);
+
+    std::ofstream invalid("test_parallel_set.txt");
+    invalid << "3\n1\nx\n2\n";
+    invalid.close();
+    thrown = false;
+    try
+    {
+        load_parallel("test_parallel_set.txt", small, 2);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown && small.size() == 4);
+
+    std::remove("test_parallel_expected.txt");
+    std::remove("test_parallel_set.txt");
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_memory_usage()
+{
+    std::cout << "[30] Test Memory Usage... ";
+
+    // Interi: elementi, celle libere e compattazione
+    set<int, std::equal_to<int>> numbers;
+    numbers.reserve(100);
+    for (int i = 0; i < 10; ++i)
+    {
+        numbers.add(i);
+    }
+    memory_footprint m = numbers.memory_usage();
+    assert(m.sets == 1 && m.elements == 10 * sizeof(int) && m.slack == 90 * sizeof(int));
+    assert(m.index == 0 && m.heap == 0 && m.metadata >= sizeof(numbers));
+    assert(m.total() == m.elements + m.slack + m.index + m.metadata + m.heap);
+    numbers.compact();
+    assert(numbers.capacity() == 10 && numbers.memory_usage().slack == 0);
+    assert(numbers.size() == 10 && numbers[0] == 0 && numbers[9] == 9);
+
+    // Stringhe: memoria dinamica solo per quelle lunghe, stimatore personalizzato
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> words;
+    words.add("a");
+    words.add(std::string(100, 'x'));
+    assert(words.memory_usage().heap >= 101);
+    assert(words.memory_usage([](const std::string &s) { return static_cast<unsigned long long>(s.size()); }).heap == 101);
+
+    // Indice, filtro e cache contati tra le strutture di ricerca; compact li ridimensiona
+    for (int i = 0; i < 300; ++i)
+    {
+        words.add("word_number_" + std::to_string(i) + "_with_a_long_suffix");
+    }
+    words.enable_filter();
+    words.enable_hash_cache();
+    for (int i = 0; i < 250; ++i)
+    {
+        words.remove("word_number_" + std::to_string(i) + "_with_a_long_suffix");
+    }
+    words.reserve(500);
+    assert(words.has_index());
+    const memory_footprint loose = words.memory_usage();
+    assert(loose.index > 0 && loose.slack > 0);
+
+    const std::vector<std::string> expected(words.begin(), words.end());
+    words.compact();
+    assert(words.capacity() == words.size() && words.size() == 52);
+    const memory_footprint tight = words.memory_usage();
+    assert(tight.slack == 0 && tight.index < loose.index && tight.total() < loose.total());
+    assert(words.has_filter() && words.has_hash_cache() && words.has_index());
+    for (unsigned int i = 0; i < expected.size(); ++i)
+    {
+        assert(words[i] == expected[i] && words.contains(expected[i]));
+    }
+    words.add("after_compact");
+    assert(words.contains("after_compact") && words.size() == 53);
+
+    // Memoria condivisa contata una volta; compact non la duplica
+    set<std::string, std::equal_to<std::string>, std::hash<std::string>> copy(words), other;
+    other.add("other");
+    const unsigned int shared_capacity = copy.capacity();
+    copy.compact();
+    assert(copy.capacity() == shared_capacity);
+    std::vector<set<std::string, std::equal_to<std::string>, std::hash<std::string>>> many = {words, copy, other};
+    const memory_footprint report = memory_report(many.begin(), many.end());
+    const memory_footprint single = words.memory_usage();
+    const memory_footprint alone = other.memory_usage();
+    assert(report.sets == 3);
+    assert(report.elements == single.elements + alone.elements);
+    assert(report.heap == single.heap + alone.heap);
+    assert(report.metadata == single.metadata + alone.metadata + sizeof(words));
+    memory_footprint sum = single;
+    sum += alone;
+    assert(sum.sets == 2 && sum.total() + sizeof(words) == report.total());
+
+    std::ostringstream oss;
+    oss << report;
+    assert(oss.str().find("sets=3") == 0);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_external_set()
+{
+    std::cout << "[31] Test External Set... ";
+
+    const std::string dir = "test_external_tmp";
+    std::filesystem::remove_all(dir);
+
+    {
+        // Punti con filtro: molte scritture su disco e fusioni, con duplicati tra buffer e run
+        external_set<point, PointLess, PointHash> points(dir, 64 * sizeof(point));
+        for (int round = 0; round < 3; ++round)
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                points.add(point{i % 100, i / 100});
+            }
+        }
+        points.wait();
+        assert(points.runs() > 0 && points.runs() < 3 * 1000 / 64);
+        assert(points.buffered() < 64);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            assert(points.contains(point{i % 100, i / 100}));
+        }
+        assert(!points.contains(point{100, 0}) && !points.contains(point{-1, 5}) && !points.contains(point{5, 10}));
+
+        std::vector<point> sorted(points.begin(), points.end());
+        assert(sorted.size() == 1000);
+        for (unsigned int i = 1; i < sorted.size(); ++i)
+        {
+            assert(PointLess()(sorted[i - 1], sorted[i]));
+        }
+
+        // Le run hanno il formato di save
+        set<point, ArePointEqual> loaded;
+        load((std::filesystem::directory_iterator(dir)->path()).string(), loaded);
+        assert(loaded.size() > 0 && points.contains(loaded[0]));
+
+        // Interi senza hash: unione e intersezione in streaming
+        external_set<int> evens(dir, 50 * sizeof(int)), thirds(dir, 50 * sizeof(int));
+        for (int i = 0; i < 600; i += 2)
+        {
+            evens.add(i);
+        }
+        for (int i = 0; i < 600; i += 3)
+        {
+            thirds.add(i);
+        }
+
+        external_set<int> both(dir), either(dir);
+        either.add(1000);
+        external_set<int>::intersect(evens, thirds, both);
+        external_set<int>::unite(evens, thirds, either);
+        both.wait();
+        either.wait();
+
+        std::vector<int> common(both.begin(), both.end());
+        assert(common.size() == 100);
+        for (unsigned int i = 0; i < common.size(); ++i)
+        {
+            assert(common[i] == 6 * static_cast<int>(i));
+        }
+
+        int count = 0, previous = -1;
+        for (external_set<int>::const_iterator it = either.begin(); it != either.end(); ++it)
+        {
+            assert(*it > previous && (*it % 2 == 0 || *it % 3 == 0 || *it == 1000));
+            previous = *it;
+            ++count;
+        }
+        assert(count == 300 + 200 - 100 + 1);
+        assert(either.contains(597) && either.contains(1000) && !either.contains(1));
+
+        // Un'iterazione già iniziata non vede le aggiunte successive
+        external_set<int>::const_iterator it = evens.begin();
+        evens.add(-2);
+        evens.flush();
+        assert(*it == 0);
+        assert(*evens.begin() == -2);
+    }
+
+    // Alla distruzione le run vengono cancellate
+    assert(std::filesystem::is_empty(dir));
+    std::filesystem::remove_all(dir);
+
+    bool thrown = false;
+    try
+    {
+        external_set<int> invalid(dir, 0);
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_shared_set()
+{
+    std::cout << "[32] Test Shared Set... ";
+
+    const std::string name = "/set_test_shared_" + std::to_string(getpid());
+    shared_set<point, ArePointEqual, PointHash>::destroy(name);
+
+    set<point, ArePointEqual, PointHash> points;
+    points.reserve(1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        points.add(point{i, i % 7});
+    }
+
+    // Prima della pubblicazione non ci si può collegare
+    bool thrown = false;
+    try
+    {
+        shared_set<point, ArePointEqual, PointHash> missing(name);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    assert((shared_set<point, ArePointEqual, PointHash>::publish(name, points)) == 1);
+    shared_set<point, ArePointEqual, PointHash> reader(name);
+    assert(reader.version() == 1 && reader.size() == 1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        assert(reader.contains(point{i, i % 7}));
+        assert(ArePointEqual()(reader[i], points[i]));
+    }
+    assert(!reader.contains(point{1000, 0}) && !reader.contains(point{3, 4}));
+
+    // Un altro processo legge la stessa memoria
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        shared_set<point, ArePointEqual, PointHash> other(name);
+        const bool ok = other.size() == 1000 && other.contains(point{999, 999 % 7}) && !other.contains(point{-1, 0});
+        _exit(ok ? 0 : 1);
+    }
+    int status = -1;
+    assert(child > 0 && waitpid(child, &status, 0) == child);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    set<point, ArePointEqual, PointHash> evens = filter_out(reader, [](const point &p) { return p.x % 2 == 0; });
+    assert(evens.size() == 500 && evens.contains(point{998, 998 % 7}) && !evens.contains(point{1, 1}));
+
+    std::ostringstream oss;
+    oss << reader;
+    assert(oss.str().find("{") == 0);
+
+    // Una nuova versione non cambia i collegamenti esistenti fino a refresh
+    set<point, ArePointEqual, PointHash> fewer = filter_out(points, [](const point &p) { return p.x < 10; });
+    assert((shared_set<point, ArePointEqual, PointHash>::publish(name, fewer)) == 2);
+    assert(reader.version() == 1 && reader.size() == 1000 && reader.contains(point{500, 500 % 7}));
+    shared_set<point, ArePointEqual, PointHash> late(name);
+    assert(late.version() == 2 && late.size() == 10);
+    assert(reader.refresh() && reader.version() == 2 && reader.size() == 10);
+    assert(!reader.contains(point{500, 500 % 7}) && reader.contains(point{9, 2}));
+    assert(!reader.refresh());
+
+    // Senza funtore di hash la ricerca è lineare
+    const std::string numbers_name = name + "_numbers";
+    set<int, std::equal_to<int>> numbers;
+    numbers.add(3);
+    numbers.add(5);
+    shared_set<int, std::equal_to<int>>::publish(numbers_name, numbers);
+    shared_set<int, std::equal_to<int>> shared_numbers(numbers_name);
+    assert(shared_numbers.contains(5) && !shared_numbers.contains(4));
+
+    // Un tipo di elemento diverso viene rifiutato
+    thrown = false;
+    try
+    {
+        shared_set<point, ArePointEqual> wrong(numbers_name);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    shared_set<int, std::equal_to<int>>::destroy(numbers_name);
+    shared_set<point, ArePointEqual, PointHash>::destroy(name);
+    assert(reader.size() == 10 && reader.contains(point{9, 2}));
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_view_set()
+{
+    std::cout << "[33] Test View Set... ";
+
+    // Record con chiave id e un contenuto grande da non copiare
+    struct record
+    {
+        int id;
+        std::string payload;
+    };
+    struct record_id
+    {
+        int operator()(const record &r) const
+        {
+            return r.id;
+        }
+    };
+    struct same_record
+    {
+        bool operator()(const record &a, const record &b) const
+        {
+            return a.id == b.id;
+        }
+    };
+
+    std::vector<record> records;
+    for (int i = 0; i < 300; ++i)
+    {
+        records.push_back(record{i % 100, std::string(64, static_cast<char>('a' + i % 26))});
+    }
+
+    view_set<record, record_id, std::equal_to<int>, std::hash<int>> unique(records);
+    unique.add_all();
+    assert(unique.size() == 100);
+    for (unsigned int i = 0; i < unique.size(); ++i)
+    {
+        // Resta il primo record per ogni chiave, senza copie
+        assert(unique.position(i) == i && &unique[i] == &records[i]);
+    }
+    assert(unique.contains(record{42, ""}) && unique.contains_key(99) && !unique.contains_key(100));
+    assert(!unique.add(150) && unique.size() == 100);
+
+    bool thrown = false;
+    try
+    {
+        unique.add(300);
+    }
+    catch (const std::out_of_range &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    int visited = 0;
+    for (view_set<record, record_id, std::equal_to<int>, std::hash<int>>::const_iterator it = unique.begin(); it != unique.end(); ++it)
+    {
+        assert(it->id == visited++);
+    }
+    assert(visited == 100);
+
+    // Con una proiezione che ritorna una reference i confronti nell'indice non copiano gli elementi
+    struct counted
+    {
+        int id;
+        int *copies;
+        counted(int i, int *c) : id(i), copies(c) {}
+        counted(const counted &other) : id(other.id), copies(other.copies) { ++*copies; }
+    };
+    struct same_counted
+    {
+        bool operator()(const counted &a, const counted &b) const { return a.id == b.id; }
+    };
+    struct counted_hash
+    {
+        std::size_t operator()(const counted &c) const { return std::hash<int>()(c.id); }
+    };
+    int copies = 0;
+    std::vector<counted> items;
+    items.reserve(200);
+    for (int i = 0; i < 200; ++i)
+    {
+        items.emplace_back(i % 50, &copies);
+    }
+    copies = 0;
+    view_set<counted, std::identity, same_counted, counted_hash> identities(items);
+    identities.add_all();
+    assert(identities.size() == 50 && identities.contains(items[120]));
+    assert(copies == 0);
+
+    // Operazioni insiemistiche sullo stesso array
+    view_set<record, record_id, std::equal_to<int>, std::hash<int>> evens = filter_out(unique, [](const record &r) { return r.id % 2 == 0; });
+    view_set<record, record_id, std::equal_to<int>, std::hash<int>> low(records);
+    for (unsigned int i = 0; i < 30; ++i)
+    {
+        low.add(i);
+    }
+    assert(evens.size() == 50 && (evens - low).size() == 15 && (evens + low).size() == 65);
+    assert((evens - low).contains_key(28) && !(evens - low).contains_key(29));
+
+    std::vector<record> others(records.begin(), records.begin() + 10);
+    view_set<record, record_id, std::equal_to<int>, std::hash<int>> elsewhere(others);
+    thrown = false;
+    try
+    {
+        evens += elsewhere;
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    assert(thrown && evens.size() == 50);
+
+    // Copia in un set indipendente dall'array
+    set<record, same_record> copy = evens.materialize<same_record>();
+    assert(copy.size() == 50 && copy[0].id == 0 && copy[49].id == 98 && copy[1].payload == records[2].payload);
+
+    // Senza funtore di hash la ricerca è lineare
+    std::vector<int> numbers = {5, 3, 5, 1, 3};
+    view_set<int, std::identity, std::equal_to<int>> distinct(numbers);
+    distinct.add_all();
+    assert(distinct.size() == 3 && distinct.contains(1) && !distinct.contains(2));
+
+    std::ostringstream oss;
+    oss << distinct;
+    assert(oss.str() == "{5, 3, 1}");
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_sorted_files()
+{
+    std::cout << "[34] Test Sorted Files... ";
+
+    const std::string dir = "test_sorted_tmp";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // Ieri i multipli di 2, oggi i multipli di 3, salvati in ordine sparso
+    set<int, std::equal_to<int>> yesterday, today;
+    yesterday.reserve(1000);
+    today.reserve(667);
+    for (int i = 0; i < 2000; ++i)
+    {
+        const int n = (i * 7919) % 2000;
+        if (n % 2 == 0)
+        {
+            yesterday.add(n);
+        }
+        if (n % 3 == 0)
+        {
+            today.add(n);
+        }
+    }
+    save(yesterday, "test_sorted_yesterday.txt");
+    save(today, "test_sorted_today.txt");
+    assert(!is_sorted_file<int>("test_sorted_yesterday.txt"));
+
+    // Blocchi da 16 elementi: 63 file temporanei, fusi in due passate
+    assert(sort_file<int>("test_sorted_yesterday.txt", "test_sorted_sorted.txt", 16 * sizeof(int), dir) == 1000);
+    assert(is_sorted_file<int>("test_sorted_sorted.txt"));
+    set<int, std::equal_to<int>> sorted;
+    load("test_sorted_sorted.txt", sorted);
+    assert(sorted.size() == 1000 && sorted[0] == 0 && sorted[999] == 1998 && yesterday == sorted);
+
+    const file_diff diff = diff_files<int>("test_sorted_yesterday.txt", "test_sorted_today.txt", "test_sorted_added.txt",
+                                           "test_sorted_removed.txt", 16 * sizeof(int), dir);
+    assert(diff.added == 333 && diff.removed == 666);
+    set<int, std::equal_to<int>> added, removed;
+    load("test_sorted_added.txt", added);
+    load("test_sorted_removed.txt", removed);
+    assert(added.size() == 333 && removed.size() == 666);
+    for (unsigned int i = 0; i < added.size(); ++i)
+    {
+        assert(added[i] % 3 == 0 && added[i] % 2 != 0 && (i == 0 || added[i - 1] < added[i]));
+    }
+    for (unsigned int i = 0; i < removed.size(); ++i)
+    {
+        assert(removed[i] % 2 == 0 && removed[i] % 3 != 0);
+    }
+
+    // Da file già ordinati il risultato è lo stesso; l'unione non cancella gli input
+    const file_diff same = diff_files<int>("test_sorted_sorted.txt", "test_sorted_today.txt", "test_sorted_added.txt",
+                                           "test_sorted_removed.txt", 16 * sizeof(int), dir);
+    assert(same.added == diff.added && same.removed == diff.removed);
+
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 20; ++i)
+    {
+        inputs.push_back("test_sorted_sorted.txt");
+    }
+    inputs.push_back("test_sorted_today.txt");
+    assert(merge_files<int>(inputs, "test_sorted_union.txt", 16 * sizeof(int), dir) == 1000 + 333);
+    assert(is_sorted_file<int>("test_sorted_sorted.txt"));
+    set<int, std::equal_to<int>> all;
+    load("test_sorted_union.txt", all);
+    assert(all.size() == 1333 && all == yesterday + today);
+
+    // Punti con un funtore di ordinamento
+    set<point, ArePointEqual> points;
+    for (int i = 0; i < 50; ++i)
+    {
+        points.add(point{49 - i, i % 3});
+    }
+    save(points, "test_sorted_points.txt");
+    assert((sort_file<point, PointLess>("test_sorted_points.txt", "test_sorted_points_sorted.txt", 8 * sizeof(point), dir)) == 50);
+    assert((is_sorted_file<point, PointLess>("test_sorted_points_sorted.txt")));
+
+    assert(std::filesystem::is_empty(dir));
+    std::filesystem::remove_all(dir);
+    for (const char *name : {"yesterday", "today", "sorted", "added", "removed", "union", "points", "points_sorted"})
+    {
+        std::remove(("test_sorted_" + std::string(name) + ".txt").c_str());
+    }
+
+    std::cout << "OK" << std::endl;
+}
+
+void test_trace()
+{
+    std::cout << "[35] Test Trace... ";
+
+    // Istogramma: valori esatti fino a 255, poi errore relativo inferiore a 1/128
+    latency_histogram h;
+    assert(h.count() == 0 && h.percentile(50) == 0);
+    for (std::uint64_t v = 1; v <= 10000; ++v)
+    {
+        h.record(v);
+    }
+    assert(h.count() == 10000 && h.min() == 1 && h.max() == 10000 && h.mean() == 5000.5);
+    assert(h.percentile(50) >= 5000 && h.percentile(50) <= 5000 + 5000 / 128);
+    assert(h.percentile(99) >= 9900 && h.percentile(99) <= 9900 + 9900 / 128);
+    assert(h.percentile(100) == 10000 && h.percentile(0) == 1);
+
+    latency_histogram tail;
+    tail.record(200);
+    tail.record(latency_histogram::MAX_VALUE + 5);
+    assert(tail.percentile(50) == 200 && tail.max() == latency_histogram::MAX_VALUE);
+    h += tail;
+    assert(h.count() == 10002 && h.max() == latency_histogram::MAX_VALUE && h.percentile(100) == latency_histogram::MAX_VALUE);
+
+    // Registro: istogrammi per operazione e dimensione, buffer circolare di eventi
+    trace_registry &registry = trace_registry::instance();
+    registry.clear();
+    registry.set_event_limit(2);
+    for (int i = 0; i < 3; ++i)
+    {
+        trace_scope scope("test_operation", 8, i);
+    }
+    assert(registry.histogram("test_operation", 8).count() == 3 && registry.histogram("test_operation", 4).count() == 0);
+    const std::vector<trace_registry::event> events = registry.events();
+    assert(events.size() == 2 && events[0].elements == 1 && events[1].elements == 2 && registry.dropped() == 1);
+    assert(events[0].start <= events[1].start);
+
+    std::ostringstream summary, trace;
+    registry.write_summary(summary);
+    registry.write_chrome_trace(trace);
+    assert(summary.str().find("p99.9") != std::string::npos && summary.str().find("test_operation") != std::string::npos);
+    assert(trace.str().find("{\"traceEvents\":[") == 0 && trace.str().find("\"ph\":\"X\"") != std::string::npos);
+    assert(trace.str().find("\"elements\":2") != std::string::npos && trace.str().find("\"dropped\":1") != std::string::npos);
+
+    // Le operazioni dei set vengono misurate solo con SET_TRACING
+    registry.clear();
+    registry.set_event_limit(trace_registry::DEFAULT_EVENTS);
+    set<int, std::equal_to<int>> numbers;
+    numbers.add(1);
+    numbers.add(2);
+    assert(numbers.contains(2));
+#ifdef SET_TRACING
+    assert(registry.histogram("add", sizeof(int)).count() == 2 && registry.histogram("contains", sizeof(int)).count() == 1);
+#else
+    assert(registry.histogram("add", sizeof(int)).count() == 0 && registry.events().empty());
+#endif
+    registry.clear();
+
+    std::cout << "OK" << std::endl;
+}
+
 bool IsEven::operator()(int n) const
 {
     return (n % 2) == 0;
@@ -379,4 +2595,79 @@ bool IsEven::operator()(int n) const
 bool IsLongString::operator()(const std::string &s)
 {
     return s.length() > 3;
-}
\ No newline at end of file
+}
+
+std::size_t ConstantHash::operator()(const std::string &) const
+{
+    return 42;
+}
+
+std::atomic<int> Tracked::alive{0};
+std::atomic<int> Tracked::defaults{0};
+std::atomic<int> Tracked::copies_left{-1};
+
+Tracked::Tracked() : value(0)
+{
+    ++alive;
+    ++defaults;
+}
+
+Tracked::Tracked(int v) : value(v)
+{
+    ++alive;
+}
+
+Tracked::Tracked(const Tracked &other) : value(other.value)
+{
+    if (copies_left == 0)
+    {
+        throw std::runtime_error("Copy failed!");
+    }
+    if (copies_left > 0)
+    {
+        --copies_left;
+    }
+    ++alive;
+}
+
+Tracked::Tracked(Tracked &&other) noexcept : value(other.value)
+{
+    ++alive;
+}
+
+Tracked &Tracked::operator=(const Tracked &other)
+{
+    value = other.value;
+    return *this;
+}
+
+Tracked::~Tracked()
+{
+    --alive;
+}
+
+bool Tracked::operator==(const Tracked &other) const
+{
+    return value == other.value;
+}
+
+std::size_t TrackedHash::operator()(const Tracked &t) const
+{
+    return std::hash<int>()(t.value);
+}
+
+std::atomic<int> CountingEql::calls{0};
+
+bool CountingEql::operator()(const std::string &a, const std::string &b) const
+{
+    ++calls;
+    return a == b;
+}
+
+std::atomic<int> CountingHash::calls{0};
+
+std::size_t CountingHash::operator()(const std::string &s) const
+{
+    ++calls;
+    return std::hash<std::string>()(s);
+}
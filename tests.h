@@ -10,6 +10,7 @@
 #define TESTS_H
 
 #include <string>
+#include <atomic> // std::atomic
 
 /**
  * @brief funzione principale di test
@@ -98,6 +99,220 @@ void test_stress_reallocation();
  */
 void test_files();
 
+/**
+ * @brief test della classe static_set
+ *
+ * Viene testata la costruzione a tempo di compilazione di static_set su interi e punti,
+ * anche con la tabella hash.
+ * Vengono testate la conversione a set e gli operatori di unione e intersezione con set.
+ */
+void test_static_set();
+
+/**
+ * @brief test del filtro di Bloom
+ *
+ * Viene testata la classe bloom_filter e la sua probabilità di falso positivo.
+ * Viene testato il filtro integrato in set: contains, add, remove, operatore == e intersezione.
+ */
+void test_bloom_filter();
+
+/**
+ * @brief test della classe journaled_set
+ *
+ * Vengono testate la registrazione delle operazioni nel journal, la rilettura da snapshot e journal,
+ * la compattazione e la gestione di un'operazione scritta a metà.
+ */
+void test_journal();
+
+/**
+ * @brief test del formato compresso
+ *
+ * Vengono testate save e load nel formato compresso su interi e punti, su più blocchi.
+ * Viene verificato che il file compresso sia più piccolo di quello testuale e che un file non valido venga rifiutato.
+ */
+void test_packed_format();
+
+/**
+ * @brief test di save e load asincrone
+ *
+ * Vengono testate save_async e load_async, la modifica del set durante il salvataggio,
+ * la propagazione degli errori e l'annullamento attraverso il future.
+ */
+void test_async_io();
+
+/**
+ * @brief test di union_all e intersect_all
+ *
+ * Vengono testate l'unione e l'intersezione di una sequenza di set, con e senza funtore di hash,
+ * su uno e più thread, confrontandole con gli operatori + e -.
+ * Viene testato anche il metodo reserve.
+ */
+void test_union_intersect_all();
+
+/**
+ * @brief test della condivisione copy-on-write
+ *
+ * Viene verificato che copie e assegnamenti condividano la memoria fino alla prima modifica,
+ * che le modifiche non siano visibili nelle altre copie e che più thread possano
+ * copiare e modificare contemporaneamente set che condividono la memoria.
+ */
+void test_copy_on_write();
+
+/**
+ * @brief test dell'insieme persistente
+ *
+ * Viene verificato che add e remove creino nuove versioni senza modificare le precedenti,
+ * insieme a ricerca, iterazione, stampa, filtraggio, conversioni da e verso set
+ * e gestione degli elementi con hash identico.
+ */
+void test_immutable_set();
+
+/**
+ * @brief test dell'insieme di stringhe con arena
+ *
+ * Vengono verificate aggiunta, rimozione e ricerca con std::string_view e stringhe C,
+ * la crescita dell'arena, il filtraggio e il salvataggio compatibile con quello di set.
+ */
+void test_string_set();
+
+/**
+ * @brief test delle misure di somiglianza
+ *
+ * Vengono confrontati intersection_size, union_size e jaccard con i risultati di operator- e operator+,
+ * verificati is_subset e is_disjoint e la stima di Jaccard delle firme MinHash.
+ */
+void test_similarity();
+
+/**
+ * @brief test dello sketch HyperLogLog
+ *
+ * Vengono verificati la precisione della stima, l'unione di sketch costruiti in thread diversi,
+ * la costruzione da set e da sequenza e il salvataggio su file.
+ */
+void test_hyperloglog();
+
+/**
+ * @brief test dell'iteratore ad accesso casuale
+ *
+ * Vengono verificate l'aritmetica e il confronto degli iteratori, l'accesso tramite data() e std::span
+ * e l'uso di set con gli algoritmi della libreria standard, anche con le politiche
+ * std::execution::par e par_unseq se Intel TBB è disponibile (vedi la variabile TBB del Makefile).
+ */
+void test_random_access();
+
+/**
+ * @brief test della costruzione parallela
+ *
+ * Viene verificato che il costruttore parallelo produca gli stessi elementi, nello stesso ordine,
+ * del costruttore da sequenza, anche con conversione di tipo e iteratori non ad accesso casuale.
+ */
+void test_parallel_construction();
+
+/**
+ * @brief test della lettura in streaming
+ *
+ * Viene verificato che set_reader restituisca gli elementi di un file prodotto da save uno alla volta,
+ * utilizzabile con gli algoritmi della libreria standard, con il costruttore da sequenza di set e con filter_out,
+ * e che segnali i file troncati.
+ */
+void test_set_reader();
+
+/**
+ * @brief test della rappresentazione adattiva
+ *
+ * Viene verificato che un set con funtore di hash crei l'indice oltre la soglia e lo elimini sotto metà soglia,
+ * mantenendo ordine, accesso diretto e condivisione copy-on-write, e che la soglia sia regolabile.
+ */
+void test_adaptive_layout();
+
+/**
+ * @brief test della gestione della memoria degli elementi
+ *
+ * Viene verificato che le celle libere dell'array non vengano costruite, che ogni elemento costruito venga distrutto,
+ * che i ridimensionamenti e le rimozioni mantengano l'ordine spostando gli elementi e che un'eccezione
+ * durante la copia lasci il set invariato.
+ */
+void test_relocation();
+
+/**
+ * @brief test delle ricerche e aggiunte a lotti
+ *
+ * Viene verificato che contains_many e add_many diano gli stessi risultati di contains e add,
+ * con output su sequenze di bool e su maschere di bit, con array, filtro di Bloom e indice hash.
+ */
+void test_batch_membership();
+
+/**
+ * @brief test della cache degli hash
+ *
+ * Viene verificato che con la cache Eql venga chiamato solo sugli elementi con lo stesso hash,
+ * che Hash venga chiamato una sola volta per elemento anche ricostruendo l'indice o combinando set con ==, - e +,
+ * e che la cache segua copie, rimozioni e copy-on-write.
+ */
+void test_hash_cache();
+
+/**
+ * @brief test del salvataggio e della lettura paralleli
+ *
+ * Viene verificato che save_parallel produca gli stessi byte di save e che load_parallel legga
+ * gli stessi elementi, nello stesso ordine, di load, anche con file divisi in più blocchi o con elementi ripetuti.
+ */
+void test_parallel_io();
+
+/**
+ * @brief test della misura e della compattazione della memoria
+ *
+ * Viene verificato che memory_usage separi elementi, celle libere, strutture di ricerca e memoria degli elementi,
+ * che memory_report conti una sola volta la memoria condivisa e che compact liberi le celle libere
+ * mantenendo gli stessi elementi.
+ */
+void test_memory_usage();
+
+/**
+ * @brief test dell'insieme in memoria esterna
+ *
+ * Viene verificato che external_set scriva il buffer su disco al raggiungimento del budget, fonda le run
+ * in background, trovi gli elementi in buffer e run, li percorra in ordine senza duplicati,
+ * calcoli unione e intersezione in streaming e cancelli i propri file alla distruzione.
+ */
+void test_external_set();
+
+/**
+ * @brief test dell'insieme in memoria condivisa
+ *
+ * Viene verificato che uno shared_set pubblicato sia leggibile da un altro collegamento e da un processo figlio
+ * senza copie, che la pubblicazione di una nuova versione non alteri i collegamenti esistenti fino a refresh
+ * e che formato e tipo degli elementi vengano controllati al collegamento.
+ */
+void test_shared_set();
+
+/**
+ * @brief test dell'insieme di posizioni in un array esterno
+ *
+ * Viene verificato che view_set deduplichi un array di record per chiave senza copiarli,
+ * che ricerca, iterazione e operazioni insiemistiche usino gli elementi dell'array
+ * e che materialize produca un set equivalente.
+ */
+void test_view_set();
+
+/**
+ * @brief test di differenza e unione tra file di set
+ *
+ * Viene verificato che sort_file ordini un file con un ordinamento esterno a più passate,
+ * che diff_files e merge_files producano file nel formato di save con gli elementi attesi,
+ * sia da file ordinati sia da file non ordinati, e che i file temporanei vengano cancellati.
+ */
+void test_sorted_files();
+
+/**
+ * @brief test del tracciamento delle operazioni
+ *
+ * Viene verificato che latency_histogram calcoli percentili con errore relativo limitato,
+ * che trace_registry raccolga istogrammi ed eventi e li esporti come riepilogo e come traccia di Chrome,
+ * e che le operazioni dei set vengano misurate solo compilando con SET_TRACING.
+ */
+void test_trace();
+
 /**
  * @brief implementazione dell'operatore () del funtore IsEven
  *
@@ -129,4 +344,92 @@ struct IsLongString
     bool operator()(const std::string &s);
 };
 
+/**
+ * @brief implementazione dell'operatore () del funtore ConstantHash
+ *
+ * Viene implementato l'operatore () del funtore ConstantHash.
+ * Ritorna lo stesso hash per ogni stringa, per verificare la gestione delle collisioni.
+ *
+ * @return sempre 42
+ */
+struct ConstantHash
+{
+    std::size_t operator()(const std::string &) const;
+};
+
+/**
+ * @brief tipo che conta le proprie istanze
+ *
+ * Tiene traccia delle istanze vive e delle costruzioni di default,
+ * e può lanciare un'eccezione dopo un numero prefissato di copie.
+ * Lo spostamento non lancia eccezioni.
+ */
+struct Tracked
+{
+    int value; ///< valore dell'istanza
+
+    static std::atomic<int> alive;       ///< numero di istanze vive, aggiornato anche dalla costruzione parallela
+    static std::atomic<int> defaults;    ///< numero di costruzioni di default
+    static std::atomic<int> copies_left; ///< copie consentite prima di lanciare std::runtime_error, negativo se illimitate
+
+    Tracked();
+    Tracked(int v);
+    Tracked(const Tracked &other);
+    Tracked(Tracked &&other) noexcept;
+    Tracked &operator=(const Tracked &other);
+    ~Tracked();
+
+    bool operator==(const Tracked &other) const;
+};
+
+/**
+ * @brief implementazione dell'operatore () del funtore TrackedHash
+ *
+ * Viene implementato l'operatore () del funtore TrackedHash.
+ * Ritorna l'hash del valore di un oggetto Tracked.
+ *
+ * @param t oggetto di cui calcolare l'hash
+ *
+ * @return hash di t.value
+ */
+struct TrackedHash
+{
+    std::size_t operator()(const Tracked &t) const;
+};
+
+/**
+ * @brief implementazione dell'operatore () del funtore CountingEql
+ *
+ * Viene implementato l'operatore () del funtore CountingEql.
+ * Confronta due stringhe contando le chiamate.
+ *
+ * @param a prima stringa
+ * @param b seconda stringa
+ *
+ * @return true se le stringhe sono uguali, false altrimenti
+ */
+struct CountingEql
+{
+    static std::atomic<int> calls; ///< numero di confronti eseguiti
+
+    bool operator()(const std::string &a, const std::string &b) const;
+};
+
+/**
+ * @brief implementazione dell'operatore () del funtore CountingHash
+ *
+ * Viene implementato l'operatore () del funtore CountingHash.
+ * Calcola l'hash di una stringa contando le chiamate.
+ *
+ * @param s stringa di cui calcolare l'hash
+ *
+ * @return hash di s
+ */
+struct CountingHash
+{
+    static std::atomic<int> calls; ///< numero di hash calcolati
+
+    std::size_t operator()(const std::string &s) const;
+};
+
 #endif
\ No newline at end of file
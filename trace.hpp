@@ -0,0 +1,525 @@
+/**
+ * @file trace.hpp
+ *
+ * @brief file di dichiarazione e definizione del tracciamento delle operazioni sui set
+ *
+ * File di dichiarazione e definizione del tracciamento facoltativo delle operazioni sui set:
+ * - la classe latency_histogram, un istogramma delle latenze a precisione relativa costante (in stile HDR)
+ * - la classe trace_registry, che raccoglie un istogramma per operazione e dimensione degli elementi
+ *   e gli ultimi eventi, e li esporta come riepilogo testuale o come JSON di eventi per i visualizzatori di tracce di Chrome
+ * - la classe trace_scope, che misura la durata del blocco in cui è dichiarata
+ * - la macro SET_TRACE_SCOPE, usata dai metodi di set
+ *
+ * Il tracciamento è disabilitato di default: SET_TRACE_SCOPE si espande in un'istruzione vuota
+ * e le operazioni dei set non contengono alcun codice aggiuntivo.
+ * Si abilita compilando con -DSET_TRACING.
+ */
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>    // std::chrono::steady_clock
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <functional> // std::hash
+#include <iomanip>   // std::setw
+#include <map>       // std::map
+#include <mutex>     // std::mutex, std::unique_lock
+#include <ostream>   // ostream
+#include <string>    // std::string
+#include <thread>    // std::this_thread::get_id
+#include <utility>   // std::pair
+#include <vector>    // std::vector
+
+/**
+ * @brief istogramma delle latenze
+ *
+ * Registra valori interi (durate in nanosecondi) con errore relativo inferiore a 1/SUB_BUCKETS:
+ * i valori minori di 2 * SUB_BUCKETS hanno un contatore ciascuno, quelli maggiori vengono raggruppati
+ * per potenza di 2 e divisi in SUB_BUCKETS intervalli uguali, come in HdrHistogram.
+ * La memoria è fissa e la registrazione costa O(1), indipendentemente dal numero di valori.
+ * I valori oltre MAX_VALUE vengono registrati come MAX_VALUE.
+ */
+class latency_histogram
+{
+public:
+    static const unsigned int SUB_BITS = 7;                        ///< bit significativi conservati per ogni valore
+    static const unsigned int SUB_BUCKETS = 1u << SUB_BITS;        ///< intervalli per ogni potenza di 2
+    static const unsigned int MAX_BITS = 40;                       ///< bit del massimo valore registrabile
+    static const std::uint64_t MAX_VALUE = (1ULL << MAX_BITS) - 1; ///< massimo valore registrabile, circa 18 minuti in ns
+
+private:
+    static const unsigned int BUCKETS = 2 * SUB_BUCKETS + (MAX_BITS - SUB_BITS - 1) * SUB_BUCKETS; ///< numero di contatori
+
+    std::vector<std::uint64_t> _counts; ///< contatori degli intervalli
+    std::uint64_t _total;               ///< numero di valori registrati
+    std::uint64_t _min;                 ///< valore minimo registrato
+    std::uint64_t _max;                 ///< valore massimo registrato
+    long double _sum;                   ///< somma dei valori registrati
+
+public:
+    /**
+     * @brief costruttore di default
+     *
+     * Crea un istogramma vuoto.
+     *
+     * @throws std::bad_alloc se l'allocazione dei contatori fallisce
+     */
+    latency_histogram() : _counts(BUCKETS, 0), _total(0), _min(0), _max(0), _sum(0) {}
+
+    /**
+     * @brief registra un valore
+     *
+     * @param value valore da registrare
+     */
+    void record(std::uint64_t value)
+    {
+        value = value > MAX_VALUE ? MAX_VALUE : value;
+
+        ++_counts[bucket_of(value)];
+        _min = _total == 0 || value < _min ? value : _min;
+        _max = value > _max ? value : _max;
+        _sum += static_cast<long double>(value);
+        ++_total;
+    }
+
+    /**
+     * @brief numero di valori registrati
+     *
+     * @return numero di chiamate a record
+     */
+    std::uint64_t count() const
+    {
+        return _total;
+    }
+
+    /**
+     * @brief valore minimo
+     *
+     * @return il minimo valore registrato, 0 se l'istogramma è vuoto
+     */
+    std::uint64_t min() const
+    {
+        return _min;
+    }
+
+    /**
+     * @brief valore massimo
+     *
+     * @return il massimo valore registrato, 0 se l'istogramma è vuoto
+     */
+    std::uint64_t max() const
+    {
+        return _max;
+    }
+
+    /**
+     * @brief media dei valori
+     *
+     * @return la media esatta dei valori registrati, 0 se l'istogramma è vuoto
+     */
+    double mean() const
+    {
+        return _total == 0 ? 0.0 : static_cast<double>(_sum / static_cast<long double>(_total));
+    }
+
+    /**
+     * @brief percentile
+     *
+     * Il risultato è il limite superiore dell'intervallo che contiene il percentile,
+     * quindi sovrastima il valore esatto di meno di 1/SUB_BUCKETS, e non supera mai il massimo registrato.
+     *
+     * @param p percentile, tra 0 e 100
+     *
+     * @return il più piccolo valore non minore del p per cento dei valori registrati, 0 se l'istogramma è vuoto
+     */
+    std::uint64_t percentile(double p) const
+    {
+        if (_total == 0)
+        {
+            return 0;
+        }
+
+        p = p < 0 ? 0 : (p > 100 ? 100 : p);
+        std::uint64_t rank = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(_total) + 0.5);
+        rank = rank < 1 ? 1 : (rank > _total ? _total : rank);
+
+        std::uint64_t seen = 0;
+        for (unsigned int i = 0; i < BUCKETS; ++i)
+        {
+            seen += _counts[i];
+            if (seen >= rank)
+            {
+                const std::uint64_t high = highest_in(i);
+                return high < _max ? (high > _min ? high : _min) : _max;
+            }
+        }
+
+        return _max;
+    }
+
+    /**
+     * @brief somma un altro istogramma
+     *
+     * @param other istogramma da sommare
+     *
+     * @return reference all'istogramma modificato
+     */
+    latency_histogram &operator+=(const latency_histogram &other)
+    {
+        if (other._total == 0)
+        {
+            return *this;
+        }
+
+        for (unsigned int i = 0; i < BUCKETS; ++i)
+        {
+            _counts[i] += other._counts[i];
+        }
+        _min = _total == 0 || other._min < _min ? other._min : _min;
+        _max = other._max > _max ? other._max : _max;
+        _sum += other._sum;
+        _total += other._total;
+
+        return *this;
+    }
+
+private:
+    /**
+     * @brief intervallo di un valore
+     *
+     * @param value valore, al più MAX_VALUE
+     *
+     * @return indice del contatore del valore
+     */
+    static unsigned int bucket_of(std::uint64_t value)
+    {
+        if (value < 2 * SUB_BUCKETS)
+        {
+            return static_cast<unsigned int>(value);
+        }
+
+        const unsigned int msb = 63 - static_cast<unsigned int>(__builtin_clzll(value));
+        const unsigned int shift = msb - SUB_BITS;
+        return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + static_cast<unsigned int>((value >> shift) - SUB_BUCKETS);
+    }
+
+    /**
+     * @brief massimo valore di un intervallo
+     *
+     * @param bucket indice del contatore
+     *
+     * @return il più grande valore che viene registrato nel contatore
+     */
+    static std::uint64_t highest_in(unsigned int bucket)
+    {
+        if (bucket < 2 * SUB_BUCKETS)
+        {
+            return bucket;
+        }
+
+        const unsigned int shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+        const std::uint64_t mantissa = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+}; // latency_histogram
+
+/**
+ * @brief registro delle misure
+ *
+ * Raccoglie un latency_histogram per ogni coppia (operazione, dimensione degli elementi)
+ * e gli ultimi eventi in un buffer circolare di dimensione limitata, per l'esportazione come traccia.
+ * Tutti i metodi possono essere chiamati contemporaneamente da più thread: le registrazioni sono serializzate da un mutex,
+ * quindi con il tracciamento abilitato le operazioni molto brevi eseguite in parallelo rallentano.
+ */
+class trace_registry
+{
+public:
+    static const std::size_t DEFAULT_EVENTS = 1 << 16; ///< eventi conservati di default
+
+    /**
+     * @brief evento registrato
+     */
+    struct event
+    {
+        const char *operation;      ///< nome dell'operazione, stringa statica
+        unsigned int element_size;  ///< sizeof degli elementi
+        unsigned long long elements; ///< elementi coinvolti, di solito la dimensione del set
+        std::uint64_t start;        ///< inizio in ns dalla creazione del registro
+        std::uint64_t duration;     ///< durata in ns
+        std::size_t thread;         ///< identificativo del thread
+    };
+
+private:
+    typedef std::chrono::steady_clock clock;
+    typedef std::pair<std::string, unsigned int> key; ///< operazione e dimensione degli elementi
+
+    mutable std::mutex _mutex;                     ///< mutex a protezione di tutti i campi
+    clock::time_point _epoch;                      ///< istante di creazione del registro
+    std::map<key, latency_histogram> _histograms;  ///< istogrammi per operazione e dimensione degli elementi
+    std::vector<event> _events;                    ///< buffer circolare degli ultimi eventi
+    std::size_t _next;                             ///< posizione del prossimo evento nel buffer
+    std::size_t _limit;                            ///< numero massimo di eventi conservati
+    unsigned long long _dropped;                   ///< eventi sovrascritti
+
+    /**
+     * @brief costruttore privato
+     */
+    trace_registry() : _epoch(clock::now()), _next(0), _limit(DEFAULT_EVENTS), _dropped(0) {}
+
+public:
+    /**
+     * @brief istanza condivisa
+     *
+     * @return il registro del processo, creato alla prima chiamata
+     */
+    static trace_registry &instance()
+    {
+        static trace_registry registry;
+        return registry;
+    }
+
+    trace_registry(const trace_registry &other) = delete;
+
+    trace_registry &operator=(const trace_registry &other) = delete;
+
+    /**
+     * @brief registra un'operazione
+     *
+     * @param operation nome dell'operazione, stringa statica
+     * @param element_size sizeof degli elementi
+     * @param elements elementi coinvolti
+     * @param start istante di inizio
+     * @param stop istante di fine
+     *
+     * @throws std::bad_alloc se l'allocazione di un istogramma o del buffer fallisce
+     */
+    void record(const char *operation, unsigned int element_size, unsigned long long elements, clock::time_point start,
+                clock::time_point stop)
+    {
+        const std::uint64_t duration = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        const std::size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        const std::uint64_t offset = start < _epoch ? 0 : static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start - _epoch).count());
+
+        _histograms[key(operation, element_size)].record(duration);
+
+        if (_limit == 0)
+        {
+            ++_dropped;
+            return;
+        }
+
+        const event e = {operation, element_size, elements, offset, duration, thread};
+        if (_events.size() < _limit)
+        {
+            _events.push_back(e);
+        }
+        else
+        {
+            _events[_next] = e;
+            ++_dropped;
+        }
+        _next = (_next + 1) % _limit;
+    }
+
+    /**
+     * @brief cambia il numero di eventi conservati
+     *
+     * Gli eventi già registrati vengono scartati; gli istogrammi non cambiano.
+     *
+     * @param limit numero massimo di eventi, 0 per conservare solo gli istogrammi
+     */
+    void set_event_limit(std::size_t limit)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _limit = limit;
+        _events.clear();
+        _events.shrink_to_fit();
+        _next = 0;
+    }
+
+    /**
+     * @brief azzera istogrammi ed eventi
+     */
+    void clear()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _histograms.clear();
+        _events.clear();
+        _next = 0;
+        _dropped = 0;
+    }
+
+    /**
+     * @brief istogramma di un'operazione
+     *
+     * @param operation nome dell'operazione
+     * @param element_size sizeof degli elementi
+     *
+     * @return una copia dell'istogramma, vuoto se l'operazione non è mai stata registrata
+     */
+    latency_histogram histogram(const std::string &operation, unsigned int element_size) const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        const auto it = _histograms.find(key(operation, element_size));
+        return it == _histograms.end() ? latency_histogram() : it->second;
+    }
+
+    /**
+     * @brief eventi conservati
+     *
+     * @return gli eventi conservati, dal più vecchio al più recente
+     */
+    std::vector<event> events() const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return ordered_events();
+    }
+
+    /**
+     * @brief eventi sovrascritti
+     *
+     * @return numero di eventi registrati negli istogrammi ma non più conservati nel buffer
+     */
+    unsigned long long dropped() const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _dropped;
+    }
+
+    /**
+     * @brief stampa il riepilogo degli istogrammi
+     *
+     * Stampa una riga per ogni operazione e dimensione degli elementi, con numero di chiamate
+     * e latenze in ns: minimo, media, percentili 50, 90, 99 e 99.9, massimo.
+     *
+     * @param os stream di output
+     */
+    void write_summary(std::ostream &os) const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        os << std::setw(16) << "operation" << std::setw(6) << "size" << std::setw(12) << "count" << std::setw(12) << "min"
+           << std::setw(12) << "mean" << std::setw(12) << "p50" << std::setw(12) << "p90" << std::setw(12) << "p99"
+           << std::setw(12) << "p99.9" << std::setw(12) << "max" << '\n';
+
+        for (const auto &entry : _histograms)
+        {
+            const latency_histogram &h = entry.second;
+            os << std::setw(16) << entry.first.first << std::setw(6) << entry.first.second << std::setw(12) << h.count()
+               << std::setw(12) << h.min() << std::setw(12) << static_cast<std::uint64_t>(h.mean()) << std::setw(12)
+               << h.percentile(50) << std::setw(12) << h.percentile(90) << std::setw(12) << h.percentile(99) << std::setw(12)
+               << h.percentile(99.9) << std::setw(12) << h.max() << '\n';
+        }
+    }
+
+    /**
+     * @brief esporta gli eventi come traccia di Chrome
+     *
+     * Scrive un documento JSON nel formato Trace Event, leggibile da chrome://tracing e da Perfetto:
+     * ogni evento conservato diventa un evento completo ("ph":"X") con tempi in microsecondi,
+     * e negli argomenti la dimensione degli elementi e il numero di elementi coinvolti.
+     *
+     * @param os stream di output
+     */
+    void write_chrome_trace(std::ostream &os) const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        os << "{\"traceEvents\":[";
+        bool first = true;
+        for (const event &e : ordered_events())
+        {
+            os << (first ? "\n" : ",\n") << "{\"name\":\"" << e.operation << "\",\"cat\":\"set\",\"ph\":\"X\",\"ts\":"
+               << e.start / 1000 << '.' << std::setw(3) << std::setfill('0') << e.start % 1000 << std::setfill(' ')
+               << ",\"dur\":" << e.duration / 1000 << '.' << std::setw(3) << std::setfill('0') << e.duration % 1000
+               << std::setfill(' ') << ",\"pid\":1,\"tid\":" << e.thread % 1000000 << ",\"args\":{\"element_size\":"
+               << e.element_size << ",\"elements\":" << e.elements << "}}";
+            first = false;
+        }
+        os << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":" << _dropped << "}}\n";
+    }
+
+private:
+    /**
+     * @brief eventi in ordine di registrazione
+     *
+     * Va chiamato con _mutex acquisito.
+     *
+     * @return gli eventi conservati, dal più vecchio al più recente
+     */
+    std::vector<event> ordered_events() const
+    {
+        if (_events.size() < _limit)
+        {
+            return _events;
+        }
+
+        std::vector<event> ordered(_events.begin() + static_cast<std::ptrdiff_t>(_next), _events.end());
+        ordered.insert(ordered.end(), _events.begin(), _events.begin() + static_cast<std::ptrdiff_t>(_next));
+        return ordered;
+    }
+}; // trace_registry
+
+/**
+ * @brief misura della durata di un blocco
+ *
+ * Registra in trace_registry la durata tra la costruzione e la distruzione,
+ * anche quando il blocco termina con un'eccezione.
+ */
+class trace_scope
+{
+private:
+    const char *_operation;                        ///< nome dell'operazione, stringa statica
+    unsigned int _element_size;                    ///< sizeof degli elementi
+    unsigned long long _elements;                  ///< elementi coinvolti
+    std::chrono::steady_clock::time_point _start; ///< istante di inizio
+
+public:
+    /**
+     * @brief costruttore
+     *
+     * @param operation nome dell'operazione, stringa statica
+     * @param element_size sizeof degli elementi
+     * @param elements elementi coinvolti
+     */
+    trace_scope(const char *operation, unsigned int element_size, unsigned long long elements)
+        : _operation(operation), _element_size(element_size), _elements(elements), _start(std::chrono::steady_clock::now())
+    {
+    }
+
+    trace_scope(const trace_scope &other) = delete;
+
+    trace_scope &operator=(const trace_scope &other) = delete;
+
+    /**
+     * @brief metodo distruttore
+     *
+     * Registra la misura; un errore di allocazione durante la registrazione fa perdere solo questa misura.
+     */
+    ~trace_scope()
+    {
+        try
+        {
+            trace_registry::instance().record(_operation, _element_size, _elements, _start, std::chrono::steady_clock::now());
+        }
+        catch (...)
+        {
+        }
+    }
+}; // trace_scope
+
+/**
+ * @brief misura il blocco corrente come operazione operation su elementi di tipo type
+ *
+ * Con SET_TRACING definita dichiara un trace_scope, altrimenti non genera alcun codice
+ * e gli argomenti non vengono valutati.
+ */
+#ifdef SET_TRACING
+#define SET_TRACE_SCOPE(operation, type, elements) trace_scope set_trace_scope_(operation, sizeof(type), (elements))
+#else
+#define SET_TRACE_SCOPE(operation, type, elements) ((void)0)
+#endif
+
+#endif
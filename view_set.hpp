@@ -0,0 +1,576 @@
+/**
+ * @file view_set.hpp
+ *
+ * @brief file di dichiarazione e definizione della classe view_set
+ *
+ * File di dichiarazione e definizione della classe templata view_set,
+ * un insieme che non possiede i propri elementi ma memorizza solo la loro posizione in un array del chiamante.
+ * Contiene anche le funzioni globali per:
+ * - scrittura su stream
+ * - filtraggio
+ * - unione insiemistica
+ */
+#ifndef VIEW_SET_HPP
+#define VIEW_SET_HPP
+
+#include <cstddef>     // std::ptrdiff_t, std::size_t
+#include <cstdint>     // std::uint32_t
+#include <iterator>    // std::forward_iterator_tag
+#include <ostream>     // ostream
+#include <span>        // std::span
+#include <stdexcept>   // std::out_of_range, std::invalid_argument, std::length_error
+#include <type_traits> // std::invoke_result_t, std::decay_t
+#include <vector>      // std::vector
+#include "hash_index.hpp"
+#include "set.hpp"
+
+/**
+ * @brief classe view_set che rappresenta un insieme di posizioni in un array esterno
+ *
+ * La classe view_set rappresenta un insieme senza duplicati di elementi di un array posseduto dal chiamante,
+ * passato come std::span<const T>. Per ogni elemento vengono memorizzati solo la sua posizione nell'array
+ * e, se è disponibile un funtore di hash, una cella dell'indice hash: deduplicare N record di grandi dimensioni
+ * richiede quindi O(N) piccoli indici invece di una copia dei record.
+ *
+ * Due elementi sono considerati uguali se hanno chiavi uguali. È templata su quattro tipi:
+ * - T: tipo degli elementi dell'array
+ * - Key: funtore di proiezione che dato un elemento ritorna la sua chiave, per valore o per reference
+ * - Eql: funtore di confronto tra due chiavi
+ * - Hash: funtore di hash delle chiavi coerente con Eql, facoltativo; senza la ricerca è lineare
+ *
+ * L'array deve restare valido e invariato finché il view_set viene usato.
+ * Le operazioni insiemistiche sono definite solo tra view_set sullo stesso array.
+ * Gli elementi possono essere copiati in un set indipendente dall'array con materialize.
+ */
+template <typename T, typename Key, typename Eql, typename Hash = no_hash>
+class view_set
+{
+public:
+    typedef std::decay_t<std::invoke_result_t<Key, const T &>> key_type; ///< tipo delle chiavi
+
+private:
+    std::span<const T> _data;                    ///< array degli elementi, posseduto dal chiamante
+    std::vector<unsigned int> _positions;        ///< posizioni in _data degli elementi, in ordine di inserimento
+    hash_index<key_type, Eql, Hash> _index;      ///< indice hash su _positions, vuoto senza funtore di hash
+
+    Key _key; ///< istanza del funtore di proiezione
+    Eql _eql; ///< istanza del funtore di confronto
+
+public:
+    /**
+     * @brief costruttore
+     *
+     * Crea un insieme vuoto sull'array data.
+     *
+     * @param data array degli elementi, che deve restare valido finché il view_set viene usato
+     */
+    explicit view_set(std::span<const T> data) : _data(data) {}
+
+    /**
+     * @brief aggiunge un elemento
+     *
+     * Aggiunge l'elemento in posizione position dell'array, se nessun elemento con la stessa chiave è già presente.
+     * In caso di errore l'insieme rimane invariato.
+     *
+     * @param position posizione dell'elemento nell'array
+     *
+     * @return true se l'elemento è stato aggiunto, false se era già presente un elemento con la stessa chiave
+     *
+     * @throw std::out_of_range se position non è una posizione dell'array
+     * @throws std::bad_alloc se l'allocazione delle posizioni o dell'indice fallisce
+     * @throws ... eventuali eccezioni lanciate da Key, Eql o Hash
+     */
+    bool add(unsigned int position)
+    {
+        if (position >= _data.size())
+        {
+            throw std::out_of_range("Index out of range!");
+        }
+
+        const key_type &key = _key(_data[position]);
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            const std::uint32_t h = _index.hash_of(key);
+            if (_index.find(key, h, getter()) != NOT_FOUND)
+            {
+                return false;
+            }
+
+            _positions.push_back(position);
+            try
+            {
+                _index.insert(static_cast<unsigned int>(_positions.size() - 1), h);
+            }
+            catch (...)
+            {
+                _positions.pop_back();
+                throw;
+            }
+        }
+        else
+        {
+            if (find(key) != NOT_FOUND)
+            {
+                return false;
+            }
+
+            _positions.push_back(position);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief aggiunge tutti gli elementi dell'array
+     *
+     * Aggiunge gli elementi dell'array in ordine, tenendo per ogni chiave il primo.
+     * Le posizioni e l'indice vengono allocati una sola volta.
+     *
+     * @throws std::length_error se l'array ha più elementi di quante posizioni a 32 bit possano indicare
+     * @throws std::bad_alloc se l'allocazione delle posizioni o dell'indice fallisce
+     * @throws ... eventuali eccezioni lanciate da Key, Eql o Hash
+     */
+    void add_all()
+    {
+        if (_data.size() >= NOT_FOUND)
+        {
+            throw std::length_error("Array too long!");
+        }
+
+        _positions.reserve(_positions.size() + _data.size());
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            _index.reserve(static_cast<unsigned int>(_positions.size() + _data.size()));
+        }
+
+        for (std::size_t i = 0; i < _data.size(); ++i)
+        {
+            add(static_cast<unsigned int>(i));
+        }
+    }
+
+    /**
+     * @brief verifica se un elemento è presente
+     *
+     * @param element elemento da cercare, anche non appartenente all'array
+     *
+     * @return true se è presente un elemento con la stessa chiave, false altrimenti
+     *
+     * @throws ... eventuali eccezioni lanciate da Key, Eql o Hash
+     */
+    bool contains(const T &element) const
+    {
+        return contains_key(_key(element));
+    }
+
+    /**
+     * @brief verifica se una chiave è presente
+     *
+     * @param key chiave da cercare
+     *
+     * @return true se è presente un elemento con chiave key, false altrimenti
+     *
+     * @throws ... eventuali eccezioni lanciate da Key, Eql o Hash
+     */
+    bool contains_key(const key_type &key) const
+    {
+        return find(key) != NOT_FOUND;
+    }
+
+    /**
+     * @brief numero di elementi
+     *
+     * @return numero di elementi dell'insieme
+     */
+    unsigned int size() const
+    {
+        return static_cast<unsigned int>(_positions.size());
+    }
+
+    /**
+     * @brief operatore [] di accesso agli elementi
+     *
+     * @param i indice dell'elemento nell'insieme, in ordine di inserimento
+     *
+     * @pre i < size()
+     *
+     * @return reference costante all'elemento nell'array
+     */
+    const T &operator[](unsigned int i) const
+    {
+        return _data[_positions[i]];
+    }
+
+    /**
+     * @brief posizione di un elemento nell'array
+     *
+     * @param i indice dell'elemento nell'insieme
+     *
+     * @pre i < size()
+     *
+     * @return la posizione nell'array dell'i-esimo elemento
+     */
+    unsigned int position(unsigned int i) const
+    {
+        return _positions[i];
+    }
+
+    /**
+     * @brief array degli elementi
+     *
+     * @return l'array su cui è costruito l'insieme
+     */
+    std::span<const T> data() const
+    {
+        return _data;
+    }
+
+    /**
+     * @brief copia gli elementi in un set
+     *
+     * Crea un set indipendente dall'array con una copia di ogni elemento, nell'ordine dell'insieme.
+     * Il set viene allocato una sola volta.
+     *
+     * @tparam SetEql funtore di confronto tra elementi del set, che deve considerare distinti elementi con chiavi diverse
+     * @tparam SetHash funtore di hash del set, facoltativo
+     *
+     * @return un set contenente una copia degli elementi
+     *
+     * @throws std::bad_alloc se l'allocazione del set fallisce
+     * @throws ... eventuali eccezioni lanciate dal costruttore di copia di T, da SetEql o da SetHash
+     */
+    template <typename SetEql, typename SetHash = no_hash>
+    set<T, SetEql, SetHash> materialize() const
+    {
+        set<T, SetEql, SetHash> result;
+        result.reserve(size());
+        for (unsigned int position : _positions)
+        {
+            result.add(_data[position]);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief operatore di intersezione tra due view_set
+     *
+     * Come per set, l'operatore di sottrazione calcola l'intersezione insiemistica:
+     * il risultato contiene gli elementi di questo insieme la cui chiave è presente in other.
+     * Questo metodo non altera lo stato della classe, in quanto viene creato un nuovo view_set.
+     *
+     * @param other secondo insieme da intersecare, sullo stesso array
+     *
+     * @return un view_set che corrisponde all'intersezione insiemistica tra i due insiemi
+     *
+     * @throw std::invalid_argument se i due insiemi non sono sullo stesso array
+     * @throws std::bad_alloc se l'allocazione del risultato fallisce
+     * @throws ... eventuali eccezioni lanciate da Key, Eql o Hash
+     */
+    view_set operator-(const view_set &other) const
+    {
+        check_same_data(other);
+
+        view_set result(_data);
+        for (unsigned int position : _positions)
+        {
+            if (other.contains_key(_key(_data[position])))
+            {
+                result.add(position);
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief unisce un altro view_set a questo
+     *
+     * Aggiunge gli elementi di other con chiavi non presenti.
+     * In caso di errore possono essere stati aggiunti solo alcuni elementi.
+     *
+     * @param other insieme da unire, sullo stesso array
+     *
+     * @return reference all'insieme modificato
+     *
+     * @throw std::invalid_argument se i due insiemi non sono sullo stesso array
+     * @throws std::bad_alloc se l'allocazione delle posizioni o dell'indice fallisce
+     * @throws ... eventuali eccezioni lanciate da Key, Eql o Hash
+     */
+    view_set &operator+=(const view_set &other)
+    {
+        check_same_data(other);
+
+        for (unsigned int position : other._positions)
+        {
+            add(position);
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief iteratore costante della classe view_set
+     *
+     * Percorre gli elementi nell'ordine dell'insieme, restituendo reference agli elementi dell'array.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        /**
+         * @brief costruttore di default
+         */
+        const_iterator() : _data(nullptr), _position(nullptr) {}
+
+        /**
+         * @brief operatore di dereferenziamento
+         *
+         * @return reference all'elemento nell'array
+         */
+        reference operator*() const
+        {
+            return _data[*_position];
+        }
+
+        /**
+         * @brief operatore freccia
+         *
+         * @return puntatore all'elemento nell'array
+         */
+        pointer operator->() const
+        {
+            return &_data[*_position];
+        }
+
+        /**
+         * @brief operatore di post-incremento
+         *
+         * @return l'iteratore prima dell'incremento
+         */
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++_position;
+            return tmp;
+        }
+
+        /**
+         * @brief operatore di pre-incremento
+         *
+         * @return l'iteratore incrementato
+         */
+        const_iterator &operator++()
+        {
+            ++_position;
+            return *this;
+        }
+
+        /**
+         * @brief operatore di uguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori puntano allo stesso elemento
+         */
+        bool operator==(const const_iterator &other) const
+        {
+            return _position == other._position;
+        }
+
+        /**
+         * @brief operatore di disuguaglianza
+         *
+         * @param other iteratore da confrontare
+         *
+         * @return true se i due iteratori puntano a elementi diversi
+         */
+        bool operator!=(const const_iterator &other) const
+        {
+            return _position != other._position;
+        }
+
+    private:
+        const T *_data;                 ///< array degli elementi
+        const unsigned int *_position;  ///< posizione corrente nell'elenco delle posizioni
+
+        friend class view_set;
+
+        /**
+         * @brief costruttore privato
+         *
+         * @param data array degli elementi
+         * @param position posizione nell'elenco delle posizioni
+         */
+        const_iterator(const T *data, const unsigned int *position) : _data(data), _position(position) {}
+    }; // const_iterator
+
+    typedef const_iterator iterator; // dichiarazione di iterator come alias di const_iterator
+
+    /**
+     * @brief iteratore di inizio
+     *
+     * @return iteratore al primo elemento
+     */
+    const_iterator begin() const
+    {
+        return const_iterator(_data.data(), _positions.data());
+    }
+
+    /**
+     * @brief iteratore di fine
+     *
+     * @return iteratore dopo l'ultimo elemento
+     */
+    const_iterator end() const
+    {
+        return const_iterator(_data.data(), _positions.data() + _positions.size());
+    }
+
+private:
+    static const unsigned int NOT_FOUND = hash_index<key_type, Eql, Hash>::NOT_FOUND; ///< elemento non presente
+
+    /**
+     * @brief funzione di accesso alle chiavi per l'indice hash
+     *
+     * @return una funzione che dato un indice dell'insieme ritorna la chiave dell'elemento corrispondente,
+     *         per reference se Key la ritorna per reference, così che i confronti non copino le chiavi
+     */
+    auto getter() const
+    {
+        return [this](unsigned int i) -> decltype(auto) { return _key(_data[_positions[i]]); };
+    }
+
+    /**
+     * @brief cerca una chiave
+     *
+     * @param key chiave da cercare
+     *
+     * @return indice nell'insieme dell'elemento con chiave key, NOT_FOUND se non è presente
+     */
+    unsigned int find(const key_type &key) const
+    {
+        if constexpr (is_hash_enabled<Hash>::value)
+        {
+            return _index.find(key, _index.hash_of(key), getter());
+        }
+        else
+        {
+            for (unsigned int i = 0; i < _positions.size(); ++i)
+            {
+                if (_eql(_key(_data[_positions[i]]), key))
+                {
+                    return i;
+                }
+            }
+
+            return NOT_FOUND;
+        }
+    }
+
+    /**
+     * @brief verifica che due insiemi siano sullo stesso array
+     *
+     * @param other insieme da verificare
+     *
+     * @throw std::invalid_argument se other è su un array diverso
+     */
+    void check_same_data(const view_set &other) const
+    {
+        if (other._data.data() != _data.data() || other._data.size() != _data.size())
+        {
+            throw std::invalid_argument("Views must share the same array!");
+        }
+    }
+}; // view_set
+
+/**
+ * @brief funzione globale per stampare un view_set su stream
+ *
+ * Stampa un view_set su stream nello stesso formato di set:
+ * - {e1, e2, ..., en}
+ *
+ * @param os stream di output su cui stampare
+ * @param s insieme da stampare
+ */
+template <typename T, typename Key, typename Eql, typename Hash>
+std::ostream &operator<<(std::ostream &os, const view_set<T, Key, Eql, Hash> &s)
+{
+    typename view_set<T, Key, Eql, Hash>::const_iterator i, ie;
+
+    i = s.begin();
+    ie = s.end();
+
+    os << "{";
+
+    while (i != ie)
+    {
+        os << *i;
+        i++;
+
+        if (i != ie)
+        {
+            os << ", ";
+        }
+    }
+
+    os << "}";
+
+    return os;
+}
+
+/**
+ * @brief funzione per filtrare un view_set
+ *
+ * Crea un nuovo view_set sullo stesso array che contiene solo gli elementi che rispettano pred.
+ * Gli elementi non vengono copiati.
+ *
+ * @param S insieme da filtrare
+ * @param pred predicato booleano che prende in input un oggetto di tipo T
+ *
+ * @return un view_set contenente tutti e soli gli elementi di S che rispettano pred
+ */
+template <typename T, typename Key, typename Eql, typename Hash, typename P>
+view_set<T, Key, Eql, Hash> filter_out(const view_set<T, Key, Eql, Hash> &S, P pred)
+{
+    view_set<T, Key, Eql, Hash> result(S.data());
+
+    for (unsigned int i = 0; i < S.size(); ++i)
+    {
+        if (pred(S[i]))
+        {
+            result.add(S.position(i));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief operatore di unione insiemistica
+ *
+ * Crea un view_set sullo stesso array che contiene gli elementi di left seguiti da quelli di right
+ * con chiavi non presenti in left.
+ *
+ * @param left insieme di sinistra
+ * @param right insieme di destra, sullo stesso array
+ *
+ * @return nuovo view_set contenente l'unione insiemistica dei due insiemi
+ *
+ * @throw std::invalid_argument se i due insiemi non sono sullo stesso array
+ */
+template <typename T, typename Key, typename Eql, typename Hash>
+view_set<T, Key, Eql, Hash> operator+(const view_set<T, Key, Eql, Hash> &left, const view_set<T, Key, Eql, Hash> &right)
+{
+    view_set<T, Key, Eql, Hash> result = left;
+    result += right;
+
+    return result;
+}
+
+#endif